@@ -49,6 +49,10 @@ android {
     composeOptions {
         kotlinCompilerExtensionVersion = "1.5.10"
     }
+    androidResources {
+        // ModelStore copies the models out of the APK; stored uncompressed that is a plain copy.
+        noCompress += "onnx"
+    }
     packaging {
         resources {
             excludes += "/META-INF/{AL2.0,LGPL2.1}"
@@ -0,0 +1,165 @@
+#pragma once
+
+// Shared helpers for the host benchmark executables: timing, peak RSS, input discovery and baseline files.
+
+#include "core/Trace.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+namespace eagleeye {
+namespace bench {
+
+struct StageResult {
+    std::string name;
+    int iterations = 0;
+    double meanMs = 0.0;
+    double minMs = 0.0;
+    double megapixels = 0.0;  // output pixels produced per iteration, in MP
+
+    double throughputMPs() const {
+        return meanMs > 0.0 ? megapixels / (meanMs / 1000.0) : 0.0;
+    }
+};
+
+/*
+ * Runs setup() + body() `iterations` times and records the wall time of body() only. The stage shows up as a task
+ * span when a trace capture is running.
+ */
+inline StageResult runStage(const std::string& name, int iterations, double megapixels,
+                            const std::function<void()>& setup, const std::function<void()>& body) {
+    StageResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.megapixels = megapixels;
+    double totalMs = 0.0;
+    double minMs = 0.0;
+    trace::beginTask(name);
+    for (int i = 0; i < iterations; i++) {
+        if (setup) {
+            setup();
+        }
+        auto start = std::chrono::steady_clock::now();
+        body();
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        totalMs += elapsedMs;
+        minMs = (i == 0) ? elapsedMs : std::min(minMs, elapsedMs);
+    }
+    trace::endTask();
+    result.meanMs = iterations > 0 ? totalMs / iterations : 0.0;
+    result.minMs = minMs;
+    return result;
+}
+
+/*
+ * Peak resident set size of this process in MB.
+ */
+inline double peakRssMb() {
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;  // ru_maxrss is in KB on Linux
+}
+
+inline std::vector<std::string> listImages(const std::string& directory) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        std::string extension = entry.path().extension().string();
+        if (extension == ".jpg" || extension == ".jpeg" || extension == ".png") {
+            paths.push_back(entry.path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+/*
+ * Loads the images and optionally resizes them to the requested frame size so that the small test assets
+ * can stand in for full-resolution captures.
+ */
+inline std::vector<cv::Mat> loadFrames(const std::vector<std::string>& paths, cv::Size frameSize) {
+    std::vector<cv::Mat> frames;
+    for (const std::string& path : paths) {
+        cv::Mat frame = cv::imread(path, cv::IMREAD_COLOR);
+        if (frame.empty()) {
+            std::fprintf(stderr, "Skipping unreadable image %s\n", path.c_str());
+            continue;
+        }
+        if (frameSize.area() > 0 && frame.size() != frameSize) {
+            cv::resize(frame, frame, frameSize, 0.0, 0.0, cv::INTER_CUBIC);
+        }
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+/*
+ * Baseline files are a flat JSON object of stage name -> milliseconds, e.g. {"unsharpMask@12MP": 41.2}.
+ * Only that shape is understood; anything else yields an empty map.
+ */
+inline std::map<std::string, double> readBaseline(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream file(path);
+    if (!file) {
+        return baseline;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t position = 0;
+    while ((position = text.find('"', position)) != std::string::npos) {
+        size_t nameEnd = text.find('"', position + 1);
+        size_t colon = (nameEnd == std::string::npos) ? nameEnd : text.find(':', nameEnd);
+        if (colon == std::string::npos) {
+            break;
+        }
+        std::string name = text.substr(position + 1, nameEnd - position - 1);
+        char* valueEnd = nullptr;
+        double value = std::strtod(text.c_str() + colon + 1, &valueEnd);
+        if (valueEnd != text.c_str() + colon + 1) {
+            baseline[name] = value;
+        }
+        position = colon + 1;
+    }
+    return baseline;
+}
+
+inline bool writeBaseline(const std::string& path, const std::map<std::string, double>& baseline) {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+    file << "{\n";
+    size_t index = 0;
+    for (const auto& entry : baseline) {
+        char value[32];
+        std::snprintf(value, sizeof(value), "%.3f", entry.second);
+        file << "  \"" << entry.first << "\": " << value << (++index < baseline.size() ? ",\n" : "\n");
+    }
+    file << "}\n";
+    return static_cast<bool>(file);
+}
+
+inline void printHeader() {
+    std::printf("%-28s %6s %12s %12s %10s\n", "stage", "iters", "mean ms", "min ms", "MP/s");
+}
+
+inline void printResult(const StageResult& result) {
+    std::printf("%-28s %6d %12.2f %12.2f %10.2f\n", result.name.c_str(), result.iterations, result.meanMs,
+                result.minMs, result.throughputMPs());
+}
+
+}  // namespace bench
+}  // namespace eagleeye
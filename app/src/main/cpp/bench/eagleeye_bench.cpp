@@ -0,0 +1,298 @@
+// Host benchmark for the native merge / fusion stages.
+//
+// Runs the same work the app does in ImageOperator.performJNIInterpolationWithMerge (upscale + mergeQuadrants)
+// and MeanFusionOperator (file based meanFuse and the streaming FusionAccumulator), plus the Bitmap <-> Mat
+// conversions, on the images in app/src/main/assets/test_images and
+// reports wall time, throughput and peak RSS, so that regressions can be caught on x86_64 Linux.
+//
+// Usage: eagleeye-bench [--images DIR] [--scale N] [--division N] [--iterations N] [--size WxH] [--trace FILE]
+//
+// --trace writes the native trace of the whole run (Chrome trace-event JSON) to FILE.
+
+#include "BenchCommon.h"
+#include "core/AsyncFileRemover.h"
+#include "core/BurstMatcher.h"
+#include "core/ColorRotate.h"
+#include "core/EnergyReader.h"
+#include "core/FusionAccumulator.h"
+#include "core/QuadrantMerge.h"
+#include "core/ShiftAddFusion.h"
+#include "core/TileScheduler.h"
+#include "core/Trace.h"
+#include "core/WarpFusion.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#ifndef EAGLEEYE_TEST_IMAGES_DIR
+#define EAGLEEYE_TEST_IMAGES_DIR "app/src/main/assets/test_images"
+#endif
+
+using namespace eagleeye;
+
+namespace {
+
+struct Options {
+    std::string imagesDir = EAGLEEYE_TEST_IMAGES_DIR;
+    int scale = 2;
+    int divisionFactor = 4;
+    int iterations = 5;
+    cv::Size frameSize;
+    std::string tracePath;
+};
+
+void printUsage() {
+    std::printf("Usage: eagleeye-bench [--images DIR] [--scale N] [--division N] [--iterations N] [--size WxH] "
+                "[--trace FILE]\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage();
+            std::exit(0);
+        } else if (value == nullptr) {
+            std::fprintf(stderr, "Missing value for %s\n", arg);
+            return false;
+        } else if (std::strcmp(arg, "--images") == 0) {
+            options.imagesDir = value;
+        } else if (std::strcmp(arg, "--scale") == 0) {
+            options.scale = std::max(1, std::atoi(value));
+        } else if (std::strcmp(arg, "--division") == 0) {
+            options.divisionFactor = std::max(1, std::atoi(value));
+        } else if (std::strcmp(arg, "--iterations") == 0) {
+            options.iterations = std::max(1, std::atoi(value));
+        } else if (std::strcmp(arg, "--trace") == 0) {
+            options.tracePath = value;
+        } else if (std::strcmp(arg, "--size") == 0) {
+            int width = 0;
+            int height = 0;
+            if (std::sscanf(value, "%dx%d", &width, &height) != 2) {
+                std::fprintf(stderr, "Invalid --size %s, expected WxH\n", value);
+                return false;
+            }
+            options.frameSize = cv::Size(width, height);
+        } else {
+            std::fprintf(stderr, "Unknown option %s\n", arg);
+            return false;
+        }
+        i++;
+    }
+    return true;
+}
+
+/*
+ * Same split as ImageOperator.performJNIInterpolation: cut the frame into divisionFactor^2 quadrants (the last
+ * row/column takes the remainder), optionally resize each by `scale` and write them as JPEGs.
+ */
+std::vector<std::string> writeQuadrants(const cv::Mat& frame, int divisionFactor, int scale,
+                                        const std::filesystem::path& directory, const std::string& prefix) {
+    int quadrantWidth = frame.cols / divisionFactor;
+    int quadrantHeight = frame.rows / divisionFactor;
+    std::vector<std::string> files;
+    for (int i = 0; i < divisionFactor; i++) {
+        for (int j = 0; j < divisionFactor; j++) {
+            int x = j * quadrantWidth;
+            int y = i * quadrantHeight;
+            int width = (j == divisionFactor - 1) ? frame.cols - x : quadrantWidth;
+            int height = (i == divisionFactor - 1) ? frame.rows - y : quadrantHeight;
+            cv::Mat quadrant = frame(cv::Rect(x, y, width, height));
+            cv::Mat resized;
+            if (scale > 1) {
+                cv::resize(quadrant, resized, cv::Size(), scale, scale, cv::INTER_CUBIC);
+            } else {
+                resized = quadrant;
+            }
+            std::string path = (directory / (prefix + "_" + std::to_string(files.size() + 1) + ".jpg")).string();
+            cv::imwrite(path, resized);
+            files.push_back(path);
+        }
+    }
+    return files;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    std::vector<cv::Mat> frames = bench::loadFrames(bench::listImages(options.imagesDir), options.frameSize);
+    if (frames.empty()) {
+        std::fprintf(stderr, "No images found in %s\n", options.imagesDir.c_str());
+        return 1;
+    }
+
+    if (!options.tracePath.empty()) {
+        trace::beginCapture();
+    }
+
+    std::filesystem::path workDir = std::filesystem::temp_directory_path() / "eagleeye-bench";
+    std::filesystem::create_directories(workDir);
+
+    const cv::Mat& reference = frames[0];
+    int divisionFactor = options.divisionFactor;
+    int quadrantWidth = reference.cols / divisionFactor;
+    int quadrantHeight = reference.rows / divisionFactor;
+    double inputMp = reference.total() / 1e6;
+    double upscaledMp = inputMp * options.scale * options.scale;
+
+    std::printf("eagleeye-bench: %zu frame(s) of %dx%d, scale %dx, %dx%d quadrants, %d iteration(s)\n",
+                frames.size(), reference.cols, reference.rows, options.scale, divisionFactor, divisionFactor,
+                options.iterations);
+    bench::printHeader();
+
+    // Upscale path: split + bicubic resize of every quadrant, then the native merge.
+    std::vector<std::string> quadrantFiles;
+    bench::printResult(bench::runStage("upscale.writeQuadrants", options.iterations, upscaledMp, nullptr, [&]() {
+        quadrantFiles = writeQuadrants(reference, divisionFactor, options.scale, workDir, "upscale");
+    }));
+    for (bool parallel : {false, true}) {
+        bench::printResult(bench::runStage(
+            parallel ? "upscale.mergeQuadrants" : "upscale.mergeQuadrants.serial", options.iterations, upscaledMp,
+            [&]() {
+                AsyncFileRemover::instance().drain();
+                quadrantFiles = writeQuadrants(reference, divisionFactor, options.scale, workDir, "upscale");
+            },
+            [&]() {
+                cv::Mat merged = mergeQuadrantFiles(quadrantFiles, divisionFactor, options.scale, quadrantWidth,
+                                                    quadrantHeight, parallel);
+                CV_Assert(!merged.empty());
+            }));
+    }
+
+    // In-memory upscale path: tiles resized straight into a preallocated output, no files.
+    cv::Mat upscaled(cvRound(reference.rows * options.scale), cvRound(reference.cols * options.scale),
+                     reference.type());
+    bench::printResult(bench::runStage("upscale.inMemory", options.iterations, upscaledMp, nullptr, [&]() {
+        CV_Assert(upscaleQuadrants(reference, upscaled, divisionFactor, options.scale));
+    }));
+    // Same, tiled for a 1 MB per-tile budget instead of the fixed quadrant grid.
+    TileScheduler budgetTiles = TileScheduler::forBudget(reference.size(), reference.elemSize(), 1 << 20, 4);
+    bench::printResult(bench::runStage("upscale.inMemory.budget", options.iterations, upscaledMp, nullptr, [&]() {
+        CV_Assert(upscaleTiles(reference, upscaled, budgetTiles, options.scale));
+    }));
+    upscaled.release();
+
+    // Fusion path: every frame split into quadrants, then the native mean fusion over all frames.
+    std::vector<std::vector<std::string>> fusionFiles;
+    std::vector<std::string> fusedNames;
+    for (int i = 0; i < divisionFactor * divisionFactor; i++) {
+        fusedNames.push_back((workDir / ("fused_" + std::to_string(i + 1) + ".jpg")).string());
+    }
+    auto prepareFusion = [&]() {
+        fusionFiles.assign(divisionFactor * divisionFactor, std::vector<std::string>());
+        for (size_t f = 0; f < frames.size(); f++) {
+            std::vector<std::string> files =
+                    writeQuadrants(frames[f], divisionFactor, 1, workDir, "frame" + std::to_string(f));
+            for (size_t q = 0; q < files.size(); q++) {
+                fusionFiles[q].push_back(files[q]);
+            }
+        }
+    };
+    bench::printResult(bench::runStage("fusion.meanFuse", options.iterations, inputMp, prepareFusion, [&]() {
+        cv::Mat fused = meanFuseQuadrantFiles(fusionFiles, fusedNames, divisionFactor, quadrantWidth, quadrantHeight);
+        CV_Assert(!fused.empty());
+    }));
+
+    bench::printResult(bench::runStage("fusion.accumulator", options.iterations, inputMp, nullptr, [&]() {
+        FusionAccumulator accumulator;
+        accumulator.begin(reference.size(), 1.0, reference.channels());
+        for (const cv::Mat& frame : frames) {
+            accumulator.add(frame);
+        }
+        CV_Assert(!accumulator.finish().empty());
+    }));
+
+    // Warp + accumulate in one tiled pass, with a small rotation like a hand-held burst.
+    cv::Mat homography = cv::getRotationMatrix2D(cv::Point2f(reference.cols / 2.0f, reference.rows / 2.0f), 0.5, 1.0);
+    homography.push_back(cv::Mat((cv::Mat_<double>(1, 3) << 0.0, 0.0, 1.0)));
+    bench::printResult(bench::runStage("fusion.warpAccumulate", options.iterations, inputMp, nullptr, [&]() {
+        WarpFusion fusion;
+        fusion.begin(reference);
+        for (size_t i = 1; i < frames.size(); i++) {
+            CV_Assert(fusion.addFrame(frames[i], homography));
+        }
+        CV_Assert(!fusion.finish().empty());
+    }));
+
+    // Shift-and-add onto the 2x grid with the same motion.
+    bench::printResult(bench::runStage("sr.shiftAdd.2x", options.iterations, inputMp * frames.size(), nullptr, [&]() {
+        ShiftAddFusion fusion;
+        fusion.addFrame(reference, cv::Mat());
+        for (size_t i = 1; i < frames.size(); i++) {
+            CV_Assert(fusion.addFrame(frames[i], homography));
+        }
+        CV_Assert(!fusion.reconstruct().empty());
+    }));
+
+    // Energy reading: InputImageEnergyReader (full decode, area resize, YUV split) against the reduced decode.
+    std::vector<std::string> imagePaths = bench::listImages(options.imagesDir);
+    bench::printResult(bench::runStage("energy.read.full", options.iterations, inputMp * imagePaths.size(),
+                                       nullptr, [&]() {
+        for (const std::string& path : imagePaths) {
+            cv::Mat image = cv::imread(path);
+            cv::resize(image, image, cv::Size(), 0.125, 0.125, cv::INTER_AREA);
+            cv::Mat yuv;
+            cv::cvtColor(image, yuv, cv::COLOR_BGR2YUV);
+            std::vector<cv::Mat> channels;
+            cv::split(yuv, channels);
+            CV_Assert(!channels[0].empty());
+        }
+    }));
+    bench::printResult(bench::runStage("energy.read.reduced", options.iterations, inputMp * imagePaths.size(),
+                                       nullptr, [&]() {
+        CV_Assert(readEnergy(imagePaths).size() == imagePaths.size());
+    }));
+
+    // Burst alignment: ORB features of the first frame matched against all other frames.
+    if (frames.size() > 1) {
+        std::vector<cv::Mat> others(frames.begin() + 1, frames.end());
+        bench::printResult(bench::runStage("align.burstMatch", options.iterations, inputMp * others.size(),
+                                           nullptr, [&]() {
+            BurstMatcher matcher;
+            matcher.setReference(reference);
+            CV_Assert(matcher.matchFrames(others).size() == others.size());
+        }));
+        bench::printResult(bench::runStage("align.burstMatch.pyramid", options.iterations,
+                                           inputMp * others.size(), nullptr, [&]() {
+            BurstMatchOptions matchOptions;
+            matchOptions.pyramid = true;
+            BurstMatcher matcher(matchOptions);
+            matcher.setReference(reference);
+            CV_Assert(matcher.matchFrames(others).size() == others.size());
+        }));
+    }
+
+    // Bitmap bridge: RGBA -> BGR + 90 degree rotation, OpenCV two-pass versus the fused single pass.
+    cv::Mat rgba;
+    cv::cvtColor(reference, rgba, reference.channels() == 1 ? cv::COLOR_GRAY2RGBA : cv::COLOR_BGR2RGBA);
+    cv::Mat bgr;
+    bench::printResult(bench::runStage("bitmap.toMat.opencv", options.iterations, inputMp, nullptr, [&]() {
+        cv::cvtColor(rgba, bgr, cv::COLOR_RGBA2BGR);
+        cv::rotate(bgr, bgr, cv::ROTATE_90_CLOCKWISE);
+    }));
+    bench::printResult(bench::runStage("bitmap.toMat.fused", options.iterations, inputMp, nullptr, [&]() {
+        rgbaToBgr(rgba, bgr, Rotation::Clockwise90);
+    }));
+    bench::printResult(bench::runStage("bitmap.fromMat.fused", options.iterations, inputMp, nullptr, [&]() {
+        CV_Assert(bgrToRgba(bgr, rgba, Rotation::CounterClockwise90));
+    }));
+
+    AsyncFileRemover::instance().drain();
+    std::filesystem::remove_all(workDir);
+    std::printf("peak RSS: %.1f MB\n", bench::peakRssMb());
+    if (!options.tracePath.empty() && !trace::endCapture(options.tracePath)) {
+        std::fprintf(stderr, "Could not write trace to %s\n", options.tracePath.c_str());
+        return 1;
+    }
+    return 0;
+}
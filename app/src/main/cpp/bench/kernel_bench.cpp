@@ -0,0 +1,410 @@
+// Host microbenchmarks for the per-pixel kernels the pipeline spends its time in, at full capture resolutions.
+//
+// Every kernel mirrors what the app runs today (mostly the Kotlin OpenCV calls), so that optimised native
+// versions can be measured against it. Results are compared against a baseline file and the run fails if a
+// kernel got slower than the threshold.
+//
+// Usage: eagleeye-kernels [--images DIR] [--sizes 12,50] [--iterations N] [--filter TEXT]
+//                         [--baseline FILE] [--write-baseline FILE] [--threshold PCT]
+//
+// Baselines are machine specific: record one with --write-baseline on the machine that runs the comparison.
+
+#include "BenchCommon.h"
+#include "core/EdgeMeasure.h"
+#include "core/QuadrantMerge.h"
+#include "core/TensorPack.h"
+#include "core/UnsharpMask.h"
+#include "core/YangFilter.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+
+#ifndef EAGLEEYE_TEST_IMAGES_DIR
+#define EAGLEEYE_TEST_IMAGES_DIR "app/src/main/assets/test_images"
+#endif
+
+using namespace eagleeye;
+
+namespace {
+
+struct Options {
+    std::string imagesDir = EAGLEEYE_TEST_IMAGES_DIR;
+    std::vector<int> megapixels = {12, 50};
+    int iterations = 5;
+    std::string filter;
+    std::string baselinePath;
+    std::string writeBaselinePath;
+    double thresholdPercent = 10.0;
+};
+
+// Capture sizes the suite runs at, keyed by their rounded megapixel count.
+cv::Size frameSizeFor(int megapixels) {
+    switch (megapixels) {
+        case 12: return cv::Size(4000, 3000);
+        case 50: return cv::Size(8160, 6120);
+        default: {
+            int width = cvRound(std::sqrt(megapixels * 1e6 * 4.0 / 3.0));
+            return cv::Size(width, width * 3 / 4);
+        }
+    }
+}
+
+void printUsage() {
+    std::printf("Usage: eagleeye-kernels [--images DIR] [--sizes 12,50] [--iterations N] [--filter TEXT]\n"
+                "                        [--baseline FILE] [--write-baseline FILE] [--threshold PCT]\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage();
+            std::exit(0);
+        } else if (value == nullptr) {
+            std::fprintf(stderr, "Missing value for %s\n", arg);
+            return false;
+        } else if (std::strcmp(arg, "--images") == 0) {
+            options.imagesDir = value;
+        } else if (std::strcmp(arg, "--sizes") == 0) {
+            options.megapixels.clear();
+            std::stringstream list(value);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                int megapixels = std::atoi(item.c_str());
+                if (megapixels <= 0) {
+                    std::fprintf(stderr, "Invalid --sizes entry %s\n", item.c_str());
+                    return false;
+                }
+                options.megapixels.push_back(megapixels);
+            }
+        } else if (std::strcmp(arg, "--iterations") == 0) {
+            options.iterations = std::max(1, std::atoi(value));
+        } else if (std::strcmp(arg, "--filter") == 0) {
+            options.filter = value;
+        } else if (std::strcmp(arg, "--baseline") == 0) {
+            options.baselinePath = value;
+        } else if (std::strcmp(arg, "--write-baseline") == 0) {
+            options.writeBaselinePath = value;
+        } else if (std::strcmp(arg, "--threshold") == 0) {
+            options.thresholdPercent = std::atof(value);
+        } else {
+            std::fprintf(stderr, "Unknown option %s\n", arg);
+            return false;
+        }
+        i++;
+    }
+    return true;
+}
+
+struct Inputs {
+    cv::Mat bgr;   // CV_8UC3 frame
+    cv::Mat gray;  // CV_8UC1 frame, what the energy / edge stages see
+};
+
+/*
+ * A kernel prepares its inputs and outputs once per frame size in `prepare` and returns the body that is timed.
+ * Every body produces one frame worth of output, which is what the MP/s column is based on.
+ */
+struct Kernel {
+    std::string name;
+    std::function<std::function<void()>(const Inputs& inputs)> prepare;
+};
+
+// ImageOperator.edgeSobelMeasure without the debug image write.
+int edgeSobelChain(const cv::Mat& input) {
+    cv::Mat reference;
+    cv::blur(input, reference, cv::Size(3, 3));
+    cv::Mat gradX, gradY, sobel;
+    cv::Sobel(reference, gradX, CV_16S, 1, 0, 3, 1.0, 0.0, cv::BORDER_DEFAULT);
+    cv::Sobel(reference, gradY, CV_16S, 0, 1, 3, 1.0, 0.0, cv::BORDER_DEFAULT);
+    gradX.convertTo(gradX, CV_8UC(gradX.channels()));
+    gradY.convertTo(gradY, CV_8UC(gradY.channels()));
+    cv::addWeighted(gradX, 0.5, gradY, 0.5, 0.0, sobel);
+    return cv::countNonZero(produceMask(sobel));
+}
+
+// YangFilter.perform + YangFilterFusionOperator for one image.
+cv::Mat yangFilter(const cv::Mat& input) {
+    static const cv::Mat f1 = (cv::Mat_<int>(3, 1) << -1, 0, 1);
+    static const cv::Mat f2 = f1.t();
+    static const cv::Mat f3 = (cv::Mat_<int>(5, 1) << -1, 0, 2, 0, -1);
+    static const cv::Mat f4 = f3.t();
+
+    cv::Mat sumMat = cv::Mat::zeros(input.size(), CV_32FC(input.channels()));
+    cv::Mat divMat = cv::Mat::zeros(input.size(), CV_32FC1);
+    cv::Mat filtered, mask;
+    for (const cv::Mat* kernel : {&f1, &f2, &f3, &f4}) {
+        cv::Mat kernelF;
+        kernel->convertTo(kernelF, CV_32F);
+        cv::filter2D(input, filtered, input.depth(), kernelF);
+        filtered.convertTo(filtered, CV_32FC(input.channels()));
+        mask = produceMask(filtered);
+        cv::add(filtered, sumMat, sumMat, mask, CV_32FC(input.channels()));
+        mask.convertTo(mask, CV_32FC1);
+        cv::add(mask, divMat, divMat);
+    }
+    cv::Mat output;
+    cv::divide(sumMat, divMat, output);
+    output.convertTo(output, CV_8UC(input.channels()));
+    return output;
+}
+
+// AKDT / SynthDehaze tensor preparation: 8-bit HWC -> float NCHW scaled to [0, 1].
+void packHwcToNchw(const cv::Mat& hwc, std::vector<float>& nchw) {
+    cv::Mat normalized;
+    hwc.convertTo(normalized, CV_32F, 1.0 / 255.0);
+    const int rows = normalized.rows;
+    const int cols = normalized.cols;
+    const int channels = normalized.channels();
+    nchw.resize(static_cast<size_t>(rows) * cols * channels);
+    for (int r = 0; r < rows; r++) {
+        const float* row = normalized.ptr<float>(r);
+        for (int c = 0; c < cols; c++) {
+            for (int ch = 0; ch < channels; ch++) {
+                nchw[(static_cast<size_t>(ch) * rows + r) * cols + c] = row[c * channels + ch];
+            }
+        }
+    }
+}
+
+// ...and back: float NCHW in [0, 1] -> 8-bit HWC.
+void unpackNchwToHwc(const std::vector<float>& nchw, int rows, int cols, int channels, cv::Mat& hwc) {
+    cv::Mat output(rows, cols, CV_32FC(channels));
+    for (int r = 0; r < rows; r++) {
+        float* row = output.ptr<float>(r);
+        for (int c = 0; c < cols; c++) {
+            for (int ch = 0; ch < channels; ch++) {
+                row[c * channels + ch] = nchw[(static_cast<size_t>(ch) * rows + r) * cols + c];
+            }
+        }
+    }
+    output.convertTo(hwc, CV_8UC(channels), 255.0);
+}
+
+std::vector<Kernel> kernels() {
+    std::vector<Kernel> list;
+
+    list.push_back({"produceMask+maskedAdd", [](const Inputs& inputs) {
+        auto sum = std::make_shared<cv::Mat>(cv::Mat::zeros(inputs.bgr.size(), CV_16UC3));
+        return std::function<void()>([&inputs, sum]() {
+            cv::Mat frame16, mask = produceMask(inputs.bgr);
+            inputs.bgr.convertTo(frame16, CV_16UC3);
+            cv::add(*sum, frame16, *sum, mask, CV_16UC3);
+        });
+    }});
+
+    list.push_back({"yangFilter", [](const Inputs& inputs) {
+        return std::function<void()>([&inputs]() {
+            CV_Assert(!yangFilter(inputs.gray).empty());
+        });
+    }});
+
+    list.push_back({"yangFilter.fused", [](const Inputs& inputs) {
+        // Same output as the reference kernel, bit for bit.
+        CV_Assert(cv::norm(yangFilter(inputs.gray), yangEdges(inputs.gray), cv::NORM_INF) == 0.0);
+        return std::function<void()>([&inputs]() {
+            CV_Assert(!yangEdges(inputs.gray).empty());
+        });
+    }});
+
+    list.push_back({"edgeSobelMeasure", [](const Inputs& inputs) {
+        return std::function<void()>([&inputs]() {
+            CV_Assert(edgeSobelChain(inputs.gray) >= 0);
+        });
+    }});
+
+    list.push_back({"edgeSobelMeasure.fused", [](const Inputs& inputs) {
+        // Same count as the OpenCV chain, on one channel and on the 16-bit sum of two colour frames.
+        CV_Assert(edgeSobelMeasure(inputs.gray) == edgeSobelChain(inputs.gray));
+        cv::Mat flipped, sum;
+        cv::flip(inputs.bgr, flipped, 1);
+        cv::add(inputs.bgr, flipped, sum, cv::noArray(), CV_16U);
+        CV_Assert(edgeSobelMeasure(inputs.bgr, flipped) == edgeSobelChain(sum));
+        return std::function<void()>([&inputs]() {
+            CV_Assert(edgeSobelMeasure(inputs.gray) >= 0);
+        });
+    }});
+
+    list.push_back({"unsharpMask25", [](const Inputs& inputs) {
+        auto output = std::make_shared<cv::Mat>();
+        return std::function<void()>([&inputs, output]() {
+            cv::Mat blurred;
+            cv::blur(inputs.bgr, blurred, cv::Size(25, 25));
+            cv::addWeighted(inputs.bgr, 2.25, blurred, -1.25, 0.0, *output, CV_8UC3);
+        });
+    }});
+
+    list.push_back({"unsharpMask25.fused", [](const Inputs& inputs) {
+        auto output = std::make_shared<cv::Mat>();
+        // Same output as blur + addWeighted, bit for bit.
+        cv::Mat blurred, reference;
+        cv::blur(inputs.bgr, blurred, cv::Size(25, 25));
+        cv::addWeighted(inputs.bgr, 2.25, blurred, -1.25, 0.0, reference, CV_8UC3);
+        CV_Assert(unsharpMask(inputs.bgr, *output));
+        CV_Assert(cv::norm(reference, *output, cv::NORM_INF) == 0.0);
+        return std::function<void()>([&inputs, output]() {
+            CV_Assert(unsharpMask(inputs.bgr, *output));
+        });
+    }});
+
+    list.push_back({"warpPerspective.cubic", [](const Inputs& inputs) {
+        // A small rotation + perspective tilt, like the homographies between burst frames.
+        cv::Mat homography = (cv::Mat_<double>(3, 3) << 0.9995, -0.0110, 14.0,
+                                                        0.0112, 0.9992, -9.0,
+                                                        1.5e-7, -2.0e-7, 1.0);
+        auto output = std::make_shared<cv::Mat>();
+        return std::function<void()>([&inputs, homography, output]() {
+            cv::warpPerspective(inputs.bgr, *output, homography, inputs.bgr.size(), cv::INTER_CUBIC,
+                                cv::BORDER_CONSTANT);
+        });
+    }});
+
+    for (int scale : {2, 4, 8}) {
+        // The output is the benchmark frame size, the input is that much smaller.
+        list.push_back({"resize.cubic." + std::to_string(scale) + "x", [scale](const Inputs& inputs) {
+            auto source = std::make_shared<cv::Mat>();
+            cv::resize(inputs.bgr, *source, cv::Size(inputs.bgr.cols / scale, inputs.bgr.rows / scale), 0.0, 0.0,
+                       cv::INTER_AREA);
+            auto output = std::make_shared<cv::Mat>();
+            return std::function<void()>([&inputs, source, output]() {
+                cv::resize(*source, *output, inputs.bgr.size(), 0.0, 0.0, cv::INTER_CUBIC);
+            });
+        }});
+    }
+
+    list.push_back({"pack.hwcToNchw", [](const Inputs& inputs) {
+        auto tensor = std::make_shared<std::vector<float>>();
+        return std::function<void()>([&inputs, tensor]() {
+            packHwcToNchw(inputs.bgr, *tensor);
+        });
+    }});
+
+    list.push_back({"pack.nchwToHwc", [](const Inputs& inputs) {
+        auto tensor = std::make_shared<std::vector<float>>();
+        packHwcToNchw(inputs.bgr, *tensor);
+        auto output = std::make_shared<cv::Mat>();
+        return std::function<void()>([&inputs, tensor, output]() {
+            unpackNchwToHwc(*tensor, inputs.bgr.rows, inputs.bgr.cols, 3, *output);
+        });
+    }});
+
+    list.push_back({"pack.hwcToNchw.fused", [](const Inputs& inputs) {
+        const cv::Rect whole(cv::Point(), inputs.bgr.size());
+        auto tensor = std::make_shared<std::vector<float>>(whole.area() * 3);
+        // Same tensor as the convert + reorder chain, up to float rounding of the scale.
+        std::vector<float> reference;
+        packHwcToNchw(inputs.bgr, reference);
+        CV_Assert(packToNchw(inputs.bgr, whole, tensor->data(), PackParams()));
+        CV_Assert(cv::norm(cv::Mat(reference), cv::Mat(*tensor), cv::NORM_INF) < 1e-6);
+        return std::function<void()>([&inputs, whole, tensor]() {
+            CV_Assert(packToNchw(inputs.bgr, whole, tensor->data(), PackParams()));
+        });
+    }});
+
+    list.push_back({"pack.nchwToHwc.fused", [](const Inputs& inputs) {
+        const cv::Rect whole(cv::Point(), inputs.bgr.size());
+        auto tensor = std::make_shared<std::vector<float>>();
+        packHwcToNchw(inputs.bgr, *tensor);
+        auto output = std::make_shared<cv::Mat>(inputs.bgr.size(), CV_8UC3);
+        // Same pixels as the reorder + convert chain, bit for bit.
+        cv::Mat reference;
+        unpackNchwToHwc(*tensor, inputs.bgr.rows, inputs.bgr.cols, 3, reference);
+        CV_Assert(unpackFromNchw(tensor->data(), inputs.bgr.size(), whole, *output, UnpackParams()));
+        CV_Assert(cv::norm(reference, *output, cv::NORM_INF) == 0.0);
+        return std::function<void()>([&inputs, whole, tensor, output]() {
+            CV_Assert(unpackFromNchw(tensor->data(), inputs.bgr.size(), whole, *output, UnpackParams()));
+        });
+    }});
+
+    return list;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    std::vector<std::string> images = bench::listImages(options.imagesDir);
+    if (images.empty()) {
+        std::fprintf(stderr, "No images found in %s\n", options.imagesDir.c_str());
+        return 1;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!options.baselinePath.empty()) {
+        baseline = bench::readBaseline(options.baselinePath);
+        if (baseline.empty()) {
+            std::fprintf(stderr, "Baseline %s is missing or empty\n", options.baselinePath.c_str());
+            return 1;
+        }
+    }
+
+    std::map<std::string, double> results;
+    std::vector<std::string> regressions;
+    std::printf("eagleeye-kernels: %d iteration(s), threshold %.1f%%\n", options.iterations, options.thresholdPercent);
+    std::printf("%-36s %6s %12s %12s %10s %12s %8s\n", "kernel", "iters", "mean ms", "min ms", "MP/s", "baseline",
+                "delta");
+
+    for (int megapixels : options.megapixels) {
+        cv::Size frameSize = frameSizeFor(megapixels);
+        Inputs inputs;
+        inputs.bgr = bench::loadFrames({images[0]}, frameSize).at(0);
+        cv::cvtColor(inputs.bgr, inputs.gray, cv::COLOR_BGR2GRAY);
+        double frameMp = frameSize.area() / 1e6;
+
+        for (const Kernel& kernel : kernels()) {
+            std::string name = kernel.name + "@" + std::to_string(megapixels) + "MP";
+            if (!options.filter.empty() && name.find(options.filter) == std::string::npos) {
+                continue;
+            }
+            std::function<void()> body = kernel.prepare(inputs);
+            body();  // warm-up: first-touch page faults and OpenCV's lazy initialisation
+            bench::StageResult result = bench::runStage(name, options.iterations, frameMp, nullptr, body);
+            results[name] = result.minMs;
+
+            auto reference = baseline.find(name);
+            if (reference == baseline.end() || reference->second <= 0.0) {
+                std::printf("%-36s %6d %12.2f %12.2f %10.2f %12s %8s\n", name.c_str(), result.iterations,
+                            result.meanMs, result.minMs, result.throughputMPs(), "-", "-");
+                continue;
+            }
+            double delta = (result.minMs - reference->second) / reference->second * 100.0;
+            bool regressed = delta > options.thresholdPercent;
+            std::printf("%-36s %6d %12.2f %12.2f %10.2f %12.2f %+7.1f%%%s\n", name.c_str(), result.iterations,
+                        result.meanMs, result.minMs, result.throughputMPs(), reference->second, delta,
+                        regressed ? "  REGRESSED" : "");
+            if (regressed) {
+                regressions.push_back(name);
+            }
+        }
+    }
+
+    if (!options.writeBaselinePath.empty()) {
+        if (!bench::writeBaseline(options.writeBaselinePath, results)) {
+            std::fprintf(stderr, "Could not write baseline %s\n", options.writeBaselinePath.c_str());
+            return 1;
+        }
+        std::printf("baseline written to %s\n", options.writeBaselinePath.c_str());
+    }
+    std::printf("peak RSS: %.1f MB\n", bench::peakRssMb());
+
+    if (!regressions.empty()) {
+        std::fprintf(stderr, "%zu kernel(s) regressed by more than %.1f%%:\n", regressions.size(),
+                     options.thresholdPercent);
+        for (const std::string& name : regressions) {
+            std::fprintf(stderr, "  %s\n", name.c_str());
+        }
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,279 @@
+// Host benchmark for the patch layouts of the tiled models (AKDT denoising, shadow removal): how many patches a
+// capture takes, how much of the inferred area is padding, and how visible the seams between patches are.
+//
+// The model is simulated, since what matters for the seams is how its errors differ between patches: every patch
+// output is the input plus a per-patch tone offset and an error that grows towards the patch edges (what a
+// convolutional model does where it sees padding instead of context). Each layout stitches those outputs and the
+// seam error is measured on the difference to the input: the mean and largest step between neighbouring pixels,
+// in 8-bit levels. A seamless layout spreads the per-patch offsets smoothly and has small steps.
+//
+// The results depend on how far in from the patch edges the simulated error reaches (--edge-decay), and the
+// smallest halo that hides the seams grows with it. Check a halo against the real model before relying on it.
+//
+// Usage: eagleeye-tiles [--images DIR] [--sizes 12,50] [--patch N] [--edge-decay PX] [--iterations N]
+
+#include "BenchCommon.h"
+#include "core/TileBlend.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+#ifndef EAGLEEYE_TEST_IMAGES_DIR
+#define EAGLEEYE_TEST_IMAGES_DIR "app/src/main/assets/test_images"
+#endif
+
+using namespace eagleeye;
+
+namespace {
+
+struct Options {
+    std::string imagesDir = EAGLEEYE_TEST_IMAGES_DIR;
+    std::vector<int> megapixels = {12, 50};
+    int patchSize = 512;
+    float edgeDecay = 6.0f;
+    int iterations = 3;
+};
+
+cv::Size frameSizeFor(int megapixels) {
+    switch (megapixels) {
+        case 12: return cv::Size(4000, 3000);
+        case 50: return cv::Size(8160, 6120);
+        default: {
+            int width = cvRound(std::sqrt(megapixels * 1e6 * 4.0 / 3.0));
+            return cv::Size(width, width * 3 / 4);
+        }
+    }
+}
+
+void printUsage() {
+    std::printf("Usage: eagleeye-tiles [--images DIR] [--sizes 12,50] [--patch N] [--edge-decay PX] "
+                "[--iterations N]\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage();
+            std::exit(0);
+        } else if (value == nullptr) {
+            std::fprintf(stderr, "Missing value for %s\n", arg);
+            return false;
+        } else if (std::strcmp(arg, "--images") == 0) {
+            options.imagesDir = value;
+        } else if (std::strcmp(arg, "--sizes") == 0) {
+            options.megapixels.clear();
+            std::stringstream list(value);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                int megapixels = std::atoi(item.c_str());
+                if (megapixels <= 0) {
+                    std::fprintf(stderr, "Invalid --sizes entry %s\n", item.c_str());
+                    return false;
+                }
+                options.megapixels.push_back(megapixels);
+            }
+        } else if (std::strcmp(arg, "--patch") == 0) {
+            options.patchSize = std::max(64, std::atoi(value));
+        } else if (std::strcmp(arg, "--edge-decay") == 0) {
+            options.edgeDecay = std::max(0.5f, static_cast<float>(std::atof(value)));
+        } else if (std::strcmp(arg, "--iterations") == 0) {
+            options.iterations = std::max(1, std::atoi(value));
+        } else {
+            std::fprintf(stderr, "Unknown option %s\n", arg);
+            return false;
+        }
+        i++;
+    }
+    return true;
+}
+
+/*
+ * A way of covering the image with patches. Hard layouts copy the centre of each patch (margin pixels in from
+ * every edge) into the output; feathered ones blend whole patches with TileBlender.
+ */
+struct Layout {
+    std::string name;
+    std::vector<int> xs;
+    std::vector<int> ys;
+    int margin = 0;
+    int halo = -1;  // >= 0 for feathered layouts
+};
+
+// AKDT before feathering: patchSize - 2 * overlap of every patch is kept, on a grid padded to a multiple of that.
+Layout centreCropLayout(cv::Size size, int patchSize, int overlap) {
+    Layout layout;
+    layout.name = "centre-crop, overlap " + std::to_string(overlap);
+    layout.margin = overlap;
+    const int valid = patchSize - 2 * overlap;
+    for (int x = 0; x < size.width; x += valid) layout.xs.push_back(x - overlap);
+    for (int y = 0; y < size.height; y += valid) layout.ys.push_back(y - overlap);
+    return layout;
+}
+
+// Shadow removal before feathering: patches side by side, the last row and column padded.
+Layout sideBySideLayout(cv::Size size, int patchSize) {
+    Layout layout = centreCropLayout(size, patchSize, 0);
+    layout.name = "side by side";
+    return layout;
+}
+
+Layout featheredLayout(cv::Size size, int patchSize, int halo) {
+    Layout layout;
+    layout.name = "feathered, halo " + std::to_string(halo);
+    layout.halo = halo;
+    layout.xs = TileBlender::origins(size.width, patchSize, halo);
+    layout.ys = TileBlender::origins(size.height, patchSize, halo);
+    return layout;
+}
+
+/*
+ * The simulated model output for the patch at origin: the input (edge replicated outside the image) plus a
+ * per-patch offset of up to 2 % and an error of up to 5 % that decays with exp(-d / edgeDecay) from the patch
+ * edges. The default decay of 6 px is an assumption, not measured on AKDT or the shadow removal model; a halo of
+ * 8 is enough for it, a model whose edge error reaches further in needs a wider one.
+ */
+void simulatePatch(const cv::Mat& truth, cv::Point origin, int patchSize, float edgeDecay, uint32_t seed,
+                   std::vector<float>& planes) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> offsetOf(-0.02f, 0.02f);
+    std::uniform_real_distribution<float> edgeOf(-0.05f, 0.05f);
+    const int channels = truth.channels();
+    const size_t area = static_cast<size_t>(patchSize) * patchSize;
+    planes.resize(area * channels);
+    for (int c = 0; c < channels; c++) {
+        const float offset = offsetOf(rng);
+        const float edge = edgeOf(rng);
+        float* plane = planes.data() + c * area;
+        for (int y = 0; y < patchSize; y++) {
+            const int sy = std::clamp(origin.y + y, 0, truth.rows - 1);
+            const float* row = truth.ptr<float>(sy);
+            for (int x = 0; x < patchSize; x++) {
+                const int sx = std::clamp(origin.x + x, 0, truth.cols - 1);
+                const int distance = std::min({x, y, patchSize - 1 - x, patchSize - 1 - y});
+                plane[static_cast<size_t>(y) * patchSize + x] =
+                        row[sx * channels + c] + offset + edge * std::exp(-distance / edgeDecay);
+            }
+        }
+    }
+}
+
+/*
+ * Runs the layout over truth with the simulated model and stitches the result into output. Returns the time spent
+ * stitching, without the simulation.
+ */
+double stitch(const Layout& layout, const cv::Mat& truth, int patchSize, float edgeDecay, cv::Mat& output) {
+    using Clock = std::chrono::steady_clock;
+    Clock::duration stitching{};
+    output.create(truth.size(), truth.type());
+    std::vector<float> planes;
+    TileBlender blender;
+    UnpackParams params;
+    params.clamp = false;
+    auto start = Clock::now();
+    if (layout.halo >= 0) {
+        CV_Assert(blender.begin(output, patchSize, layout.halo, params));
+    }
+    stitching += Clock::now() - start;
+    const cv::Rect image(cv::Point(), truth.size());
+    uint32_t seed = 1;
+    for (int y : layout.ys) {
+        for (int x : layout.xs) {
+            simulatePatch(truth, cv::Point(x, y), patchSize, edgeDecay, seed++, planes);
+            start = Clock::now();
+            if (layout.halo >= 0) {
+                CV_Assert(blender.add(planes.data(), cv::Point(x, y)));
+            } else {
+                const int valid = patchSize - 2 * layout.margin;
+                const cv::Rect keep = cv::Rect(x + layout.margin, y + layout.margin, valid, valid) & image;
+                cv::Mat roi = output(keep);
+                CV_Assert(unpackFromNchw(planes.data(), cv::Size(patchSize, patchSize), keep - cv::Point(x, y),
+                                         roi, params));
+            }
+            stitching += Clock::now() - start;
+        }
+    }
+    start = Clock::now();
+    if (layout.halo >= 0) {
+        CV_Assert(blender.finish());
+    }
+    stitching += Clock::now() - start;
+    return std::chrono::duration<double, std::milli>(stitching).count();
+}
+
+/*
+ * Mean and largest absolute step of (output - truth) between horizontal and vertical neighbours, in 8-bit levels.
+ */
+void seamError(const cv::Mat& output, const cv::Mat& truth, double& mean, double& max) {
+    cv::Mat error = output - truth;
+    cv::Mat dx = cv::abs(error.colRange(1, error.cols) - error.colRange(0, error.cols - 1));
+    cv::Mat dy = cv::abs(error.rowRange(1, error.rows) - error.rowRange(0, error.rows - 1));
+    cv::Scalar meanX = cv::mean(dx), meanY = cv::mean(dy);
+    double maxX = 0.0, maxY = 0.0;
+    cv::minMaxLoc(dx.reshape(1), nullptr, &maxX);
+    cv::minMaxLoc(dy.reshape(1), nullptr, &maxY);
+    double sum = 0.0;
+    for (int c = 0; c < error.channels(); c++) {
+        sum += meanX[c] + meanY[c];
+    }
+    mean = sum / (2.0 * error.channels()) * 255.0;
+    max = std::max(maxX, maxY) * 255.0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    std::vector<std::string> images = bench::listImages(options.imagesDir);
+    if (images.empty()) {
+        std::fprintf(stderr, "No images found in %s\n", options.imagesDir.c_str());
+        return 1;
+    }
+
+    const int patchSize = options.patchSize;
+    std::printf("eagleeye-tiles: %dx%d patches, edge error decay %.1f px, %d iteration(s)\n", patchSize, patchSize,
+                options.edgeDecay, options.iterations);
+    std::printf("%-28s %8s %10s %12s %12s %12s %12s\n", "layout", "size", "patches", "padding %", "seam mean",
+                "seam max", "stitch ms");
+
+    for (int megapixels : options.megapixels) {
+        cv::Size frameSize = frameSizeFor(megapixels);
+        cv::Mat truth;
+        bench::loadFrames({images[0]}, frameSize).at(0).convertTo(truth, CV_32FC3, 1.0 / 255.0);
+
+        std::vector<Layout> layouts = {
+                centreCropLayout(frameSize, patchSize, 28),
+                sideBySideLayout(frameSize, patchSize),
+        };
+        for (int halo : {8, 12, 16, 28}) {
+            layouts.push_back(featheredLayout(frameSize, patchSize, halo));
+        }
+
+        for (const Layout& layout : layouts) {
+            const int patches = static_cast<int>(layout.xs.size() * layout.ys.size());
+            const double inferred = static_cast<double>(patches) * patchSize * patchSize;
+            const double padding = (1.0 - frameSize.area() / inferred) * 100.0;
+
+            cv::Mat output;
+            double minMs = 0.0;
+            for (int i = 0; i < options.iterations; i++) {
+                double elapsedMs = stitch(layout, truth, patchSize, options.edgeDecay, output);
+                minMs = (i == 0) ? elapsedMs : std::min(minMs, elapsedMs);
+            }
+            double seamMean = 0.0, seamMax = 0.0;
+            seamError(output, truth, seamMean, seamMax);
+            std::printf("%-28s %6dMP %10d %12.1f %12.3f %12.2f %12.1f\n", layout.name.c_str(), megapixels, patches,
+                        padding, seamMean, seamMax, minMs);
+        }
+    }
+    std::printf("peak RSS: %.1f MB\n", bench::peakRssMb());
+    return 0;
+}
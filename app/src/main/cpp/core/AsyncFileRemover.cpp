@@ -0,0 +1,70 @@
+#include "AsyncFileRemover.h"
+
+#include "Log.h"
+
+#include <cstdio>
+
+namespace eagleeye {
+
+AsyncFileRemover& AsyncFileRemover::instance() {
+    static AsyncFileRemover remover;
+    return remover;
+}
+
+AsyncFileRemover::AsyncFileRemover() : worker_(&AsyncFileRemover::run, this) {}
+
+AsyncFileRemover::~AsyncFileRemover() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    queued_.notify_all();
+    worker_.join();
+}
+
+void AsyncFileRemover::remove(const std::string& path) {
+    std::string tombstone;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tombstone = path + ".deleted" + std::to_string(counter_++);
+    }
+    // Free the original name right away; only the slow unlink is deferred.
+    if (std::rename(path.c_str(), tombstone.c_str()) != 0) {
+        std::remove(path.c_str());
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(std::move(tombstone));
+    }
+    queued_.notify_one();
+}
+
+void AsyncFileRemover::drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    emptied_.wait(lock, [this]() { return pending_.empty() && !busy_; });
+}
+
+void AsyncFileRemover::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        queued_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            break; // stopping and nothing left to delete
+        }
+        std::string path = std::move(pending_.front());
+        pending_.pop_front();
+        busy_ = true;
+        lock.unlock();
+        if (std::remove(path.c_str()) != 0) {
+            EE_LOGW("Could not delete %s", path.c_str());
+        }
+        lock.lock();
+        busy_ = false;
+        if (pending_.empty()) {
+            emptied_.notify_all();
+        }
+    }
+}
+
+}  // namespace eagleeye
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace eagleeye {
+
+/*
+ * Deletes files on a background thread so that the merge stages do not wait on unlink().
+ * A file is first renamed to a unique name on the calling thread, so the caller may immediately write a new
+ * file under the same name (the quadrant file names are reused between runs) without it being deleted.
+ */
+class AsyncFileRemover {
+public:
+    static AsyncFileRemover& instance();
+
+    void remove(const std::string& path);
+
+    /*
+     * Blocks until every queued file has been deleted.
+     */
+    void drain();
+
+    ~AsyncFileRemover();
+
+private:
+    AsyncFileRemover();
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable queued_;
+    std::condition_variable emptied_;
+    std::deque<std::string> pending_;
+    unsigned long long counter_ = 0;
+    bool busy_ = false;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
+}  // namespace eagleeye
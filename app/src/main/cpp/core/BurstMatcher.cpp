@@ -0,0 +1,109 @@
+#include "BurstMatcher.h"
+
+#include "Log.h"
+#include "Trace.h"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+namespace eagleeye {
+
+BurstMatcher::BurstMatcher(const BurstMatchOptions& options)
+    : options_(options), pyramidAligner_(options.pyramidOptions) {}
+
+bool BurstMatcher::setReference(const cv::Mat& reference) {
+    EE_TRACE_SCOPE("BurstMatcher::setReference");
+    referenceKeypoints_.clear();
+    referenceDescriptors_.release();
+    if (reference.empty()) {
+        return false;
+    }
+    if (options_.pyramid) {
+        bool ok = pyramidAligner_.setReference(reference);
+        referenceKeypoints_ = pyramidAligner_.referenceKeypoints();
+        EE_LOGD("Number of keypoints detected in reference: %zu", referenceKeypoints_.size());
+        return ok;
+    }
+    cv::ORB::create(options_.maxFeatures)->detectAndCompute(reference, cv::noArray(), referenceKeypoints_,
+                                                             referenceDescriptors_);
+    EE_LOGD("Number of keypoints detected in reference: %zu", referenceKeypoints_.size());
+    return !referenceDescriptors_.empty();
+}
+
+FrameMatches BurstMatcher::matchFrame(const cv::Mat& frame) const {
+    FrameMatches result;
+    if (frame.empty()) {
+        return result;
+    }
+    if (options_.pyramid) {
+        PyramidAligner::Result aligned = pyramidAligner_.align(frame);
+        result.keypoints = std::move(aligned.keypoints);
+        result.matches = std::move(aligned.matches);
+        if (options_.computeHomography) {
+            result.homography = aligned.homography;
+        }
+        return result;
+    }
+
+    // ORB and BFMatcher keep per-call state, so every frame gets its own instances.
+    cv::Mat descriptors;
+    cv::ORB::create(options_.maxFeatures)->detectAndCompute(frame, cv::noArray(), result.keypoints, descriptors);
+    if (referenceDescriptors_.empty() || descriptors.empty()) {
+        EE_LOGE("One or both descriptors are empty. Reference: %d, frame: %d", referenceDescriptors_.rows,
+                descriptors.rows);
+        return result;
+    }
+
+    std::vector<cv::DMatch> matches;
+    cv::BFMatcher(cv::NORM_HAMMING).match(referenceDescriptors_, descriptors, matches);
+    result.matches.reserve(matches.size());
+    for (const cv::DMatch& match : matches) {
+        if (match.distance < options_.maxDistance) {
+            result.matches.push_back(match);
+        }
+    }
+
+    // findHomography needs at least four correspondences.
+    if (options_.computeHomography && result.matches.size() >= 4) {
+        std::vector<cv::Point2f> framePoints, referencePoints;
+        framePoints.reserve(result.matches.size());
+        referencePoints.reserve(result.matches.size());
+        for (const cv::DMatch& match : result.matches) {
+            referencePoints.push_back(referenceKeypoints_[match.queryIdx].pt);
+            framePoints.push_back(result.keypoints[match.trainIdx].pt);
+        }
+        result.homography = cv::findHomography(framePoints, referencePoints, cv::RANSAC, options_.ransacThreshold);
+    }
+    return result;
+}
+
+std::vector<FrameMatches> BurstMatcher::matchFiles(const std::vector<std::string>& framePaths) const {
+    EE_TRACE_SCOPE("BurstMatcher::matchFiles");
+    std::vector<FrameMatches> results(framePaths.size());
+    cv::parallel_for_(cv::Range(0, static_cast<int>(framePaths.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            EE_TRACE_SCOPE("BurstMatcher::frame");
+            cv::Mat frame = cv::imread(framePaths[i]);
+            if (frame.empty()) {
+                EE_LOGE("Could not read burst frame %s", framePaths[i].c_str());
+                continue;
+            }
+            trace::countImageRead(framePaths[i]);
+            results[i] = matchFrame(frame);
+        }
+    }, static_cast<double>(framePaths.size()));
+    return results;
+}
+
+std::vector<FrameMatches> BurstMatcher::matchFrames(const std::vector<cv::Mat>& frames) const {
+    EE_TRACE_SCOPE("BurstMatcher::matchFrames");
+    std::vector<FrameMatches> results(frames.size());
+    cv::parallel_for_(cv::Range(0, static_cast<int>(frames.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            results[i] = matchFrame(frames[i]);
+        }
+    }, static_cast<double>(frames.size()));
+    return results;
+}
+
+}  // namespace eagleeye
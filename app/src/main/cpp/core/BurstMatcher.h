@@ -0,0 +1,63 @@
+#pragma once
+
+#include "PyramidAligner.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <string>
+#include <vector>
+
+namespace eagleeye {
+
+struct BurstMatchOptions {
+    int maxFeatures = 500;          // ORB::create default, same as FeatureMatchingOperator
+    float maxDistance = 999.0f;     // matches at or above this Hamming distance are dropped
+    bool computeHomography = true;  // RANSAC homography from each frame to the reference
+    double ransacThreshold = 1.0;   // reprojection threshold in pixels, as LRWarpingOperator uses
+    bool pyramid = false;           // coarse-to-fine estimation with PyramidAligner instead of full-res ORB
+    PyramidAlignOptions pyramidOptions;
+};
+
+/*
+ * Matches of one burst frame against the reference. queryIdx indexes the reference keypoints, trainIdx the
+ * frame keypoints. homography maps frame coordinates to reference coordinates and is empty if it could not be
+ * estimated (or was not requested).
+ */
+struct FrameMatches {
+    std::vector<cv::KeyPoint> keypoints;
+    std::vector<cv::DMatch> matches;
+    cv::Mat homography;
+};
+
+/*
+ * Native counterpart of FeatureMatchingOperator: ORB features of the reference are computed once, then every
+ * burst frame is decoded, described and brute-force Hamming matched against them on OpenCV's worker pool.
+ * Frames that cannot be read come back with no keypoints and no matches.
+ *
+ * With options.pyramid the matching runs on a 1/4 scale level and the homography is refined on the 1/2 scale
+ * level (see PyramidAligner); keypoints and matches are then the coarse ones, scaled to full resolution.
+ */
+class BurstMatcher {
+public:
+    explicit BurstMatcher(const BurstMatchOptions& options = BurstMatchOptions());
+
+    /*
+     * Detects and describes the reference frame. Returns false if no descriptors were found.
+     */
+    bool setReference(const cv::Mat& reference);
+
+    const std::vector<cv::KeyPoint>& referenceKeypoints() const { return referenceKeypoints_; }
+
+    std::vector<FrameMatches> matchFiles(const std::vector<std::string>& framePaths) const;
+    std::vector<FrameMatches> matchFrames(const std::vector<cv::Mat>& frames) const;
+
+private:
+    FrameMatches matchFrame(const cv::Mat& frame) const;
+
+    BurstMatchOptions options_;
+    std::vector<cv::KeyPoint> referenceKeypoints_;
+    cv::Mat referenceDescriptors_;
+    PyramidAligner pyramidAligner_;
+};
+
+}  // namespace eagleeye
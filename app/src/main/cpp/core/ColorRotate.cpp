@@ -0,0 +1,131 @@
+#include "ColorRotate.h"
+
+#include "Log.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+namespace eagleeye {
+
+namespace {
+
+// Destination pixels are visited in square blocks so that the strided source reads of a 90 degree rotation
+// stay within a few cache lines.
+constexpr int kBlockSize = 64;
+
+/*
+ * Walks every destination pixel, finds the source pixel it comes from under the rotation and hands both to
+ * convertPixel(src, dst). The rotation is a template parameter so the index math is resolved at compile time.
+ */
+template <Rotation rotation, typename ConvertPixel>
+void rotateConvert(const cv::Mat& src, cv::Mat& dst, ConvertPixel convertPixel) {
+    const int srcRows = src.rows;
+    const int srcCols = src.cols;
+    const size_t srcPixel = src.elemSize();
+    const size_t dstPixel = dst.elemSize();
+    const int blockRows = (dst.rows + kBlockSize - 1) / kBlockSize;
+
+    cv::parallel_for_(cv::Range(0, blockRows), [&](const cv::Range& range) {
+        for (int by = range.start; by < range.end; by++) {
+            const int y0 = by * kBlockSize;
+            const int y1 = std::min(y0 + kBlockSize, dst.rows);
+            for (int x0 = 0; x0 < dst.cols; x0 += kBlockSize) {
+                const int x1 = std::min(x0 + kBlockSize, dst.cols);
+                for (int y = y0; y < y1; y++) {
+                    uchar* out = dst.ptr<uchar>(y) + x0 * dstPixel;
+                    for (int x = x0; x < x1; x++, out += dstPixel) {
+                        int sy = y;
+                        int sx = x;
+                        if (rotation == Rotation::Clockwise90) {
+                            sy = srcRows - 1 - x;
+                            sx = y;
+                        } else if (rotation == Rotation::Rotate180) {
+                            sy = srcRows - 1 - y;
+                            sx = srcCols - 1 - x;
+                        } else if (rotation == Rotation::CounterClockwise90) {
+                            sy = x;
+                            sx = srcCols - 1 - y;
+                        }
+                        convertPixel(src.ptr<uchar>(sy) + sx * srcPixel, out);
+                    }
+                }
+            }
+        }
+    });
+}
+
+template <typename ConvertPixel>
+void rotateConvert(const cv::Mat& src, cv::Mat& dst, Rotation rotation, ConvertPixel convertPixel) {
+    switch (rotation) {
+        case Rotation::None:
+            rotateConvert<Rotation::None>(src, dst, convertPixel);
+            break;
+        case Rotation::Clockwise90:
+            rotateConvert<Rotation::Clockwise90>(src, dst, convertPixel);
+            break;
+        case Rotation::Rotate180:
+            rotateConvert<Rotation::Rotate180>(src, dst, convertPixel);
+            break;
+        case Rotation::CounterClockwise90:
+            rotateConvert<Rotation::CounterClockwise90>(src, dst, convertPixel);
+            break;
+    }
+}
+
+}  // namespace
+
+cv::Size rotatedSize(cv::Size size, Rotation rotation) {
+    if (rotation == Rotation::Clockwise90 || rotation == Rotation::CounterClockwise90) {
+        return cv::Size(size.height, size.width);
+    }
+    return size;
+}
+
+void rgbaToBgr(const cv::Mat& rgba, cv::Mat& dst, Rotation rotation) {
+    EE_TRACE_SCOPE("rgbaToBgr");
+    CV_Assert(rgba.type() == CV_8UC4);
+    dst.create(rotatedSize(rgba.size(), rotation), CV_8UC3);
+    rotateConvert(rgba, dst, rotation, [](const uchar* in, uchar* out) {
+        out[0] = in[2];
+        out[1] = in[1];
+        out[2] = in[0];
+    });
+}
+
+bool bgrToRgba(const cv::Mat& src, cv::Mat& dst, Rotation rotation) {
+    EE_TRACE_SCOPE("bgrToRgba");
+    if (src.depth() != CV_8U || dst.type() != CV_8UC4 || dst.size() != rotatedSize(src.size(), rotation)) {
+        EE_LOGE("bgrToRgba: cannot write %dx%d type %d into %dx%d type %d", src.cols, src.rows, src.type(),
+                dst.cols, dst.rows, dst.type());
+        return false;
+    }
+    switch (src.channels()) {
+        case 1:
+            rotateConvert(src, dst, rotation, [](const uchar* in, uchar* out) {
+                out[0] = out[1] = out[2] = in[0];
+                out[3] = 255;
+            });
+            return true;
+        case 3:
+            rotateConvert(src, dst, rotation, [](const uchar* in, uchar* out) {
+                out[0] = in[2];
+                out[1] = in[1];
+                out[2] = in[0];
+                out[3] = 255;
+            });
+            return true;
+        case 4:
+            rotateConvert(src, dst, rotation, [](const uchar* in, uchar* out) {
+                out[0] = in[2];
+                out[1] = in[1];
+                out[2] = in[0];
+                out[3] = in[3];
+            });
+            return true;
+        default:
+            EE_LOGE("bgrToRgba: unsupported channel count %d", src.channels());
+            return false;
+    }
+}
+
+}  // namespace eagleeye
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+namespace eagleeye {
+
+/*
+ * Rotation applied while converting. The numeric values are shared with ImageOperator on the Kotlin side.
+ */
+enum class Rotation {
+    None = 0,
+    Clockwise90 = 1,
+    Rotate180 = 2,
+    CounterClockwise90 = 3,
+};
+
+/*
+ * Size of the image produced by rotating an image of the given size.
+ */
+cv::Size rotatedSize(cv::Size size, Rotation rotation);
+
+/*
+ * Fused RGBA (8UC4, Android Bitmap layout) -> BGR (8UC3) conversion and rotation in a single pass.
+ * dst is allocated if it does not already have the rotated size and type.
+ */
+void rgbaToBgr(const cv::Mat& rgba, cv::Mat& dst, Rotation rotation);
+
+/*
+ * Fused BGR/gray/BGRA (8UC3/8UC1/8UC4) -> RGBA (8UC4, opaque) conversion and rotation in a single pass.
+ * dst must already have the rotated size and type CV_8UC4, for example a Mat header over a locked Bitmap.
+ * Returns false if it does not.
+ */
+bool bgrToRgba(const cv::Mat& src, cv::Mat& dst, Rotation rotation);
+
+}  // namespace eagleeye
@@ -0,0 +1,118 @@
+#include "EdgeMeasure.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace eagleeye {
+
+namespace {
+
+constexpr int kStripeRows = 64;
+
+// Fixed-point BGR -> gray weights of cv::cvtColor, as produceMask applies them to the edge image.
+constexpr int kGrayShift = 14;
+constexpr int kGrayB = 1868;
+constexpr int kGrayG = 9617;
+constexpr int kGrayR = 4899;
+
+inline int reflect(int index, int length) {
+    return cv::borderInterpolate(index, length, cv::BORDER_REFLECT_101);
+}
+
+/*
+ * Row y of blur3x3(a + b), rounded as the 16-bit box filter rounds: sums are never a multiple of 9 plus a
+ * half, so (sum + 4) / 9 is cvRound(sum / 9.0).
+ */
+void blurredRow(const cv::Mat& a, const cv::Mat& b, int y, std::vector<int>& columnSums, short* out) {
+    const int channels = a.channels();
+    const int width = a.cols * channels;
+    const bool hasB = !b.empty();
+    columnSums.assign(width, 0);
+    for (int dy = -1; dy <= 1; dy++) {
+        int row = reflect(y + dy, a.rows);
+        const uchar* pa = a.ptr<uchar>(row);
+        for (int i = 0; i < width; i++) {
+            columnSums[i] += pa[i];
+        }
+        if (hasB) {
+            const uchar* pb = b.ptr<uchar>(row);
+            for (int i = 0; i < width; i++) {
+                columnSums[i] += pb[i];
+            }
+        }
+    }
+    for (int x = 0; x < a.cols; x++) {
+        int left = reflect(x - 1, a.cols) * channels;
+        int right = reflect(x + 1, a.cols) * channels;
+        for (int c = 0; c < channels; c++) {
+            int sum = columnSums[left + c] + columnSums[x * channels + c] + columnSums[right + c];
+            out[x * channels + c] = static_cast<short>((sum + 4) / 9);
+        }
+    }
+}
+
+/*
+ * saturate_cast<uchar>(0.5f * gx + 0.5f * gy) of the 8-bit gradients, round-half-even like cvRound.
+ */
+inline int meanGradient(int gx, int gy) {
+    int sum = std::min(std::max(gx, 0), 255) + std::min(std::max(gy, 0), 255);
+    int half = sum >> 1;
+    return half + ((sum & 1) & (half & 1));
+}
+
+}  // namespace
+
+int edgeSobelCount(const cv::Mat& a, const cv::Mat& b, const cv::Rect& crop) {
+    CV_Assert(a.depth() == CV_8U && a.channels() <= 4);
+    CV_Assert(b.empty() || (b.size() == a.size() && b.type() == a.type()));
+    const int channels = a.channels();
+    const int width = a.cols * channels;
+
+    // Blurred rows crop.y - 1 .. crop.y + crop.height, reflected like the Sobel reads them.
+    std::vector<short> blurred(static_cast<size_t>(crop.height + 2) * width);
+    std::vector<int> columnSums;
+    for (int j = 0; j < crop.height + 2; j++) {
+        blurredRow(a, b, reflect(crop.y - 1 + j, a.rows), columnSums, blurred.data() + static_cast<size_t>(j) * width);
+    }
+
+    int count = 0;
+    int gradient[4] = {0, 0, 0, 0};
+    for (int y = 0; y < crop.height; y++) {
+        const short* above = blurred.data() + static_cast<size_t>(y) * width;
+        const short* center = above + width;
+        const short* below = center + width;
+        for (int x = crop.x; x < crop.x + crop.width; x++) {
+            int left = reflect(x - 1, a.cols) * channels;
+            int right = reflect(x + 1, a.cols) * channels;
+            int mid = x * channels;
+            for (int c = 0; c < channels; c++) {
+                int gx = (above[right + c] - above[left + c]) + 2 * (center[right + c] - center[left + c]) +
+                         (below[right + c] - below[left + c]);
+                int gy = (below[left + c] + 2 * below[mid + c] + below[right + c]) -
+                         (above[left + c] + 2 * above[mid + c] + above[right + c]);
+                gradient[c] = meanGradient(gx, gy);
+            }
+            int gray = channels >= 3
+                       ? (gradient[0] * kGrayB + gradient[1] * kGrayG + gradient[2] * kGrayR +
+                          (1 << (kGrayShift - 1))) >> kGrayShift
+                       : gradient[0];
+            count += gray > 1 ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+int edgeSobelMeasure(const cv::Mat& a, const cv::Mat& b) {
+    std::atomic<int> count{0};
+    int stripes = (a.rows + kStripeRows - 1) / kStripeRows;
+    cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; s++) {
+            int y = s * kStripeRows;
+            count += edgeSobelCount(a, b, cv::Rect(0, y, a.cols, std::min(kStripeRows, a.rows - y)));
+        }
+    });
+    return count;
+}
+
+}  // namespace eagleeye
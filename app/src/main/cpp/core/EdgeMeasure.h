@@ -0,0 +1,24 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+namespace eagleeye {
+
+/*
+ * ImageOperator.edgeSobelMeasure(a + b, applyBlur = true) for 8-bit images a and b of the same size and type
+ * (1 to 4 channels; b may be empty): 3x3 box blur, Sobel x and y saturated to 8 bits, their rounded mean,
+ * produceMask, countNonZero. Computed in one streaming pass with a three-row window of the blurred sum, so
+ * neither the 16-bit sum nor any of the intermediate images exist. Bit-exact with the Kotlin chain
+ * (reflect-101 borders, OpenCV rounding).
+ *
+ * Only pixels inside crop are counted; the borders are those of a, so crop needs a 2 pixel margin to the edge
+ * of a wherever a is a view into a larger image.
+ */
+int edgeSobelCount(const cv::Mat& a, const cv::Mat& b, const cv::Rect& crop);
+
+/*
+ * edgeSobelCount over the whole image, split into row stripes on OpenCV's worker pool.
+ */
+int edgeSobelMeasure(const cv::Mat& a, const cv::Mat& b = cv::Mat());
+
+}  // namespace eagleeye
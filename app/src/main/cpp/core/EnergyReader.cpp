@@ -0,0 +1,27 @@
+#include "EnergyReader.h"
+
+#include "Log.h"
+#include "Trace.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+namespace eagleeye {
+
+std::vector<cv::Mat> readEnergy(const std::vector<std::string>& paths) {
+    EE_TRACE_SCOPE("readEnergy");
+    std::vector<cv::Mat> energy(paths.size());
+    cv::parallel_for_(cv::Range(0, static_cast<int>(paths.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            EE_TRACE_SCOPE("readEnergy::frame");
+            energy[i] = cv::imread(paths[i], cv::IMREAD_REDUCED_GRAYSCALE_8);
+            if (energy[i].empty()) {
+                EE_LOGE("Could not read %s for energy", paths[i].c_str());
+                continue;
+            }
+            trace::countImageRead(paths[i]);
+        }
+    }, static_cast<double>(paths.size()));
+    return energy;
+}
+
+}  // namespace eagleeye
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+namespace eagleeye {
+
+/*
+ * Native counterpart of InputImageEnergyReader: the 1/8 scale luminance of each burst frame. JPEGs are decoded
+ * with libjpeg's DCT-domain 1/8 scaling straight to gray (IMREAD_REDUCED_GRAYSCALE_8), so the full-resolution
+ * image is never materialised. Other formats are decoded at full size and shrunk by imread's own bilinear resize
+ * (INTER_LINEAR_EXACT), not the INTER_AREA that InputImageEnergyReader uses, so their energy can differ slightly.
+ * All files are decoded in parallel on OpenCV's worker pool.
+ *
+ * Returns one CV_8UC1 Mat per path, empty where the file could not be read.
+ */
+std::vector<cv::Mat> readEnergy(const std::vector<std::string>& paths);
+
+}  // namespace eagleeye
@@ -0,0 +1,255 @@
+#include "FrameStore.h"
+
+#include "AsyncFileRemover.h"
+#include "Log.h"
+#include "Trace.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+
+namespace eagleeye {
+
+namespace {
+
+// Spill files are a three int header (rows, cols, type) followed by the pixel rows.
+bool writeRaw(const std::string& path, const cv::Mat& frame) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    int32_t header[3] = {frame.rows, frame.cols, frame.type()};
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    const std::streamsize rowBytes = static_cast<std::streamsize>(frame.cols * frame.elemSize());
+    for (int y = 0; y < frame.rows && out; y++) {
+        out.write(frame.ptr<char>(y), rowBytes);
+    }
+    return static_cast<bool>(out);
+}
+
+cv::Mat readRaw(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    int32_t header[3] = {0, 0, 0};
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] <= 0 || header[1] <= 0) {
+        return cv::Mat();
+    }
+    cv::Mat frame(header[0], header[1], header[2]);
+    if (!in.read(frame.ptr<char>(), static_cast<std::streamsize>(frame.total() * frame.elemSize()))) {
+        return cv::Mat();
+    }
+    return frame;
+}
+
+}  // namespace
+
+FrameStore& FrameStore::instance() {
+    // Never destroyed, like MatPool: views may outlive static destruction order.
+    static FrameStore* store = new FrameStore();
+    return *store;
+}
+
+void FrameStore::configure(int64_t budgetBytes, const std::string& spillDirectory) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    budgetBytes_ = budgetBytes;
+    spillDirectory_ = spillDirectory;
+    enforceBudget(lock);
+}
+
+void FrameStore::registerFrame(int index, const std::string& path) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Entry& entry = entries_[index];
+    idle_.wait(lock, [&entry]() { return !entry.busy; });
+    if (!entry.spillPath.empty()) {
+        AsyncFileRemover::instance().remove(entry.spillPath);
+    }
+    entry = Entry();
+    entry.path = path;
+}
+
+void FrameStore::putFrame(int index, const cv::Mat& frame) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Entry& entry = entries_[index];
+    idle_.wait(lock, [&entry]() { return !entry.busy; });
+    if (!entry.spillPath.empty()) {
+        AsyncFileRemover::instance().remove(entry.spillPath);
+        entry.spillPath.clear();
+    }
+    entry.frame = frame;
+    entry.lastUse = ++clock_;
+    enforceBudget(lock);
+}
+
+cv::Mat FrameStore::acquire(int index) {
+    EE_TRACE_SCOPE("FrameStore::acquire");
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto found = entries_.find(index);
+    if (found == entries_.end()) {
+        EE_LOGE("FrameStore: frame %d was never registered", index);
+        return cv::Mat();
+    }
+    Entry& entry = found->second;
+    idle_.wait(lock, [&entry]() { return !entry.busy; });
+    if (entry.frame.empty()) {
+        if (load(index, entry, lock).empty()) {
+            return cv::Mat();
+        }
+    } else {
+        stats_.hits++;
+    }
+    entry.pins++;
+    entry.lastUse = ++clock_;
+    cv::Mat view = entry.frame;
+    enforceBudget(lock);
+    return view;
+}
+
+void FrameStore::release(int index) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto found = entries_.find(index);
+    if (found == entries_.end() || found->second.pins == 0) {
+        EE_LOGW("FrameStore: release of frame %d without acquire", index);
+        return;
+    }
+    found->second.pins--;
+    enforceBudget(lock);
+}
+
+void FrameStore::clear() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]() {
+        return std::none_of(entries_.begin(), entries_.end(),
+                            [](const std::pair<const int, Entry>& item) { return item.second.busy; });
+    });
+    for (const auto& item : entries_) {
+        if (!item.second.spillPath.empty()) {
+            AsyncFileRemover::instance().remove(item.second.spillPath);
+        }
+    }
+    entries_.clear();
+    EE_LOGD("FrameStore cleared: %lld decodes, %lld hits, %lld spills, %lld reloads",
+            static_cast<long long>(stats_.decodes), static_cast<long long>(stats_.hits),
+            static_cast<long long>(stats_.spills), static_cast<long long>(stats_.reloads));
+    stats_ = FrameStoreStats();
+}
+
+FrameStoreStats FrameStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FrameStoreStats stats = stats_;
+    for (const auto& item : entries_) {
+        stats.bytesResident += residentBytes(item.second);
+    }
+    return stats;
+}
+
+int64_t FrameStore::residentBytes(const Entry& entry) {
+    return static_cast<int64_t>(entry.frame.total() * entry.frame.elemSize());
+}
+
+/*
+ * Reads a frame that is not resident, from its spill file if it has one, else from its capture file.
+ * Called with the lock held and the entry idle; returns with the lock held.
+ */
+cv::Mat FrameStore::load(int index, Entry& entry, std::unique_lock<std::mutex>& lock) {
+    entry.busy = true;
+    const std::string path = entry.path;
+    const std::string spillPath = entry.spillPath;
+    lock.unlock();
+
+    cv::Mat frame;
+    bool reloaded = false;
+    if (!spillPath.empty()) {
+        EE_TRACE_SCOPE("FrameStore::reload");
+        frame = readRaw(spillPath);
+        reloaded = !frame.empty();
+        EE_TRACE_COUNT(trace::Counter::BytesRead, static_cast<int64_t>(frame.total() * frame.elemSize()));
+    }
+    if (frame.empty() && !path.empty()) {
+        EE_TRACE_SCOPE("FrameStore::decode");
+        frame = cv::imread(path, cv::IMREAD_COLOR);
+        if (!frame.empty()) {
+            trace::countImageRead(path);
+        }
+    }
+
+    lock.lock();
+    entry.busy = false;
+    idle_.notify_all();
+    if (frame.empty()) {
+        EE_LOGE("FrameStore: could not read frame %d (%s)", index, path.c_str());
+        return frame;
+    }
+    if (reloaded) {
+        stats_.reloads++;
+    } else {
+        stats_.decodes++;
+    }
+    entry.frame = frame;
+    return frame;
+}
+
+/*
+ * Evicts least recently used, unpinned frames until the resident bytes fit the budget. Called and returns with
+ * the lock held; spill files are written with it released.
+ */
+void FrameStore::enforceBudget(std::unique_lock<std::mutex>& lock) {
+    std::set<int> kept;  // frames that can neither be spilled nor decoded again
+    for (;;) {
+        int64_t resident = 0;
+        int victimIndex = -1;
+        uint64_t oldest = UINT64_MAX;
+        for (const auto& item : entries_) {
+            const Entry& entry = item.second;
+            resident += residentBytes(entry);
+            if (entry.pins == 0 && !entry.busy && !entry.frame.empty() && entry.lastUse < oldest &&
+                kept.count(item.first) == 0) {
+                oldest = entry.lastUse;
+                victimIndex = item.first;
+            }
+        }
+        if (resident <= budgetBytes_) {
+            return;
+        }
+        if (victimIndex < 0) {
+            EE_LOGW("FrameStore: %lld bytes resident over a %lld byte budget, all of it pinned",
+                    static_cast<long long>(resident), static_cast<long long>(budgetBytes_));
+            return;
+        }
+
+        Entry& victim = entries_[victimIndex];
+        // Frames never change, so an existing spill file is still valid.
+        if (!victim.spillPath.empty() || (spillDirectory_.empty() && !victim.path.empty())) {
+            victim.frame.release();
+            continue;
+        }
+        if (spillDirectory_.empty()) {
+            kept.insert(victimIndex);
+            continue;
+        }
+
+        cv::Mat frame = victim.frame;
+        std::string spillPath = spillDirectory_ + "/frame_" + std::to_string(victimIndex) + ".raw";
+        victim.busy = true;
+        victim.frame.release();
+        lock.unlock();
+        bool written;
+        {
+            EE_TRACE_SCOPE("FrameStore::spill");
+            written = writeRaw(spillPath, frame);
+        }
+        lock.lock();
+        victim.busy = false;
+        idle_.notify_all();
+        if (written) {
+            victim.spillPath = spillPath;
+            stats_.spills++;
+            EE_TRACE_COUNT(trace::Counter::BytesWritten, static_cast<int64_t>(frame.total() * frame.elemSize()));
+        } else {
+            EE_LOGE("FrameStore: could not spill frame %d to %s", victimIndex, spillPath.c_str());
+            if (victim.path.empty()) {
+                victim.frame = frame;
+                kept.insert(victimIndex);
+            }
+        }
+    }
+}
+
+}  // namespace eagleeye
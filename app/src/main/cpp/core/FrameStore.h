@@ -0,0 +1,93 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eagleeye {
+
+struct FrameStoreStats {
+    int64_t decodes = 0;        // frames decoded from their capture file
+    int64_t hits = 0;           // acquires served from memory
+    int64_t spills = 0;         // frames written to the spill directory to stay under the budget
+    int64_t reloads = 0;        // frames read back from the spill directory
+    int64_t bytesResident = 0;  // frames currently held by the store
+};
+
+/*
+ * Decoded burst frames keyed by capture index, shared by every stage of a super-resolution run so that each
+ * capture is decoded once instead of once per stage.
+ *
+ * Frames are registered with their file and decoded on the first acquire(). acquire() pins a frame and returns
+ * a view of it that shares its buffer; release() unpins it. When the resident frames exceed the budget, the
+ * least recently used unpinned frames are written to the spill directory as raw pixels, which read back much
+ * faster than the JPEG decodes. Without a spill directory they are just dropped and decoded again when needed.
+ *
+ * The budget covers the store's own references only: a view a caller still holds keeps its buffer alive after
+ * the store has let go of it. Thread safe; frames are decoded and spilled outside the lock.
+ */
+class FrameStore {
+public:
+    static FrameStore& instance();
+
+    /*
+     * Memory budget for resident frames and the directory for spill files. An empty directory disables spilling.
+     */
+    void configure(int64_t budgetBytes, const std::string& spillDirectory);
+
+    /*
+     * Registers the capture file of a frame. Re-registering an index drops what was held for it.
+     */
+    void registerFrame(int index, const std::string& path);
+
+    /*
+     * Hands an already decoded frame to the store, e.g. straight from capture. The store keeps a reference,
+     * not a copy.
+     */
+    void putFrame(int index, const cv::Mat& frame);
+
+    /*
+     * Pins the frame and returns a view of it, decoding or reloading it if needed. Returns an empty Mat (and
+     * pins nothing) if the index is unknown or the frame cannot be read.
+     */
+    cv::Mat acquire(int index);
+
+    void release(int index);
+
+    /*
+     * Drops every frame and deletes the spill files.
+     */
+    void clear();
+
+    FrameStoreStats stats() const;
+
+private:
+    struct Entry {
+        std::string path;
+        std::string spillPath;         // non-empty once the frame has been spilled
+        cv::Mat frame;                 // empty while not resident
+        int pins = 0;
+        uint64_t lastUse = 0;
+        bool busy = false;             // being decoded, reloaded or spilled outside the lock
+    };
+
+    FrameStore() = default;
+
+    static int64_t residentBytes(const Entry& entry);
+    cv::Mat load(int index, Entry& entry, std::unique_lock<std::mutex>& lock);
+    void enforceBudget(std::unique_lock<std::mutex>& lock);
+
+    mutable std::mutex mutex_;
+    std::condition_variable idle_;
+    std::map<int, Entry> entries_;
+    FrameStoreStats stats_;
+    int64_t budgetBytes_ = 512ll * 1024 * 1024;
+    std::string spillDirectory_;
+    uint64_t clock_ = 0;
+};
+
+}  // namespace eagleeye
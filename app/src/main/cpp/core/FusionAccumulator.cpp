@@ -0,0 +1,136 @@
+#include "FusionAccumulator.h"
+
+#include "Log.h"
+#include "Trace.h"
+
+#include <opencv2/imgproc.hpp>
+
+namespace eagleeye {
+
+namespace {
+
+// Fixed-point BGR -> gray weights used by cv::cvtColor, so the hole mask matches produceMask exactly.
+constexpr int kGrayShift = 14;
+constexpr int kGrayB = 1868;
+constexpr int kGrayG = 9617;
+constexpr int kGrayR = 4899;
+
+inline int grayValue(const uchar* pixel, int channels) {
+    if (channels < 3) {
+        return pixel[0];
+    }
+    return (pixel[0] * kGrayB + pixel[1] * kGrayG + pixel[2] * kGrayR + (1 << (kGrayShift - 1))) >> kGrayShift;
+}
+
+}  // namespace
+
+void FusionAccumulator::begin(cv::Size frameSize, double scale, int channels) {
+    frameSize_ = frameSize;
+    scale_ = scale > 0.0 ? scale : 1.0;
+    channels_ = channels;
+    frameCount_ = 0;
+    cv::Size outputSize(cvRound(frameSize.width * scale_), cvRound(frameSize.height * scale_));
+    sum_.create(outputSize, CV_16UC(channels));
+    sum_.setTo(cv::Scalar::all(0));
+    count_.create(outputSize, CV_8UC1);
+    count_.setTo(cv::Scalar::all(0));
+    scaled_.release();
+}
+
+bool FusionAccumulator::add(const cv::Mat& frame) {
+    EE_TRACE_SCOPE("FusionAccumulator::add");
+    if (!isActive()) {
+        EE_LOGE("FusionAccumulator::add called before begin()");
+        return false;
+    }
+    if (frame.size() != frameSize_ || frame.channels() != channels_) {
+        EE_LOGE("FusionAccumulator::add frame is %dx%dx%d, expected %dx%dx%d", frame.cols, frame.rows,
+                frame.channels(), frameSize_.width, frameSize_.height, channels_);
+        return false;
+    }
+
+    cv::Mat frame8u = frame;
+    if (frame.depth() != CV_8U) {
+        frame.convertTo(frame8u, CV_8UC(channels_));
+    }
+    if (scale_ != 1.0) {
+        cv::resize(frame8u, scaled_, sum_.size(), 0.0, 0.0, cv::INTER_CUBIC);
+        accumulate(scaled_);
+    } else {
+        accumulate(frame8u);
+    }
+    frameCount_++;
+    return true;
+}
+
+bool FusionAccumulator::addRegion(const cv::Mat& region, cv::Point origin) {
+    if (!isActive() || scale_ != 1.0) {
+        EE_LOGE("FusionAccumulator::addRegion needs an active accumulator with scale 1");
+        return false;
+    }
+    if (region.type() != CV_8UC(channels_) ||
+        (cv::Rect(origin, region.size()) & cv::Rect(cv::Point(), sum_.size())) != cv::Rect(origin, region.size())) {
+        EE_LOGE("FusionAccumulator::addRegion %dx%d at (%d, %d) does not fit", region.cols, region.rows, origin.x,
+                origin.y);
+        return false;
+    }
+    accumulateRows(region, origin, 0, region.rows);
+    return true;
+}
+
+void FusionAccumulator::accumulate(const cv::Mat& frame) {
+    cv::parallel_for_(cv::Range(0, frame.rows), [&](const cv::Range& range) {
+        accumulateRows(frame, cv::Point(), range.start, range.end);
+    });
+}
+
+void FusionAccumulator::accumulateRows(const cv::Mat& frame, cv::Point origin, int rowBegin, int rowEnd) {
+    const int channels = channels_;
+    const int cols = frame.cols;
+    for (int y = rowBegin; y < rowEnd; y++) {
+        const uchar* src = frame.ptr<uchar>(y);
+        ushort* sum = sum_.ptr<ushort>(origin.y + y) + origin.x * channels;
+        uchar* count = count_.ptr<uchar>(origin.y + y) + origin.x;
+        for (int x = 0; x < cols; x++, src += channels, sum += channels) {
+            if (grayValue(src, channels) <= 1) {
+                continue; // hole, leave the pixel out of the mean
+            }
+            for (int c = 0; c < channels; c++) {
+                sum[c] = cv::saturate_cast<ushort>(sum[c] + src[c]);
+            }
+            count[x] = cv::saturate_cast<uchar>(count[x] + 1);
+        }
+    }
+}
+
+cv::Mat FusionAccumulator::finish() {
+    EE_TRACE_SCOPE("FusionAccumulator::finish");
+    if (!isActive()) {
+        return cv::Mat();
+    }
+    cv::Mat output(sum_.size(), CV_8UC(channels_));
+    const int channels = channels_;
+    const int cols = sum_.cols;
+    cv::parallel_for_(cv::Range(0, sum_.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const ushort* sum = sum_.ptr<ushort>(y);
+            const uchar* count = count_.ptr<uchar>(y);
+            uchar* dst = output.ptr<uchar>(y);
+            for (int x = 0; x < cols; x++, sum += channels, dst += channels) {
+                int n = count[x];
+                for (int c = 0; c < channels; c++) {
+                    dst[c] = n > 0 ? cv::saturate_cast<uchar>((sum[c] + n / 2) / n) : 0;
+                }
+            }
+        }
+    });
+
+    EE_LOGI("Mean fusion of %d frame(s) completed.", frameCount_);
+    sum_.release();
+    count_.release();
+    scaled_.release();
+    frameCount_ = 0;
+    return output;
+}
+
+}  // namespace eagleeye
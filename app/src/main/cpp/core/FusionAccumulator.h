@@ -0,0 +1,58 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+namespace eagleeye {
+
+/*
+ * Streaming masked mean fusion. Frames are folded into a 16-bit sum buffer and a per-pixel count buffer as
+ * soon as they are available, so only the accumulator and the frame being added need to be resident.
+ * Black pixels (gray value <= 1, the same rule as produceMask) are treated as holes left by warping and are
+ * not counted. At most 255 frames can be accumulated per pixel.
+ *
+ * Usage: begin(size, scale) -> add(frame) for every frame -> finish().
+ */
+class FusionAccumulator {
+public:
+    /*
+     * Starts a new fusion. frameSize is the size of the frames that will be added; the fused output is
+     * frameSize * scale, with frames resized (bicubic) onto that grid when scale != 1.
+     */
+    void begin(cv::Size frameSize, double scale, int channels = 3);
+
+    /*
+     * Adds an 8-bit frame with the size and channel count given to begin(). Returns false if it does not match.
+     */
+    bool add(const cv::Mat& frame);
+
+    /*
+     * Adds an 8-bit region of a frame whose top-left corner lands at origin in the output. Only valid with
+     * scale 1. Regions that do not overlap can be added from different threads; call endFrame() once all
+     * regions of a frame are in.
+     */
+    bool addRegion(const cv::Mat& region, cv::Point origin);
+    void endFrame() { frameCount_++; }
+
+    /*
+     * Returns the per-pixel mean as an 8-bit image and releases the accumulation buffers.
+     */
+    cv::Mat finish();
+
+    bool isActive() const { return !sum_.empty(); }
+    int frameCount() const { return frameCount_; }
+    cv::Size outputSize() const { return sum_.size(); }
+
+private:
+    void accumulate(const cv::Mat& frame);
+    void accumulateRows(const cv::Mat& frame, cv::Point origin, int rowBegin, int rowEnd);
+
+    cv::Size frameSize_;
+    double scale_ = 1.0;
+    int channels_ = 3;
+    int frameCount_ = 0;
+    cv::Mat sum_;      // CV_16UC(channels)
+    cv::Mat count_;    // CV_8UC1
+    cv::Mat scaled_;   // scratch buffer for frames resized to the output grid
+};
+
+}  // namespace eagleeye
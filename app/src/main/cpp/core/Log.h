@@ -0,0 +1,26 @@
+#pragma once
+
+// Logging for the JNI-free core. On device the messages go to logcat under the
+// same tag as the JNI layer; on a host build they are written to stderr so the
+// benchmark tools can be run from a terminal.
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define EE_LOG_TAG "EagleEyeJNI"
+#define EE_LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, EE_LOG_TAG, __VA_ARGS__)
+#define EE_LOGI(...) __android_log_print(ANDROID_LOG_INFO, EE_LOG_TAG, __VA_ARGS__)
+#define EE_LOGW(...) __android_log_print(ANDROID_LOG_WARN, EE_LOG_TAG, __VA_ARGS__)
+#define EE_LOGE(...) __android_log_print(ANDROID_LOG_ERROR, EE_LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define EE_LOG_PRINT(level, ...) \
+    do { std::fprintf(stderr, level "/EagleEye: " __VA_ARGS__); std::fputc('\n', stderr); } while (0)
+#ifdef NDEBUG
+#define EE_LOGD(...) do { } while (0)
+#else
+#define EE_LOGD(...) EE_LOG_PRINT("D", __VA_ARGS__)
+#endif
+#define EE_LOGI(...) EE_LOG_PRINT("I", __VA_ARGS__)
+#define EE_LOGW(...) EE_LOG_PRINT("W", __VA_ARGS__)
+#define EE_LOGE(...) EE_LOG_PRINT("E", __VA_ARGS__)
+#endif
@@ -0,0 +1,182 @@
+#include "MatPool.h"
+
+#include "Log.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+namespace eagleeye {
+
+namespace {
+
+// Rounds a block size up to a quarter of its power of two, so a cached block is at most 25% larger than the
+// request it serves and Mats of nearby sizes (odd crops, remainders) share a size class.
+size_t sizeClass(size_t bytes) {
+    int topBit = 0;
+    for (size_t value = bytes; value > 1; value >>= 1) {
+        topBit++;
+    }
+    size_t granule = size_t(1) << std::max(0, topBit - 2);
+    return (bytes + granule - 1) & ~(granule - 1);
+}
+
+}  // namespace
+
+MatPool& MatPool::instance() {
+    // Never destroyed: Mats holding pooled buffers may be released during static destruction.
+    static MatPool* pool = new MatPool();
+    return *pool;
+}
+
+cv::UMatData* MatPool::allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+                                cv::AccessFlag /*flags*/, cv::UMatUsageFlags /*usageFlags*/) const {
+    // Same layout rules as OpenCV's StdMatAllocator.
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+        if (step) {
+            if (data0 && step[i] != cv::Mat::AUTO_STEP) {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    void* data = data0;
+    if (data == nullptr) {
+        EE_TRACE_COUNT(trace::Counter::MatsAllocated, 1);
+        if (total < kMinPooledBytes) {
+            data = cv::fastMalloc(total);
+        } else {
+            size_t blockSize = sizeClass(total);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::vector<void*>& freeList = freeLists_[blockSize];
+                if (!freeList.empty()) {
+                    data = freeList.back();
+                    freeList.pop_back();
+                    stats_.hits++;
+                    stats_.bytesCached -= blockSize;
+                } else {
+                    stats_.misses++;
+                }
+                stats_.bytesInUse += blockSize;
+                stats_.highWaterBytes = std::max(stats_.highWaterBytes, stats_.bytesInUse + stats_.bytesCached);
+            }
+            if (data == nullptr) {
+                data = cv::fastMalloc(blockSize);
+            }
+        }
+    }
+
+    cv::UMatData* u = new cv::UMatData(this);
+    u->data = u->origdata = static_cast<uchar*>(data);
+    u->size = total;
+    if (data0) {
+        u->flags |= cv::UMatData::USER_ALLOCATED;
+    }
+    return u;
+}
+
+bool MatPool::allocate(cv::UMatData* u, cv::AccessFlag /*accessFlags*/, cv::UMatUsageFlags /*usageFlags*/) const {
+    return u != nullptr;
+}
+
+void MatPool::deallocate(cv::UMatData* u) const {
+    if (u == nullptr) {
+        return;
+    }
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+    if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+        void* data = u->origdata;
+        if (u->size < kMinPooledBytes) {
+            cv::fastFree(data);
+        } else {
+            size_t blockSize = sizeClass(u->size);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stats_.bytesInUse -= blockSize;
+                if (sessions_ > 0 && stats_.bytesCached + static_cast<int64_t>(blockSize) <= cacheLimit_) {
+                    freeLists_[blockSize].push_back(data);
+                    stats_.bytesCached += blockSize;
+                    data = nullptr;
+                }
+            }
+            if (data != nullptr) {
+                cv::fastFree(data);
+            }
+        }
+        u->origdata = nullptr;
+    }
+    delete u;
+}
+
+void MatPool::setCacheLimit(int64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cacheLimit_ = std::max<int64_t>(0, bytes);
+}
+
+MatPoolStats MatPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void MatPool::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.hits = 0;
+    stats_.misses = 0;
+    stats_.highWaterBytes = stats_.bytesInUse + stats_.bytesCached;
+}
+
+void MatPool::trim() {
+    std::unordered_map<size_t, std::vector<void*>> freeLists;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        freeLists.swap(freeLists_);
+        stats_.bytesCached = 0;
+    }
+    for (auto& entry : freeLists) {
+        for (void* block : entry.second) {
+            cv::fastFree(block);
+        }
+    }
+}
+
+void MatPool::beginSession() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sessions_++ == 0) {
+        stats_.hits = 0;
+        stats_.misses = 0;
+        stats_.highWaterBytes = stats_.bytesInUse;
+        previousAllocator_ = cv::Mat::getDefaultAllocator();
+        cv::Mat::setDefaultAllocator(this);
+    }
+}
+
+void MatPool::endSession() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (sessions_ == 0 || --sessions_ > 0) {
+            return;
+        }
+        cv::Mat::setDefaultAllocator(previousAllocator_);
+        previousAllocator_ = nullptr;
+        EE_LOGI("MatPool session ended: %lld hits, %lld misses, high water %lld MB",
+                static_cast<long long>(stats_.hits), static_cast<long long>(stats_.misses),
+                static_cast<long long>(stats_.highWaterBytes >> 20));
+    }
+    trim();
+}
+
+MatPoolSession::MatPoolSession() {
+    MatPool::instance().beginSession();
+}
+
+MatPoolSession::~MatPoolSession() {
+    MatPool::instance().endSession();
+}
+
+}  // namespace eagleeye
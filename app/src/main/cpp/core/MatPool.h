@@ -0,0 +1,83 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace eagleeye {
+
+struct MatPoolStats {
+    int64_t hits = 0;           // pooled allocations served from a cached block
+    int64_t misses = 0;         // pooled allocations that had to go to the system allocator
+    int64_t bytesInUse = 0;     // bytes currently held by live pooled Mats
+    int64_t highWaterBytes = 0; // peak of bytesInUse + bytesCached since the session / resetStats() began
+    int64_t bytesCached = 0;    // bytes held in the free lists, ready for reuse
+};
+
+/*
+ * cv::MatAllocator that keeps freed Mat buffers in per size class free lists and hands them out again, so the
+ * full-frame temporaries the pipeline creates and drops all the time do not go back to the system allocator
+ * every time. Allocations below kMinPooledBytes bypass the pool.
+ *
+ * The pool is only installed as OpenCV's default allocator inside a MatPoolSession. Buffers released after the
+ * last session has ended are freed directly and the free lists are emptied, so nothing is kept between runs.
+ * Thread safe: Mats are created and released on OpenCV's worker threads as well.
+ */
+class MatPool : public cv::MatAllocator {
+public:
+    static constexpr size_t kMinPooledBytes = 64 * 1024;
+
+    static MatPool& instance();
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, cv::AccessFlag flags,
+                           cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+    /*
+     * Upper bound for bytesCached. Blocks released while the free lists are full are freed instead.
+     */
+    void setCacheLimit(int64_t bytes);
+
+    MatPoolStats stats() const;
+    void resetStats();
+
+    /*
+     * Frees every cached block. Live Mats are not affected.
+     */
+    void trim();
+
+    /*
+     * Explicit session bounds for callers that cannot hold a MatPoolSession, i.e. the JNI bridge.
+     * Every beginSession() must be paired with an endSession().
+     */
+    void beginSession();
+    void endSession();
+
+private:
+    MatPool() = default;
+
+    mutable std::mutex mutex_;
+    mutable std::unordered_map<size_t, std::vector<void*>> freeLists_;
+    mutable MatPoolStats stats_;
+    int64_t cacheLimit_ = 256ll * 1024 * 1024;
+    int sessions_ = 0;
+    cv::MatAllocator* previousAllocator_ = nullptr;
+};
+
+/*
+ * Installs MatPool as OpenCV's default Mat allocator for its lifetime. Sessions nest; the statistics are reset
+ * when the outermost session begins, and the previous allocator is restored and the pool trimmed when it ends.
+ */
+class MatPoolSession {
+public:
+    MatPoolSession();
+    ~MatPoolSession();
+
+    MatPoolSession(const MatPoolSession&) = delete;
+    MatPoolSession& operator=(const MatPoolSession&) = delete;
+};
+
+}  // namespace eagleeye
@@ -0,0 +1,204 @@
+#include "PyramidAligner.h"
+
+#include "Log.h"
+#include "Trace.h"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+
+#include <cmath>
+
+namespace eagleeye {
+
+namespace {
+
+cv::Mat scaleMatrix(double sx, double sy) {
+    return (cv::Mat_<double>(3, 3) << sx, 0.0, 0.0, 0.0, sy, 0.0, 0.0, 0.0, 1.0);
+}
+
+// A homography between two images scaled by (sx, sy) -> the same homography at full resolution.
+cv::Mat fromLevel(const cv::Mat& homography, double sx, double sy) {
+    return scaleMatrix(1.0 / sx, 1.0 / sy) * homography * scaleMatrix(sx, sy);
+}
+
+// ...and the other way round.
+cv::Mat toLevel(const cv::Mat& homography, double sx, double sy) {
+    return scaleMatrix(sx, sy) * homography * scaleMatrix(1.0 / sx, 1.0 / sy);
+}
+
+}  // namespace
+
+PyramidAligner::PyramidAligner(const PyramidAlignOptions& options) : options_(options) {}
+
+PyramidAligner::Levels PyramidAligner::buildLevels(const cv::Mat& image) {
+    cv::Mat gray;
+    if (image.channels() == 1) {
+        gray = image;
+    } else {
+        cv::cvtColor(image, gray, image.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+    }
+    Levels levels;
+    cv::resize(gray, levels.fine, cv::Size(gray.cols / 2, gray.rows / 2), 0.0, 0.0, cv::INTER_AREA);
+    cv::resize(levels.fine, levels.coarse, cv::Size(levels.fine.cols / 2, levels.fine.rows / 2), 0.0, 0.0,
+               cv::INTER_AREA);
+    return levels;
+}
+
+bool PyramidAligner::setReference(const cv::Mat& reference) {
+    EE_TRACE_SCOPE("PyramidAligner::setReference");
+    coarseKeypoints_.clear();
+    referenceKeypoints_.clear();
+    coarseDescriptors_.release();
+    refinePoints_.clear();
+    if (reference.empty()) {
+        return false;
+    }
+    fullSize_ = reference.size();
+    reference_ = buildLevels(reference);
+
+    cv::ORB::create(options_.coarseFeatures)->detectAndCompute(reference_.coarse, cv::noArray(), coarseKeypoints_,
+                                                                coarseDescriptors_);
+    double sx = static_cast<double>(reference_.coarse.cols) / fullSize_.width;
+    double sy = static_cast<double>(reference_.coarse.rows) / fullSize_.height;
+    referenceKeypoints_ = coarseKeypoints_;
+    for (cv::KeyPoint& keypoint : referenceKeypoints_) {
+        keypoint.pt.x = static_cast<float>(keypoint.pt.x / sx);
+        keypoint.pt.y = static_cast<float>(keypoint.pt.y / sy);
+    }
+
+    // Corners spread over the frame so the refinement constrains the whole homography, not one textured area.
+    double minDistance = std::sqrt(static_cast<double>(reference_.fine.total()) / options_.refinePoints) * 0.5;
+    cv::goodFeaturesToTrack(reference_.fine, refinePoints_, options_.refinePoints, 0.01, minDistance);
+    EE_LOGD("PyramidAligner reference: %zu coarse keypoints, %zu refinement corners", coarseKeypoints_.size(),
+            refinePoints_.size());
+    return !coarseDescriptors_.empty();
+}
+
+PyramidAligner::Result PyramidAligner::align(const cv::Mat& frame) const {
+    EE_TRACE_SCOPE("PyramidAligner::align");
+    Result result;
+    if (frame.empty() || frame.size() != fullSize_ || coarseDescriptors_.empty()) {
+        return result;
+    }
+    Levels levels = buildLevels(frame);
+
+    // Coarse level: ORB + ratio test + RANSAC.
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat descriptors;
+    cv::ORB::create(options_.coarseFeatures)->detectAndCompute(levels.coarse, cv::noArray(), keypoints, descriptors);
+    if (descriptors.rows < 2) {
+        return result;
+    }
+    std::vector<std::vector<cv::DMatch>> knnMatches;
+    cv::BFMatcher(cv::NORM_HAMMING).knnMatch(coarseDescriptors_, descriptors, knnMatches, 2);
+
+    std::vector<cv::Point2f> framePoints, referencePoints;
+    for (const std::vector<cv::DMatch>& candidates : knnMatches) {
+        if (candidates.size() == 2 && candidates[0].distance < options_.ratio * candidates[1].distance) {
+            result.matches.push_back(candidates[0]);
+            referencePoints.push_back(coarseKeypoints_[candidates[0].queryIdx].pt);
+            framePoints.push_back(keypoints[candidates[0].trainIdx].pt);
+        }
+    }
+    double coarseSx = static_cast<double>(levels.coarse.cols) / fullSize_.width;
+    double coarseSy = static_cast<double>(levels.coarse.rows) / fullSize_.height;
+    result.keypoints = keypoints;
+    for (cv::KeyPoint& keypoint : result.keypoints) {
+        keypoint.pt.x = static_cast<float>(keypoint.pt.x / coarseSx);
+        keypoint.pt.y = static_cast<float>(keypoint.pt.y / coarseSy);
+    }
+    if (static_cast<int>(framePoints.size()) < options_.minInliers) {
+        EE_LOGW("PyramidAligner: only %zu ratio-test matches", framePoints.size());
+        return result;
+    }
+
+    cv::Mat inlierMask;
+    cv::Mat coarse = cv::findHomography(framePoints, referencePoints, cv::RANSAC, options_.coarseRansac, inlierMask);
+    if (coarse.empty() || cv::countNonZero(inlierMask) < options_.minInliers) {
+        return result;
+    }
+    cv::Mat homography = fromLevel(coarse, coarseSx, coarseSy);
+    if (isDegenerate(homography, fullSize_)) {
+        EE_LOGW("PyramidAligner: rejected degenerate coarse homography");
+        return result;
+    }
+    result.homography = homography;
+    result.inliers = cv::countNonZero(inlierMask);
+
+    // Fine level: track the reference corners from where the coarse estimate puts them, re-fit on the tracks.
+    if (refinePoints_.size() < static_cast<size_t>(options_.minInliers)) {
+        return result;
+    }
+    double fineSx = static_cast<double>(levels.fine.cols) / fullSize_.width;
+    double fineSy = static_cast<double>(levels.fine.rows) / fullSize_.height;
+    cv::Mat fineInverse = toLevel(homography, fineSx, fineSy).inv();
+    std::vector<cv::Point2f> predicted;
+    cv::perspectiveTransform(refinePoints_, predicted, fineInverse);
+
+    std::vector<uchar> status;
+    std::vector<float> errors;
+    cv::calcOpticalFlowPyrLK(reference_.fine, levels.fine, refinePoints_, predicted, status, errors,
+                             cv::Size(options_.lkWindow, options_.lkWindow), 1,
+                             cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS,
+                                              options_.lkIterations, 0.03),
+                             cv::OPTFLOW_USE_INITIAL_FLOW);
+    std::vector<cv::Point2f> trackedFrame, trackedReference;
+    for (size_t i = 0; i < status.size(); i++) {
+        if (status[i]) {
+            trackedFrame.push_back(predicted[i]);
+            trackedReference.push_back(refinePoints_[i]);
+        }
+    }
+    if (static_cast<int>(trackedFrame.size()) < options_.minInliers) {
+        return result;
+    }
+    cv::Mat refinedMask;
+    cv::Mat refined = cv::findHomography(trackedFrame, trackedReference, cv::RANSAC, options_.refineRansac,
+                                         refinedMask);
+    int refinedInliers = refined.empty() ? 0 : cv::countNonZero(refinedMask);
+    if (refinedInliers < options_.minInliers) {
+        return result;
+    }
+    refined = fromLevel(refined, fineSx, fineSy);
+    if (isDegenerate(refined, fullSize_)) {
+        EE_LOGW("PyramidAligner: rejected degenerate refinement, keeping the coarse homography");
+        return result;
+    }
+    result.homography = refined;
+    result.inliers = refinedInliers;
+    result.refined = true;
+    return result;
+}
+
+bool PyramidAligner::isDegenerate(const cv::Mat& homography, cv::Size size) {
+    if (homography.empty() || homography.rows != 3 || homography.cols != 3 || !cv::checkRange(homography)) {
+        return true;
+    }
+    cv::Mat h;
+    homography.convertTo(h, CV_64F);
+    if (std::abs(h.at<double>(2, 2)) < 1e-12) {
+        return true;
+    }
+    h /= h.at<double>(2, 2);
+    // Orientation preserving: the linear part must not flip the image.
+    if (h.at<double>(0, 0) * h.at<double>(1, 1) - h.at<double>(0, 1) * h.at<double>(1, 0) <= 0.0) {
+        return true;
+    }
+
+    std::vector<cv::Point2f> corners = {
+        {0.0f, 0.0f},
+        {static_cast<float>(size.width), 0.0f},
+        {static_cast<float>(size.width), static_cast<float>(size.height)},
+        {0.0f, static_cast<float>(size.height)},
+    };
+    std::vector<cv::Point2f> warped;
+    cv::perspectiveTransform(corners, warped, h);
+    if (!cv::isContourConvex(warped)) {
+        return true;
+    }
+    double areaRatio = cv::contourArea(warped) / (static_cast<double>(size.width) * size.height);
+    return areaRatio < 0.5 || areaRatio > 2.0;
+}
+
+}  // namespace eagleeye
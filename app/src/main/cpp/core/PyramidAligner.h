@@ -0,0 +1,77 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <vector>
+
+namespace eagleeye {
+
+struct PyramidAlignOptions {
+    int coarseFeatures = 1000;     // ORB features on the 1/4 scale level
+    float ratio = 0.75f;           // Lowe ratio test between the best and second best match
+    double coarseRansac = 1.0;     // RANSAC threshold on the 1/4 scale level, in its pixels
+    int refinePoints = 300;        // corners tracked on the 1/2 scale level
+    int lkWindow = 15;
+    int lkIterations = 10;
+    double refineRansac = 1.0;     // RANSAC threshold on the 1/2 scale level, in its pixels
+    int minInliers = 12;
+};
+
+/*
+ * Coarse-to-fine homography estimation between burst frames. ORB matches with a ratio test give a first
+ * estimate on a 1/4 scale level; a fixed number of reference corners is then tracked with Lucas-Kanade on the
+ * 1/2 scale level, starting from that estimate, and the homography is re-fit on the tracked points. The work
+ * after the pyramid downsampling does not grow with the sensor resolution.
+ *
+ * Degenerate homographies (folded, flipped or strongly scaled image outline) are rejected: a degenerate
+ * refinement falls back to the coarse estimate, a degenerate coarse estimate gives no homography.
+ */
+class PyramidAligner {
+public:
+    struct Result {
+        cv::Mat homography;                  // 3x3 CV_64F, frame -> reference, full resolution. Empty on failure.
+        std::vector<cv::KeyPoint> keypoints; // coarse frame keypoints, in full resolution coordinates
+        std::vector<cv::DMatch> matches;     // ratio-test matches against referenceKeypoints()
+        int inliers = 0;
+        bool refined = false;
+    };
+
+    explicit PyramidAligner(const PyramidAlignOptions& options = PyramidAlignOptions());
+
+    /*
+     * Builds the reference pyramid, its coarse ORB features and the corners used for refinement.
+     * Returns false if the reference has no usable features.
+     */
+    bool setReference(const cv::Mat& reference);
+
+    /*
+     * Coarse reference keypoints, in full resolution coordinates.
+     */
+    const std::vector<cv::KeyPoint>& referenceKeypoints() const { return referenceKeypoints_; }
+
+    Result align(const cv::Mat& frame) const;
+
+    /*
+     * True if the homography maps the outline of an image of the given size to something that is not a
+     * plausible view of it: non-convex, flipped, or with less than half / more than twice its area.
+     */
+    static bool isDegenerate(const cv::Mat& homography, cv::Size size);
+
+private:
+    struct Levels {
+        cv::Mat fine;    // 1/2 scale gray
+        cv::Mat coarse;  // 1/4 scale gray
+    };
+
+    static Levels buildLevels(const cv::Mat& image);
+
+    PyramidAlignOptions options_;
+    cv::Size fullSize_;
+    Levels reference_;
+    std::vector<cv::KeyPoint> coarseKeypoints_;
+    std::vector<cv::KeyPoint> referenceKeypoints_;
+    cv::Mat coarseDescriptors_;
+    std::vector<cv::Point2f> refinePoints_;
+};
+
+}  // namespace eagleeye
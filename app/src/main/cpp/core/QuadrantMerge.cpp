@@ -0,0 +1,197 @@
+#include "QuadrantMerge.h"
+
+#include "AsyncFileRemover.h"
+#include "Log.h"
+#include "TileScheduler.h"
+#include "Trace.h"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <cstdio>
+
+namespace eagleeye {
+
+namespace {
+
+// Source pixels on each side of a resize tile. Covers the support of the bicubic (2) and Lanczos4 (4) kernels.
+constexpr int kResizeHalo = 4;
+
+// Copies a quadrant into its grid cell. The last row/column of quadrants carries the division remainder,
+// so the destination is clipped to the merged image instead of letting copyTo assert.
+void placeQuadrant(const cv::Mat& quadrant, cv::Mat& mergedImage, int rowOffset, int colOffset) {
+    cv::Rect target = cv::Rect(colOffset, rowOffset, quadrant.cols, quadrant.rows) &
+                      cv::Rect(0, 0, mergedImage.cols, mergedImage.rows);
+    if (target.empty()) {
+        return;
+    }
+    quadrant(cv::Rect(0, 0, target.width, target.height)).copyTo(mergedImage(target));
+}
+
+}  // namespace
+
+cv::Mat produceMask(const cv::Mat& inputMat) {
+    cv::Mat dstMask;
+    // Copy the input image
+    inputMat.copyTo(dstMask);
+
+    // If the image has 3 or 4 channels, convert it to grayscale.
+    if (dstMask.channels() == 3 || dstMask.channels() == 4) {
+        cv::cvtColor(dstMask, dstMask, cv::COLOR_BGR2GRAY);
+    }
+
+    // Convert to single channel 8-bit (CV_8UC1)
+    dstMask.convertTo(dstMask, CV_8UC1);
+
+    // Apply a binary threshold: pixels with a value greater than 1 become 1, others 0.
+    cv::threshold(dstMask, dstMask, 1.0, 1.0, cv::THRESH_BINARY);
+    return dstMask;
+}
+
+cv::Mat mergeQuadrantFiles(const std::vector<std::string>& filenames,
+                           int divisionFactor,
+                           int interpolationValue,
+                           int quadrantWidth,
+                           int quadrantHeight,
+                           bool parallel) {
+    EE_TRACE_SCOPE("mergeQuadrantFiles");
+    // Calculate total dimensions and initialize the merged image (BGR)
+    int totalHeight = divisionFactor * quadrantHeight * interpolationValue;
+    int totalWidth = divisionFactor * quadrantWidth * interpolationValue;
+    cv::Mat mergedImage(totalHeight, totalWidth, CV_8UC3, cv::Scalar(0, 0, 0));
+
+    auto mergeRange = [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            cv::Mat quadrant = cv::imread(filenames[i]);
+            if (quadrant.empty()) {
+                continue; // Skip if the image couldn't be loaded
+            }
+            trace::countImageRead(filenames[i]);
+
+            int row = i / divisionFactor;
+            int col = i % divisionFactor;
+            int rowOffset = row * quadrantHeight * interpolationValue;
+            int colOffset = col * quadrantWidth * interpolationValue;
+            placeQuadrant(quadrant, mergedImage, rowOffset, colOffset);
+
+            // Delete the file after processing
+            if (parallel) {
+                AsyncFileRemover::instance().remove(filenames[i]);
+            } else {
+                std::remove(filenames[i].c_str());
+            }
+        }
+    };
+
+    cv::Range quadrants(0, static_cast<int>(filenames.size()));
+    if (parallel) {
+        // Each quadrant lands in a disjoint ROI, so the workers never write the same pixels.
+        cv::parallel_for_(quadrants, mergeRange, quadrants.size());
+    } else {
+        mergeRange(quadrants);
+    }
+
+    return mergedImage;
+}
+
+bool upscaleQuadrants(const cv::Mat& src, cv::Mat& dst, int divisionFactor, double scale, int interpolation) {
+    if (src.empty() || divisionFactor <= 0 || scale <= 0.0) {
+        return false;
+    }
+    // Same grid as ImageOperator.performJNIInterpolation, but every cell is resized with a halo of real
+    // neighbouring pixels so the bicubic kernel does not see a border at the cell edges.
+    return upscaleTiles(src, dst, TileScheduler::grid(src.size(), divisionFactor, kResizeHalo), scale,
+                        interpolation);
+}
+
+bool upscaleTiles(const cv::Mat& src, cv::Mat& dst, const TileScheduler& scheduler, double scale,
+                  int interpolation) {
+    if (src.empty() || scale <= 0.0 || scheduler.imageSize() != src.size()) {
+        return false;
+    }
+    cv::Size outputSize(cvRound(src.cols * scale), cvRound(src.rows * scale));
+    if (dst.empty()) {
+        dst.create(outputSize, src.type());
+    } else if (dst.size() != outputSize || dst.type() != src.type()) {
+        EE_LOGE("upscaleTiles: output is %dx%d type %d, expected %dx%d type %d", dst.cols, dst.rows,
+                dst.type(), outputSize.width, outputSize.height, src.type());
+        return false;
+    }
+
+    const std::vector<Tile>& tiles = scheduler.tiles();
+    EE_TRACE_SCOPE("upscaleTiles");
+    EE_TRACE_COUNT(trace::Counter::TilesProcessed, static_cast<int64_t>(tiles.size()));
+    cv::parallel_for_(cv::Range(0, static_cast<int>(tiles.size())), [&](const cv::Range& range) {
+        cv::Mat scaledRegion;
+        for (int i = range.start; i < range.end; i++) {
+            const Tile& tile = tiles[i];
+            cv::Rect dstRegion = TileScheduler::scaleRect(tile.region, scale);
+            cv::Rect dstCrop = TileScheduler::scaleRect(tile.crop, scale);
+            if (dstCrop.empty()) {
+                continue;
+            }
+            if (tile.region == tile.crop) {
+                // No halo: dst(dstCrop) already has the requested size and type, so resize writes in place.
+                cv::Mat dstRoi = dst(dstCrop);
+                cv::resize(src(tile.crop), dstRoi, dstCrop.size(), 0.0, 0.0, interpolation);
+                continue;
+            }
+            cv::resize(src(tile.region), scaledRegion, dstRegion.size(), 0.0, 0.0, interpolation);
+            cv::Rect keep = cv::Rect(dstCrop - dstRegion.tl()) & cv::Rect(0, 0, scaledRegion.cols, scaledRegion.rows);
+            scaledRegion(keep).copyTo(dst(cv::Rect(dstCrop.tl(), keep.size())));
+        }
+    }, static_cast<double>(tiles.size()));
+    return true;
+}
+
+cv::Mat meanFuseQuadrantFiles(const std::vector<std::vector<std::string>>& filenames,
+                              const std::vector<std::string>& quadrantNames,
+                              int divisionFactor,
+                              int quadrantWidth,
+                              int quadrantHeight,
+                              bool parallel) {
+    EE_TRACE_SCOPE("meanFuseQuadrantFiles");
+    if (filenames.empty()) {
+        EE_LOGE("No filename arrays provided");
+        return cv::Mat();
+    }
+
+    for (size_t i = 0; i < filenames.size() && i < quadrantNames.size(); i++) {
+        EE_LOGI("Processing inner array %zu", i);
+        const std::vector<std::string>& innerFilenames = filenames[i];
+        EE_LOGI("Number of images in inner array %zu", innerFilenames.size());
+
+        cv::Mat sumMat, maskMat;
+        for (const std::string& filename : innerFilenames) {
+            cv::Mat img = cv::imread(filename, cv::IMREAD_UNCHANGED);
+            if (img.empty()) {
+                EE_LOGE("Image not loaded properly: %s", filename.c_str());
+                continue; // Skip if image is not loaded properly
+            }
+            trace::countImageRead(filename);
+            // Convert the image to 16-bit to avoid overflow during summing
+            img.convertTo(img, CV_16UC(img.channels()));
+            if (sumMat.empty()) {
+                sumMat = cv::Mat::zeros(img.size(), CV_16UC(img.channels()));
+            }
+            // Create a mask based on the image content
+            maskMat = produceMask(img);
+            // Add the current image to the cumulative sum using the mask
+            cv::add(sumMat, img, sumMat, maskMat, CV_16UC(img.channels()));
+        }
+        if (sumMat.empty()) {
+            EE_LOGE("No valid images processed.");
+            return cv::Mat();
+        }
+        sumMat /= static_cast<double>(innerFilenames.size());
+        cv::imwrite(quadrantNames[i], sumMat);
+        trace::countImageWritten(quadrantNames[i]);
+        EE_LOGI("Mean fusion completed for %s", quadrantNames[i].c_str());
+    }
+
+    cv::Mat mergedImage = mergeQuadrantFiles(quadrantNames, divisionFactor, 1, quadrantWidth, quadrantHeight,
+                                                 parallel);
+    EE_LOGI("Mean fusion completed successfully.");
+    return mergedImage;
+}
+
+}  // namespace eagleeye
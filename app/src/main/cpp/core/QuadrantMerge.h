@@ -0,0 +1,60 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include "TileScheduler.h"
+#include <string>
+#include <vector>
+
+namespace eagleeye {
+
+/*
+ * Produces a binary 0/1 mask of the non-black pixels of an image. Mirrors ImageOperator.produceMask.
+ */
+cv::Mat produceMask(const cv::Mat& inputMat);
+
+/*
+ * Stitches quadrant images stored on disk back into one BGR image. The files are laid out row-major on a
+ * divisionFactor x divisionFactor grid and each cell is quadrantWidth x quadrantHeight (times the
+ * interpolation value). Unreadable files are skipped. Every file that was read is deleted afterwards.
+ *
+ * In parallel mode the quadrants are decoded on OpenCV's worker pool, each straight into its own disjoint
+ * region of the output, and the files are deleted in the background by AsyncFileRemover.
+ */
+cv::Mat mergeQuadrantFiles(const std::vector<std::string>& filenames,
+                           int divisionFactor,
+                           int interpolationValue,
+                           int quadrantWidth,
+                           int quadrantHeight,
+                           bool parallel = true);
+
+/*
+ * In-memory counterpart of the quadrant upscale + mergeQuadrantFiles path. Resizes each cell of the
+ * divisionFactor x divisionFactor grid of src straight into its region of dst, so nothing is encoded or
+ * written to disk. Cells are resized with a small halo so there are no seams between them.
+ * dst may be preallocated by the caller with the scaled size and the type of src; otherwise it is allocated
+ * here. Returns false if dst has the wrong size or type.
+ */
+bool upscaleQuadrants(const cv::Mat& src, cv::Mat& dst, int divisionFactor, double scale,
+                      int interpolation = cv::INTER_CUBIC);
+
+/*
+ * upscaleQuadrants over an arbitrary tiling of src, e.g. TileScheduler::forBudget to bound the per-tile
+ * scratch memory. Tiles are resized in parallel.
+ */
+bool upscaleTiles(const cv::Mat& src, cv::Mat& dst, const TileScheduler& scheduler, double scale,
+                  int interpolation = cv::INTER_CUBIC);
+
+/*
+ * Mean-fuses each group of quadrant files (filenames[i] holds quadrant i of every frame), writes the fused
+ * quadrant to quadrantNames[i] and then stitches the fused quadrants into one BGR image.
+ * Returns an empty Mat if a quadrant group had no readable images.
+ */
+cv::Mat meanFuseQuadrantFiles(const std::vector<std::vector<std::string>>& filenames,
+                              const std::vector<std::string>& quadrantNames,
+                              int divisionFactor,
+                              int quadrantWidth,
+                              int quadrantHeight,
+                              bool parallel = true);
+
+}  // namespace eagleeye
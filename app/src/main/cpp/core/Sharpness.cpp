@@ -0,0 +1,29 @@
+#include "Sharpness.h"
+
+#include "Log.h"
+#include "Trace.h"
+#include "YangFilter.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+namespace eagleeye {
+
+double edgeDensity(const cv::Mat& edges) {
+    if (edges.empty()) {
+        return 0.0;
+    }
+    return static_cast<double>(cv::countNonZero(edges)) / static_cast<double>(edges.total());
+}
+
+double jpegSharpness(const cv::Mat& encoded) {
+    EE_TRACE_SCOPE("jpegSharpness");
+    cv::Mat energy = cv::imdecode(encoded, cv::IMREAD_REDUCED_GRAYSCALE_8);
+    if (energy.empty()) {
+        EE_LOGE("jpegSharpness: could not decode %zu bytes", encoded.total());
+        return -1.0;
+    }
+    EE_TRACE_COUNT(trace::Counter::JpegDecodes, 1);
+    return edgeDensity(yangEdges(energy));
+}
+
+}  // namespace eagleeye
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+namespace eagleeye {
+
+/*
+ * SharpnessMeasure.measure: the fraction of non-zero pixels of an edge image.
+ */
+double edgeDensity(const cv::Mat& edges);
+
+/*
+ * The sharpness the energy + Yang filter + measureSharpness stages give a frame, straight from its encoded
+ * JPEG: decoded at 1/8 scale to luminance (IMREAD_REDUCED_GRAYSCALE_8), Yang edges, edge density.
+ * Cheap enough to run on every frame as it arrives from the camera. Returns -1 if the data cannot be decoded.
+ */
+double jpegSharpness(const cv::Mat& encoded);
+
+}  // namespace eagleeye
@@ -0,0 +1,309 @@
+#include "ShiftAddFusion.h"
+
+#include "Log.h"
+#include "TileScheduler.h"
+#include "Trace.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace eagleeye {
+
+namespace {
+
+constexpr int kMaxChannels = 4;
+constexpr float kMinFillWeight = 1e-6f;
+
+cv::Mat toFloatMap(const cv::Mat& map) {
+    cv::Mat result;
+    map.convertTo(result, CV_32F);
+    return result;
+}
+
+}  // namespace
+
+ShiftAddFusion::ShiftAddFusion(const ShiftAddOptions& options) : options_(options) {
+    options_.scale = std::max(options_.scale, 1);
+    if (options_.fillSigma <= 0.0) {
+        options_.fillSigma = options_.scale * 0.5;
+    }
+    options_.tileSide = std::max(options_.tileSide, 16);
+}
+
+bool ShiftAddFusion::accepts(const cv::Mat& frame) {
+    if (frame.empty() || frame.depth() != CV_8U || frame.channels() > kMaxChannels) {
+        EE_LOGE("ShiftAddFusion: frames must be 8-bit with at most %d channels", kMaxChannels);
+        return false;
+    }
+    if (frames_.empty()) {
+        frameSize_ = frame.size();
+        type_ = frame.type();
+        return true;
+    }
+    if (frame.size() != frameSize_ || frame.type() != type_) {
+        EE_LOGE("ShiftAddFusion: frame is %dx%dx%d, expected %dx%dx%d", frame.cols, frame.rows, frame.channels(),
+                frameSize_.width, frameSize_.height, CV_MAT_CN(type_));
+        return false;
+    }
+    return true;
+}
+
+bool ShiftAddFusion::addFrame(const cv::Mat& frame, const cv::Mat& homography) {
+    if (!accepts(frame)) {
+        return false;
+    }
+    Frame entry;
+    entry.image = frame;
+    entry.warp = homography.rows == 3 && homography.cols == 3;
+    if (entry.warp) {
+        cv::Mat h;
+        homography.convertTo(h, CV_64F);
+        entry.homography = cv::Matx33d(h);
+        entry.inverse = entry.homography.inv();
+    }
+    frames_.push_back(entry);
+    return true;
+}
+
+bool ShiftAddFusion::addFrame(const cv::Mat& frame, const cv::Mat& xDisplacement, const cv::Mat& yDisplacement) {
+    if (xDisplacement.size() != frame.size() || yDisplacement.size() != frame.size() ||
+        xDisplacement.channels() != 1 || yDisplacement.channels() != 1) {
+        EE_LOGE("ShiftAddFusion: displacement maps must be single channel and of the frame's size");
+        return false;
+    }
+    if (!accepts(frame)) {
+        return false;
+    }
+    Frame entry;
+    entry.image = frame;
+    entry.xDisplacement = toFloatMap(xDisplacement);
+    entry.yDisplacement = toFloatMap(yDisplacement);
+    double minX, maxX, minY, maxY;
+    cv::minMaxLoc(entry.xDisplacement, &minX, &maxX);
+    cv::minMaxLoc(entry.yDisplacement, &minY, &maxY);
+    entry.maxShift = std::max({std::abs(minX), std::abs(maxX), std::abs(minY), std::abs(maxY)});
+    frames_.push_back(entry);
+    return true;
+}
+
+/*
+ * The frame pixels that can splat into region: the LR area under region (plus the one pixel reach of the
+ * bilinear splat), mapped back into the frame.
+ */
+cv::Rect ShiftAddFusion::sourceBounds(const Frame& frame, const cv::Rect& region) const {
+    const double scale = options_.scale;
+    double x0 = (region.x + 0.5) / scale - 0.5 - 1.0;
+    double y0 = (region.y + 0.5) / scale - 0.5 - 1.0;
+    double x1 = (region.br().x - 0.5) / scale - 0.5 + 1.0;
+    double y1 = (region.br().y - 0.5) / scale - 0.5 + 1.0;
+
+    if (frame.warp) {
+        const cv::Matx33d& m = frame.inverse;
+        double minX = HUGE_VAL, minY = HUGE_VAL, maxX = -HUGE_VAL, maxY = -HUGE_VAL;
+        for (const cv::Point2d& corner : {cv::Point2d(x0, y0), cv::Point2d(x1, y0), cv::Point2d(x1, y1),
+                                          cv::Point2d(x0, y1)}) {
+            double w = m(2, 0) * corner.x + m(2, 1) * corner.y + m(2, 2);
+            if (w <= 0.0) {
+                // The region's outline crosses the horizon of the homography: take the whole frame.
+                return cv::Rect(cv::Point(0, 0), frameSize_);
+            }
+            double px = (m(0, 0) * corner.x + m(0, 1) * corner.y + m(0, 2)) / w;
+            double py = (m(1, 0) * corner.x + m(1, 1) * corner.y + m(1, 2)) / w;
+            minX = std::min(minX, px);
+            maxX = std::max(maxX, px);
+            minY = std::min(minY, py);
+            maxY = std::max(maxY, py);
+        }
+        x0 = minX;
+        y0 = minY;
+        x1 = maxX;
+        y1 = maxY;
+    } else {
+        x0 -= frame.maxShift;
+        y0 -= frame.maxShift;
+        x1 += frame.maxShift;
+        y1 += frame.maxShift;
+    }
+
+    int left = std::max(static_cast<int>(std::floor(x0)) - 1, 0);
+    int top = std::max(static_cast<int>(std::floor(y0)) - 1, 0);
+    int right = std::min(static_cast<int>(std::ceil(x1)) + 1, frameSize_.width - 1);
+    int bottom = std::min(static_cast<int>(std::ceil(y1)) + 1, frameSize_.height - 1);
+    if (left > right || top > bottom) {
+        return cv::Rect();
+    }
+    return cv::Rect(left, top, right - left + 1, bottom - top + 1);
+}
+
+void ShiftAddFusion::splat(const Frame& frame, const cv::Rect& region, cv::Mat& values, cv::Mat& weights) const {
+    cv::Rect source = sourceBounds(frame, region);
+    const int channels = frame.image.channels();
+    const double scale = options_.scale;
+    const cv::Matx33d& h = frame.homography;
+
+    for (int y = source.y; y < source.br().y; y++) {
+        const uchar* in = frame.image.ptr<uchar>(y);
+        const float* dx = frame.xDisplacement.empty() ? nullptr : frame.xDisplacement.ptr<float>(y);
+        const float* dy = frame.yDisplacement.empty() ? nullptr : frame.yDisplacement.ptr<float>(y);
+        for (int x = source.x; x < source.br().x; x++) {
+            double px = x, py = y;
+            if (frame.warp) {
+                double w = h(2, 0) * x + h(2, 1) * y + h(2, 2);
+                if (w <= 0.0) {
+                    continue;
+                }
+                px = (h(0, 0) * x + h(0, 1) * y + h(0, 2)) / w;
+                py = (h(1, 0) * x + h(1, 1) * y + h(1, 2)) / w;
+            } else if (dx != nullptr) {
+                px += dx[x];
+                py += dy[x];
+            }
+            // LR pixel centres to HR pixel centres, relative to the region.
+            double qx = (px + 0.5) * scale - 0.5 - region.x;
+            double qy = (py + 0.5) * scale - 0.5 - region.y;
+            int hx = static_cast<int>(std::floor(qx));
+            int hy = static_cast<int>(std::floor(qy));
+            if (hx < -1 || hy < -1 || hx >= region.width || hy >= region.height) {
+                continue;
+            }
+            float fx = static_cast<float>(qx - hx);
+            float fy = static_cast<float>(qy - hy);
+            const float taps[4] = {(1.0f - fx) * (1.0f - fy), fx * (1.0f - fy), (1.0f - fx) * fy, fx * fy};
+            const uchar* sample = in + x * channels;
+            for (int t = 0; t < 4; t++) {
+                int tx = hx + (t & 1);
+                int ty = hy + (t >> 1);
+                if (tx < 0 || ty < 0 || tx >= region.width || ty >= region.height) {
+                    continue;
+                }
+                float* value = values.ptr<float>(ty) + tx * channels;
+                for (int c = 0; c < channels; c++) {
+                    value[c] += taps[t] * sample[c];
+                }
+                weights.ptr<float>(ty)[tx] += taps[t];
+            }
+        }
+    }
+}
+
+cv::Mat ShiftAddFusion::reconstruct() const {
+    EE_TRACE_SCOPE("ShiftAddFusion::reconstruct");
+    if (frames_.empty()) {
+        return cv::Mat();
+    }
+    const int channels = CV_MAT_CN(type_);
+    const int radius = static_cast<int>(std::ceil(3.0 * options_.fillSigma));
+    const cv::Size kernel(2 * radius + 1, 2 * radius + 1);
+    const float minWeight = static_cast<float>(options_.minWeight);
+
+    cv::Mat output(outputSize(), type_);
+    EE_TRACE_COUNT(trace::Counter::MatsAllocated, 1);
+    // The normalized convolution of a crop pixel reaches radius pixels out, which the halo keeps inside the tile.
+    std::vector<Tile> tiles =
+            TileScheduler(output.size(), cv::Size(options_.tileSide, options_.tileSide), radius).tiles();
+    std::atomic<int64_t> holes{0};
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(tiles.size())), [&](const cv::Range& range) {
+        cv::Mat values, weights, blurredValues, blurredWeights;
+        for (int i = range.start; i < range.end; i++) {
+            const Tile& tile = tiles[i];
+            values.create(tile.region.size(), CV_32FC(channels));
+            weights.create(tile.region.size(), CV_32FC1);
+            values.setTo(cv::Scalar::all(0.0));
+            weights.setTo(cv::Scalar::all(0.0));
+            for (const Frame& frame : frames_) {
+                splat(frame, tile.region, values, weights);
+            }
+
+            const cv::Rect crop = tile.cropInRegion();
+            bool needsFill = cv::countNonZero(weights(crop) < minWeight) > 0;
+            if (needsFill) {
+                // Zero outside the image is what normalized convolution wants: no samples, no weight.
+                cv::GaussianBlur(values, blurredValues, kernel, options_.fillSigma, options_.fillSigma,
+                                 cv::BORDER_CONSTANT);
+                cv::GaussianBlur(weights, blurredWeights, kernel, options_.fillSigma, options_.fillSigma,
+                                 cv::BORDER_CONSTANT);
+            }
+
+            int64_t tileHoles = 0;
+            for (int y = 0; y < crop.height; y++) {
+                const float* weight = weights.ptr<float>(crop.y + y) + crop.x;
+                const float* value = values.ptr<float>(crop.y + y) + crop.x * channels;
+                uchar* out = output.ptr<uchar>(tile.crop.y + y) + tile.crop.x * channels;
+                for (int x = 0; x < crop.width; x++) {
+                    float w = weight[x];
+                    const float* v = value + x * channels;
+                    if (w < minWeight && needsFill) {
+                        w = blurredWeights.ptr<float>(crop.y + y)[crop.x + x];
+                        v = blurredValues.ptr<float>(crop.y + y) + (crop.x + x) * channels;
+                    }
+                    if (w < kMinFillWeight) {
+                        tileHoles++;
+                        for (int c = 0; c < channels; c++) {
+                            out[x * channels + c] = 0;
+                        }
+                        continue;
+                    }
+                    float inverse = 1.0f / w;
+                    for (int c = 0; c < channels; c++) {
+                        out[x * channels + c] = cv::saturate_cast<uchar>(v[c] * inverse);
+                    }
+                }
+            }
+            holes += tileHoles;
+        }
+    }, static_cast<double>(tiles.size()));
+    EE_TRACE_COUNT(trace::Counter::TilesProcessed, static_cast<int64_t>(tiles.size()));
+
+    if (holes > 0) {
+        EE_LOGW("ShiftAddFusion: %lld HR pixels had no sample within the fill radius",
+                static_cast<long long>(holes.load()));
+    }
+    EE_LOGD("ShiftAddFusion: %zu frames -> %dx%d", frames_.size(), output.cols, output.rows);
+    return output;
+}
+
+void zeroFill(const cv::Mat& lr, cv::Mat& hr, int scale, cv::Point offset) {
+    CV_Assert(lr.type() == hr.type());
+    const size_t elemSize = lr.elemSize();
+    for (int y = 0; y < lr.rows; y++) {
+        int row = y * scale + offset.y;
+        if (row < 0 || row >= hr.rows) {
+            continue;
+        }
+        const uchar* in = lr.ptr<uchar>(y);
+        uchar* out = hr.ptr<uchar>(row);
+        for (int x = 0; x < lr.cols; x++) {
+            int col = x * scale + offset.x;
+            if (col >= 0 && col < hr.cols) {
+                std::memcpy(out + col * elemSize, in + x * elemSize, elemSize);
+            }
+        }
+    }
+}
+
+void zeroFill(const cv::Mat& lr, cv::Mat& hr, int scale, const cv::Mat& xDisplacement, const cv::Mat& yDisplacement) {
+    CV_Assert(lr.type() == hr.type() && xDisplacement.size() == lr.size() && yDisplacement.size() == lr.size());
+    cv::Mat xMap = toFloatMap(xDisplacement);
+    cv::Mat yMap = toFloatMap(yDisplacement);
+    const size_t elemSize = lr.elemSize();
+    for (int y = 0; y < lr.rows; y++) {
+        const uchar* in = lr.ptr<uchar>(y);
+        const float* dx = xMap.ptr<float>(y);
+        const float* dy = yMap.ptr<float>(y);
+        for (int x = 0; x < lr.cols; x++) {
+            // Math.round: half-way cases round up.
+            int row = static_cast<int>(std::floor(dy[x] + 0.5)) * scale;
+            int col = static_cast<int>(std::floor(dx[x] + 0.5)) * scale;
+            if (row >= 0 && row < hr.rows && col >= 0 && col < hr.cols) {
+                std::memcpy(hr.ptr<uchar>(row) + col * elemSize, in + x * elemSize, elemSize);
+            }
+        }
+    }
+}
+
+}  // namespace eagleeye
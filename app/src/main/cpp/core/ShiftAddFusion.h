@@ -0,0 +1,85 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace eagleeye {
+
+struct ShiftAddOptions {
+    int scale = 2;             // HR pixels per LR pixel, ParameterConfig.getScalingFactor()
+    double fillSigma = 0.0;    // Gaussian of the normalized convolution, in HR pixels; 0 = scale / 2
+    double minWeight = 0.2;    // splat weight below which an HR pixel is filled from its neighbourhood
+    int tileSide = 256;        // side of the HR tiles reconstructed in parallel
+};
+
+/*
+ * Multi-frame shift-and-add super-resolution. Every LR sample of every frame is placed at its sub-pixel
+ * position in the reference frame, given by a global homography or by per-pixel displacement maps, and splatted
+ * bilinearly onto the HR grid. HR pixels that collected enough weight are the weighted mean of their samples;
+ * the others are filled by normalized convolution, i.e. the Gaussian-blurred values over the Gaussian-blurred
+ * weights, which interpolates holes from whatever samples landed nearby.
+ *
+ * The HR image is reconstructed tile by tile on OpenCV's worker pool. Each tile only gathers the samples that
+ * can land in it, so the float accumulators never exist at full HR size.
+ *
+ * Usage: addFrame() for the reference (no homography) and every aligned frame -> reconstruct().
+ */
+class ShiftAddFusion {
+public:
+    explicit ShiftAddFusion(const ShiftAddOptions& options = ShiftAddOptions());
+
+    /*
+     * Adds an 8-bit frame aligned by homography (3x3, frame -> reference, as warpPerspective takes it). An
+     * empty homography places the frame as it is. Frames are not copied and must stay alive until
+     * reconstruct(). Returns false if the frame does not match the first one.
+     */
+    bool addFrame(const cv::Mat& frame, const cv::Mat& homography);
+
+    /*
+     * Adds an 8-bit frame whose pixel (x, y) lies at (x + xDisplacement(y, x), y + yDisplacement(y, x)) in the
+     * reference, in LR pixels. The maps are single channel float of the frame's size.
+     */
+    bool addFrame(const cv::Mat& frame, const cv::Mat& xDisplacement, const cv::Mat& yDisplacement);
+
+    int frameCount() const { return static_cast<int>(frames_.size()); }
+    cv::Size outputSize() const { return cv::Size(frameSize_.width * options_.scale, frameSize_.height * options_.scale); }
+
+    /*
+     * Returns the 8-bit HR image, or an empty Mat if no frame was added.
+     */
+    cv::Mat reconstruct() const;
+
+private:
+    struct Frame {
+        cv::Mat image;
+        bool warp = false;
+        cv::Matx33d homography;
+        cv::Matx33d inverse;
+        cv::Mat xDisplacement;   // CV_32FC1, empty for homography frames
+        cv::Mat yDisplacement;
+        double maxShift = 0.0;   // largest displacement in either direction
+    };
+
+    bool accepts(const cv::Mat& frame);
+    cv::Rect sourceBounds(const Frame& frame, const cv::Rect& region) const;
+    void splat(const Frame& frame, const cv::Rect& region, cv::Mat& values, cv::Mat& weights) const;
+
+    ShiftAddOptions options_;
+    cv::Size frameSize_;
+    int type_ = -1;
+    std::vector<Frame> frames_;
+};
+
+/*
+ * ImageOperator.performZeroFill / copyMat: writes lr(y, x) to hr(y * scale + offset.y, x * scale + offset.x)
+ * and leaves the other HR pixels as they are. Samples that fall outside hr are dropped.
+ */
+void zeroFill(const cv::Mat& lr, cv::Mat& hr, int scale, cv::Point offset);
+
+/*
+ * ImageOperator.performZeroFill with displacement maps: lr(y, x) goes to
+ * hr(round(yDisplacement(y, x)) * scale, round(xDisplacement(y, x)) * scale).
+ */
+void zeroFill(const cv::Mat& lr, cv::Mat& hr, int scale, const cv::Mat& xDisplacement, const cv::Mat& yDisplacement);
+
+}  // namespace eagleeye
@@ -0,0 +1,26 @@
+#include "SystemMemory.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace eagleeye {
+
+int64_t availableMemoryBytes() {
+    FILE* meminfo = std::fopen("/proc/meminfo", "r");
+    if (meminfo == nullptr) {
+        return -1;
+    }
+    char line[256];
+    int64_t availableKb = -1;
+    while (std::fgets(line, sizeof(line), meminfo) != nullptr) {
+        long long value = 0;
+        if (std::strncmp(line, "MemAvailable:", 13) == 0 && std::sscanf(line + 13, "%lld", &value) == 1) {
+            availableKb = value;
+            break;
+        }
+    }
+    std::fclose(meminfo);
+    return availableKb < 0 ? -1 : availableKb * 1024;
+}
+
+}  // namespace eagleeye
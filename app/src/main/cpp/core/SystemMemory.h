@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+namespace eagleeye {
+
+/*
+ * Memory the kernel reports as available for new allocations without swapping (MemAvailable in
+ * /proc/meminfo), in bytes. Returns -1 if it cannot be read.
+ */
+int64_t availableMemoryBytes();
+
+}  // namespace eagleeye
@@ -0,0 +1,313 @@
+#include "TensorPack.h"
+
+#include "Log.h"
+#include "Trace.h"
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include <algorithm>
+#include <cfloat>
+
+namespace eagleeye {
+
+namespace {
+
+constexpr int kStripeRows = 32;
+
+/*
+ * Per pixel channel: the plane it goes to (or comes from) and the affine map applied on the way.
+ */
+struct ChannelMap {
+    int channels = 0;
+    int plane[4] = {0, 1, 2, 3};
+    float a[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    float b[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+};
+
+int planeOf(int channel, int channels, bool swapRB) {
+    if (swapRB && channels >= 3 && channel != 1 && channel < 3) {
+        return 2 - channel;
+    }
+    return channel;
+}
+
+#if CV_SIMD
+/*
+ * Widens 8-bit lanes to float and stores a * v + b, one float vector at a time.
+ */
+inline void storeAffine(const cv::v_uint8& v, float* out, const cv::v_float32& a, const cv::v_float32& b) {
+    const int lanes = cv::VTraits<cv::v_float32>::vlanes();
+    cv::v_uint16 low, high;
+    cv::v_expand(v, low, high);
+    cv::v_uint32 quarters[4];
+    cv::v_expand(low, quarters[0], quarters[1]);
+    cv::v_expand(high, quarters[2], quarters[3]);
+    for (int k = 0; k < 4; k++) {
+        cv::v_store(out + k * lanes, cv::v_fma(cv::v_cvt_f32(cv::v_reinterpret_as_s32(quarters[k])), a, b));
+    }
+}
+
+/*
+ * a * planes + b at four float vectors, clamped and rounded to 8-bit lanes.
+ */
+inline cv::v_uint8 loadQuantised(const float* in, const cv::v_float32& a, const cv::v_float32& b,
+                                 const cv::v_float32& low, const cv::v_float32& high) {
+    const int lanes = cv::VTraits<cv::v_float32>::vlanes();
+    cv::v_int32 rounded[4];
+    for (int k = 0; k < 4; k++) {
+        cv::v_float32 value = cv::v_fma(cv::vx_load(in + k * lanes), a, b);
+        rounded[k] = cv::v_round(cv::v_min(cv::v_max(value, low), high));
+    }
+    return cv::v_pack_u(cv::v_pack(rounded[0], rounded[1]), cv::v_pack(rounded[2], rounded[3]));
+}
+#endif
+
+/*
+ * count pixels of one image row into the planes, starting at column x of the tensor row.
+ */
+void packSpan(const uchar* in, int count, const ChannelMap& map, float* const* rows, int x) {
+    const int channels = map.channels;
+    int i = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_uint8>::vlanes();
+    if (channels == 3) {
+        const cv::v_float32 a0 = cv::vx_setall_f32(map.a[0]), b0 = cv::vx_setall_f32(map.b[0]);
+        const cv::v_float32 a1 = cv::vx_setall_f32(map.a[1]), b1 = cv::vx_setall_f32(map.b[1]);
+        const cv::v_float32 a2 = cv::vx_setall_f32(map.a[2]), b2 = cv::vx_setall_f32(map.b[2]);
+        for (; i <= count - lanes; i += lanes) {
+            cv::v_uint8 c0, c1, c2;
+            cv::v_load_deinterleave(in + i * 3, c0, c1, c2);
+            storeAffine(c0, rows[map.plane[0]] + x + i, a0, b0);
+            storeAffine(c1, rows[map.plane[1]] + x + i, a1, b1);
+            storeAffine(c2, rows[map.plane[2]] + x + i, a2, b2);
+        }
+    } else if (channels == 1) {
+        const cv::v_float32 a0 = cv::vx_setall_f32(map.a[0]), b0 = cv::vx_setall_f32(map.b[0]);
+        for (; i <= count - lanes; i += lanes) {
+            storeAffine(cv::vx_load(in + i), rows[0] + x + i, a0, b0);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        for (int c = 0; c < channels; c++) {
+            rows[map.plane[c]][x + i] = in[i * channels + c] * map.a[c] + map.b[c];
+        }
+    }
+}
+
+void packSpan(const float* in, int count, const ChannelMap& map, float* const* rows, int x) {
+    const int channels = map.channels;
+    int i = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_float32>::vlanes();
+    if (channels == 3) {
+        const cv::v_float32 a0 = cv::vx_setall_f32(map.a[0]), b0 = cv::vx_setall_f32(map.b[0]);
+        const cv::v_float32 a1 = cv::vx_setall_f32(map.a[1]), b1 = cv::vx_setall_f32(map.b[1]);
+        const cv::v_float32 a2 = cv::vx_setall_f32(map.a[2]), b2 = cv::vx_setall_f32(map.b[2]);
+        for (; i <= count - lanes; i += lanes) {
+            cv::v_float32 c0, c1, c2;
+            cv::v_load_deinterleave(in + i * 3, c0, c1, c2);
+            cv::v_store(rows[map.plane[0]] + x + i, cv::v_fma(c0, a0, b0));
+            cv::v_store(rows[map.plane[1]] + x + i, cv::v_fma(c1, a1, b1));
+            cv::v_store(rows[map.plane[2]] + x + i, cv::v_fma(c2, a2, b2));
+        }
+    } else if (channels == 1) {
+        const cv::v_float32 a0 = cv::vx_setall_f32(map.a[0]), b0 = cv::vx_setall_f32(map.b[0]);
+        for (; i <= count - lanes; i += lanes) {
+            cv::v_store(rows[0] + x + i, cv::v_fma(cv::vx_load(in + i), a0, b0));
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        for (int c = 0; c < channels; c++) {
+            rows[map.plane[c]][x + i] = in[i * channels + c] * map.a[c] + map.b[c];
+        }
+    }
+}
+
+/*
+ * Tensor rows [rowBegin, rowEnd). Rows and columns outside the image are mapped back into it with
+ * borderInterpolate, or are the normalised value of pixel 0 for BORDER_CONSTANT.
+ */
+template <typename T>
+void packRows(const cv::Mat& src, const cv::Rect& region, float* planes, const ChannelMap& map, int borderType,
+              int rowBegin, int rowEnd) {
+    const int channels = map.channels;
+    const size_t planeArea = static_cast<size_t>(region.area());
+    const int insideBegin = std::clamp(-region.x, 0, region.width);
+    const int insideEnd = std::clamp(src.cols - region.x, insideBegin, region.width);
+    for (int y = rowBegin; y < rowEnd; y++) {
+        float* rows[4];
+        for (int p = 0; p < channels; p++) {
+            rows[p] = planes + p * planeArea + static_cast<size_t>(y) * region.width;
+        }
+        const int sy = cv::borderInterpolate(region.y + y, src.rows, borderType);
+        if (sy < 0) {
+            for (int c = 0; c < channels; c++) {
+                std::fill(rows[map.plane[c]], rows[map.plane[c]] + region.width, map.b[c]);
+            }
+            continue;
+        }
+        const T* in = src.ptr<T>(sy);
+        auto padColumns = [&](int begin, int end) {
+            for (int x = begin; x < end; x++) {
+                const int sx = cv::borderInterpolate(region.x + x, src.cols, borderType);
+                for (int c = 0; c < channels; c++) {
+                    rows[map.plane[c]][x] = sx < 0 ? map.b[c] : in[sx * channels + c] * map.a[c] + map.b[c];
+                }
+            }
+        };
+        padColumns(0, insideBegin);
+        if (insideEnd > insideBegin) {
+            packSpan(in + (region.x + insideBegin) * channels, insideEnd - insideBegin, map, rows, insideBegin);
+        }
+        padColumns(insideEnd, region.width);
+    }
+}
+
+/*
+ * count pixels from column x of the tensor rows into one image row. 8-bit output saturates, so it is always
+ * clamped.
+ */
+void unpackSpan(const float* const* rows, int x, int count, const ChannelMap& map, bool /*clamp*/, uchar* out) {
+    const int channels = map.channels;
+    const float low = 0.0f;
+    const float high = 255.0f;
+    int i = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_uint8>::vlanes();
+    const cv::v_float32 vLow = cv::vx_setall_f32(low), vHigh = cv::vx_setall_f32(high);
+    if (channels == 3) {
+        const cv::v_float32 a0 = cv::vx_setall_f32(map.a[0]), b0 = cv::vx_setall_f32(map.b[0]);
+        const cv::v_float32 a1 = cv::vx_setall_f32(map.a[1]), b1 = cv::vx_setall_f32(map.b[1]);
+        const cv::v_float32 a2 = cv::vx_setall_f32(map.a[2]), b2 = cv::vx_setall_f32(map.b[2]);
+        for (; i <= count - lanes; i += lanes) {
+            cv::v_store_interleave(out + i * 3,
+                                   loadQuantised(rows[map.plane[0]] + x + i, a0, b0, vLow, vHigh),
+                                   loadQuantised(rows[map.plane[1]] + x + i, a1, b1, vLow, vHigh),
+                                   loadQuantised(rows[map.plane[2]] + x + i, a2, b2, vLow, vHigh));
+        }
+    } else if (channels == 1) {
+        const cv::v_float32 a0 = cv::vx_setall_f32(map.a[0]), b0 = cv::vx_setall_f32(map.b[0]);
+        for (; i <= count - lanes; i += lanes) {
+            cv::v_store(out + i, loadQuantised(rows[0] + x + i, a0, b0, vLow, vHigh));
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        for (int c = 0; c < channels; c++) {
+            float value = std::min(std::max(rows[map.plane[c]][x + i] * map.a[c] + map.b[c], low), high);
+            out[i * channels + c] = cv::saturate_cast<uchar>(cvRound(value));
+        }
+    }
+}
+
+void unpackSpan(const float* const* rows, int x, int count, const ChannelMap& map, bool clamp, float* out) {
+    const int channels = map.channels;
+    const float low = clamp ? 0.0f : -FLT_MAX;
+    const float high = clamp ? 1.0f : FLT_MAX;
+    int i = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_float32>::vlanes();
+    const cv::v_float32 vLow = cv::vx_setall_f32(low), vHigh = cv::vx_setall_f32(high);
+    auto load = [&](int c, int at) {
+        cv::v_float32 value = cv::v_fma(cv::vx_load(rows[map.plane[c]] + x + at), cv::vx_setall_f32(map.a[c]),
+                                        cv::vx_setall_f32(map.b[c]));
+        return cv::v_min(cv::v_max(value, vLow), vHigh);
+    };
+    if (channels == 3) {
+        for (; i <= count - lanes; i += lanes) {
+            cv::v_store_interleave(out + i * 3, load(0, i), load(1, i), load(2, i));
+        }
+    } else if (channels == 1) {
+        for (; i <= count - lanes; i += lanes) {
+            cv::v_store(out + i, load(0, i));
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        for (int c = 0; c < channels; c++) {
+            out[i * channels + c] = std::min(std::max(rows[map.plane[c]][x + i] * map.a[c] + map.b[c], low), high);
+        }
+    }
+}
+
+template <typename T>
+void unpackRows(const float* planes, cv::Size planeSize, const cv::Rect& region, cv::Mat& dst, const ChannelMap& map,
+                bool clamp, int rowBegin, int rowEnd) {
+    const size_t planeArea = static_cast<size_t>(planeSize.area());
+    for (int y = rowBegin; y < rowEnd; y++) {
+        const float* rows[4];
+        for (int p = 0; p < map.channels; p++) {
+            rows[p] = planes + p * planeArea + static_cast<size_t>(region.y + y) * planeSize.width;
+        }
+        unpackSpan(rows, region.x, region.width, map, clamp, dst.ptr<T>(y));
+    }
+}
+
+int stripeCount(int rows) {
+    return (rows + kStripeRows - 1) / kStripeRows;
+}
+
+}  // namespace
+
+bool packToNchw(const cv::Mat& src, const cv::Rect& region, float* planes, const PackParams& params) {
+    EE_TRACE_SCOPE("packToNchw");
+    const int depth = src.depth();
+    if (src.empty() || (depth != CV_8U && depth != CV_32F) || src.channels() > 4 || region.empty() ||
+        planes == nullptr) {
+        EE_LOGE("packToNchw: unsupported input type %d", src.type());
+        return false;
+    }
+    ChannelMap map;
+    map.channels = src.channels();
+    for (int c = 0; c < map.channels; c++) {
+        const int plane = planeOf(c, map.channels, params.swapRB);
+        map.plane[c] = plane;
+        map.a[c] = static_cast<float>(params.scale / params.std[plane]);
+        map.b[c] = static_cast<float>(-params.mean[plane] / params.std[plane]);
+    }
+    cv::parallel_for_(cv::Range(0, stripeCount(region.height)), [&](const cv::Range& range) {
+        const int rowBegin = range.start * kStripeRows;
+        const int rowEnd = std::min(range.end * kStripeRows, region.height);
+        if (depth == CV_8U) {
+            packRows<uchar>(src, region, planes, map, params.borderType, rowBegin, rowEnd);
+        } else {
+            packRows<float>(src, region, planes, map, params.borderType, rowBegin, rowEnd);
+        }
+    });
+    return true;
+}
+
+bool unpackFromNchw(const float* planes, cv::Size planeSize, const cv::Rect& region, cv::Mat& dst,
+                    const UnpackParams& params) {
+    EE_TRACE_SCOPE("unpackFromNchw");
+    const int depth = dst.depth();
+    if (planes == nullptr || dst.size() != region.size() || (depth != CV_8U && depth != CV_32F) ||
+        dst.channels() > 4 || (region & cv::Rect(cv::Point(), planeSize)) != region) {
+        EE_LOGE("unpackFromNchw: cannot write a %dx%d region to a %dx%d image of type %d", region.width,
+                region.height, dst.cols, dst.rows, dst.type());
+        return false;
+    }
+    // 8-bit output is quantised as round(value * 255), so the 255 is folded into the affine map.
+    const double quantisation = depth == CV_8U ? 255.0 : 1.0;
+    ChannelMap map;
+    map.channels = dst.channels();
+    for (int c = 0; c < map.channels; c++) {
+        map.plane[c] = planeOf(c, map.channels, params.swapRB);
+        map.a[c] = static_cast<float>(params.scale * quantisation);
+        map.b[c] = static_cast<float>(params.offset * quantisation);
+    }
+    cv::parallel_for_(cv::Range(0, stripeCount(region.height)), [&](const cv::Range& range) {
+        const int rowBegin = range.start * kStripeRows;
+        const int rowEnd = std::min(range.end * kStripeRows, region.height);
+        if (depth == CV_8U) {
+            unpackRows<uchar>(planes, planeSize, region, dst, map, params.clamp, rowBegin, rowEnd);
+        } else {
+            unpackRows<float>(planes, planeSize, region, dst, map, params.clamp, rowBegin, rowEnd);
+        }
+    });
+    return true;
+}
+
+}  // namespace eagleeye
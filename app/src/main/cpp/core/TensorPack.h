@@ -0,0 +1,46 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+namespace eagleeye {
+
+/*
+ * How pixels become tensor values: tensor = (pixel * scale - mean[c]) / std[c] for tensor channel c, with
+ * channels 0 and 2 swapped in the tensor if swapRB is set. Parts of the region outside the image are filled
+ * according to borderType (BORDER_CONSTANT pads with pixel value 0, before normalisation).
+ */
+struct PackParams {
+    double scale = 1.0 / 255.0;
+    cv::Scalar mean = cv::Scalar::all(0.0);
+    cv::Scalar std = cv::Scalar::all(1.0);
+    bool swapRB = false;
+    int borderType = cv::BORDER_REFLECT;
+};
+
+/*
+ * How tensor values become pixels: pixel = tensor * scale + offset, clamped to [0, 1] if clamp is set, and
+ * quantised to round(pixel * 255) for 8-bit output. swapRB as for packing.
+ */
+struct UnpackParams {
+    double scale = 1.0;
+    double offset = 0.0;
+    bool clamp = true;
+    bool swapRB = false;
+};
+
+/*
+ * Interleaved image -> planar NCHW float tensor in one pass, with the normalisation fused in. Writes
+ * src.channels() planes of region.area() floats each to planes. The region may extend past the image; that part
+ * is padded per params.borderType. src is 8-bit or float with 1 to 4 channels; returns false otherwise.
+ */
+bool packToNchw(const cv::Mat& src, const cv::Rect& region, float* planes, const PackParams& params);
+
+/*
+ * Planar NCHW float tensor -> interleaved image. Reads region of the first dst.channels() planes, each planeSize
+ * large, and writes it to dst, usually an ROI of a larger image. dst must already have region's size and 8-bit
+ * or float depth; returns false if it does not or the region is not inside the planes.
+ */
+bool unpackFromNchw(const float* planes, cv::Size planeSize, const cv::Rect& region, cv::Mat& dst,
+                    const UnpackParams& params);
+
+}  // namespace eagleeye
@@ -0,0 +1,181 @@
+#include "TileBlend.h"
+
+#include "Log.h"
+#include "Trace.h"
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace eagleeye {
+
+namespace {
+
+constexpr int kStripeRows = 32;
+
+int stripeCount(int rows) {
+    return (rows + kStripeRows - 1) / kStripeRows;
+}
+
+/*
+ * out[i] += scale * ramp[i] * in[i] for count floats.
+ */
+void addWeighted(const float* in, const float* ramp, float scale, int count, float* out) {
+    int i = 0;
+#if CV_SIMD
+    const int lanes = cv::VTraits<cv::v_float32>::vlanes();
+    const cv::v_float32 vScale = cv::vx_setall_f32(scale);
+    for (; i <= count - lanes; i += lanes) {
+        cv::v_float32 w = cv::v_mul(cv::vx_load(ramp + i), vScale);
+        cv::v_store(out + i, cv::v_fma(cv::vx_load(in + i), w, cv::vx_load(out + i)));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] += scale * ramp[i] * in[i];
+    }
+}
+
+}  // namespace
+
+std::vector<int> TileBlender::origins(int length, int patchSize, int halo) {
+    std::vector<int> result;
+    const int stride = patchSize - halo;
+    if (length <= 0 || stride <= halo) {
+        return result;
+    }
+    const int last = std::max(-halo, length + halo - patchSize);
+    for (int origin = -halo; origin < last; origin += stride) {
+        result.push_back(origin);
+    }
+    result.push_back(last);
+    return result;
+}
+
+bool TileBlender::begin(const cv::Mat& dst, int patchSize, int halo, const UnpackParams& params) {
+    const int depth = dst.depth();
+    if (dst.empty() || (depth != CV_8U && depth != CV_32F) || dst.channels() > 4 || halo < 0 ||
+        2 * halo >= patchSize) {
+        EE_LOGE("TileBlender: cannot blend %d patches with halo %d into a %dx%d image of type %d", patchSize, halo,
+                dst.cols, dst.rows, dst.type());
+        return false;
+    }
+    dst_ = dst;
+    channels_ = dst.channels();
+    patchSize_ = patchSize;
+    params_ = params;
+    windowTop_ = 0;
+
+    // Raised-cosine ramp sampled at pixel centres: ramp[t] + ramp[halo - 1 - t] == 1 across an overlap of halo.
+    ramp_.assign(patchSize, 1.0f);
+    for (int t = 0; t < halo; t++) {
+        const float rise = static_cast<float>(0.5 - 0.5 * std::cos(CV_PI * (t + 0.5) / halo));
+        ramp_[t] = rise;
+        ramp_[patchSize - 1 - t] = rise;
+    }
+    const size_t windowArea = static_cast<size_t>(patchSize) * dst.cols;
+    sum_.assign(windowArea * channels_, 0.0f);
+    weight_.assign(windowArea, 0.0f);
+    return true;
+}
+
+bool TileBlender::add(const float* planes, cv::Point origin) {
+    EE_TRACE_SCOPE("TileBlender::add");
+    if (!isActive() || planes == nullptr) {
+        EE_LOGE("TileBlender: add() without begin()");
+        return false;
+    }
+    const int top = std::max(origin.y, 0);
+    if (top < windowTop_) {
+        EE_LOGE("TileBlender: patch at row %d added after row %d", origin.y, windowTop_);
+        return false;
+    }
+    // Nothing added later starts above this patch, so the rows above it are final.
+    while (windowTop_ < std::min(top, dst_.rows)) {
+        if (!flush(std::min(top, dst_.rows) - windowTop_)) {
+            return false;
+        }
+    }
+    const cv::Rect inside = cv::Rect(origin, cv::Size(patchSize_, patchSize_)) & cv::Rect(cv::Point(), dst_.size());
+    if (inside.empty()) {
+        return true;
+    }
+    const int width = dst_.cols;
+    const size_t windowArea = static_cast<size_t>(patchSize_) * width;
+    const size_t patchArea = static_cast<size_t>(patchSize_) * patchSize_;
+    const int px = inside.x - origin.x;
+    const float* ramp = ramp_.data() + px;
+    cv::parallel_for_(cv::Range(0, stripeCount(inside.height)), [&](const cv::Range& range) {
+        const int rowEnd = std::min(range.end * kStripeRows, inside.height);
+        for (int r = range.start * kStripeRows; r < rowEnd; r++) {
+            const int y = inside.y + r;
+            const int py = y - origin.y;
+            const float rowWeight = ramp_[py];
+            const size_t at = static_cast<size_t>(y - windowTop_) * width + inside.x;
+            for (int x = 0; x < inside.width; x++) {
+                weight_[at + x] += rowWeight * ramp[x];
+            }
+            for (int c = 0; c < channels_; c++) {
+                addWeighted(planes + c * patchArea + static_cast<size_t>(py) * patchSize_ + px, ramp, rowWeight,
+                            inside.width, sum_.data() + c * windowArea + at);
+            }
+        }
+    });
+    return true;
+}
+
+/*
+ * Normalises and writes the first rows of the window, then moves the window down by that much.
+ */
+bool TileBlender::flush(int rows) {
+    EE_TRACE_SCOPE("TileBlender::flush");
+    rows = std::min({rows, patchSize_, dst_.rows - windowTop_});
+    if (rows <= 0) {
+        return false;
+    }
+    const int width = dst_.cols;
+    const size_t windowArea = static_cast<size_t>(patchSize_) * width;
+    cv::parallel_for_(cv::Range(0, stripeCount(rows)), [&](const cv::Range& range) {
+        const int rowEnd = std::min(range.end * kStripeRows, rows);
+        const size_t end = static_cast<size_t>(rowEnd) * width;
+        for (size_t i = static_cast<size_t>(range.start) * kStripeRows * width; i < end; i++) {
+            const float inverse = weight_[i] > 0.0f ? 1.0f / weight_[i] : 0.0f;
+            for (int c = 0; c < channels_; c++) {
+                sum_[c * windowArea + i] *= inverse;
+            }
+        }
+    });
+    cv::Mat out = dst_.rowRange(windowTop_, windowTop_ + rows);
+    if (!unpackFromNchw(sum_.data(), cv::Size(width, patchSize_), cv::Rect(0, 0, width, rows), out, params_)) {
+        return false;
+    }
+
+    const size_t kept = static_cast<size_t>(patchSize_ - rows) * width;
+    const size_t shift = static_cast<size_t>(rows) * width;
+    for (int c = 0; c <= channels_; c++) {
+        float* plane = c < channels_ ? sum_.data() + c * windowArea : weight_.data();
+        std::memmove(plane, plane + shift, kept * sizeof(float));
+        std::fill(plane + kept, plane + windowArea, 0.0f);
+    }
+    windowTop_ += rows;
+    return true;
+}
+
+bool TileBlender::finish() {
+    EE_TRACE_SCOPE("TileBlender::finish");
+    if (!isActive()) {
+        EE_LOGE("TileBlender: finish() without begin()");
+        return false;
+    }
+    bool written = true;
+    while (written && windowTop_ < dst_.rows) {
+        written = flush(dst_.rows - windowTop_);
+    }
+    dst_.release();
+    std::vector<float>().swap(sum_);
+    std::vector<float>().swap(weight_);
+    return written;
+}
+
+}  // namespace eagleeye
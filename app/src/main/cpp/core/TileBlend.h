@@ -0,0 +1,66 @@
+#pragma once
+
+#include "core/TensorPack.h"
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace eagleeye {
+
+/*
+ * Feathered blending of overlapping model output patches. Each patch is weighted with a raised-cosine ramp over
+ * the halo pixels along its edges and folded into a planar float accumulator plus a weight plane, which are
+ * divided when the rows are written out. Where two patches overlap by exactly the halo the ramps sum to one, so a
+ * patch's content fades into its neighbour's instead of ending at a hard seam, and a small halo is enough to hide
+ * the seams.
+ *
+ * Patches are added in raster order (origin.y never decreases). The accumulator then only has to span one patch
+ * height: the rows above the current patch row are final and are written to the output as soon as a patch
+ * further down arrives. For 512 px RGB patches that is 512 rows x width x 4 floats, ~33 MB at 12 MP and ~67 MB at
+ * 50 MP, instead of a full-image accumulator of 0.2 / 0.8 GB.
+ *
+ * Usage: begin(dst, ...) -> add() for every patch, one at a time, in raster order -> finish().
+ */
+class TileBlender {
+public:
+    /*
+     * Patch origins along an axis of the given length: the first at -halo, then every patchSize - halo pixels,
+     * so neighbouring patches overlap by halo and the ramps at the image borders fall into the padding. The last
+     * patch is moved back to end halo pixels past the image, so it is padded no more than the first.
+     */
+    static std::vector<int> origins(int length, int patchSize, int halo);
+
+    /*
+     * Starts blending patches of patchSize x patchSize into dst, an allocated 8-bit or float image with 1 to 4
+     * channels; patches have one plane per channel. Values are written as unpackFromNchw does with params. halo
+     * must be less than half the patch size.
+     */
+    bool begin(const cv::Mat& dst, int patchSize, int halo, const UnpackParams& params);
+
+    /*
+     * Adds one patch (channels planes of patchSize x patchSize floats) whose top-left corner lands at origin in
+     * the image. Parts outside the image are ignored. Returns false if the patch comes out of raster order.
+     */
+    bool add(const float* planes, cv::Point origin);
+
+    /*
+     * Writes the remaining rows and releases the accumulation buffers.
+     */
+    bool finish();
+
+    bool isActive() const { return !dst_.empty(); }
+
+private:
+    bool flush(int rows);
+
+    cv::Mat dst_;
+    int channels_ = 0;
+    int patchSize_ = 0;
+    UnpackParams params_;
+    int windowTop_ = 0;        // image row of the first accumulator row
+    std::vector<float> ramp_;  // weight profile across a patch, the same for rows and columns
+    std::vector<float> sum_;   // channels_ planes of patchSize_ rows x image width
+    std::vector<float> weight_;
+};
+
+}  // namespace eagleeye
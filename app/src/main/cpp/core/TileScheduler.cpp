@@ -0,0 +1,95 @@
+#include "TileScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace eagleeye {
+
+namespace {
+
+// Smallest tile side forBudget will go down to. Below this the halo dominates and per-tile overhead wins.
+constexpr int kMinTileSide = 32;
+
+// Tile edges along one axis of `length` pixels, `count` tiles of `step` pixels with the remainder going to
+// the last tile.
+std::vector<int> edges(int length, int count, int step) {
+    std::vector<int> result;
+    result.reserve(count + 1);
+    for (int i = 0; i < count; i++) {
+        result.push_back(i * step);
+    }
+    result.push_back(length);
+    return result;
+}
+
+// Tiles of exactly `tile` pixels along an axis, except the last one which takes what is left.
+std::vector<int> fixedEdges(int length, int tile) {
+    tile = std::max(1, tile);
+    return edges(length, (length + tile - 1) / tile, tile);
+}
+
+// Splits `length` into tiles of at most `maxTile` pixels of as equal size as possible.
+std::vector<int> balancedEdges(int length, int maxTile) {
+    int count = std::max(1, (length + maxTile - 1) / maxTile);
+    std::vector<int> result;
+    result.reserve(count + 1);
+    for (int i = 0; i <= count; i++) {
+        result.push_back(static_cast<int>(static_cast<int64_t>(length) * i / count));
+    }
+    return result;
+}
+
+}  // namespace
+
+TileScheduler::TileScheduler(cv::Size imageSize, cv::Size tileSize, int halo)
+    : TileScheduler(imageSize, fixedEdges(imageSize.width, tileSize.width),
+                    fixedEdges(imageSize.height, tileSize.height), halo) {}
+
+TileScheduler::TileScheduler(cv::Size imageSize, const std::vector<int>& xEdges, const std::vector<int>& yEdges,
+                             int halo)
+    : imageSize_(imageSize),
+      rows_(static_cast<int>(yEdges.size()) - 1),
+      cols_(static_cast<int>(xEdges.size()) - 1),
+      halo_(std::max(0, halo)) {
+    cv::Rect bounds(0, 0, imageSize.width, imageSize.height);
+    tiles_.reserve(std::max(0, rows_ * cols_));
+    for (int row = 0; row < rows_; row++) {
+        for (int col = 0; col < cols_; col++) {
+            Tile tile;
+            tile.index = static_cast<int>(tiles_.size());
+            tile.row = row;
+            tile.col = col;
+            tile.crop = cv::Rect(xEdges[col], yEdges[row], xEdges[col + 1] - xEdges[col],
+                                 yEdges[row + 1] - yEdges[row]);
+            if (tile.crop.empty()) {
+                continue;
+            }
+            tile.region = cv::Rect(tile.crop.x - halo_, tile.crop.y - halo_, tile.crop.width + 2 * halo_,
+                                   tile.crop.height + 2 * halo_) & bounds;
+            tiles_.push_back(tile);
+        }
+    }
+}
+
+TileScheduler TileScheduler::grid(cv::Size imageSize, int divisionFactor, int halo) {
+    divisionFactor = std::max(1, divisionFactor);
+    return TileScheduler(imageSize, edges(imageSize.width, divisionFactor, imageSize.width / divisionFactor),
+                         edges(imageSize.height, divisionFactor, imageSize.height / divisionFactor), halo);
+}
+
+TileScheduler TileScheduler::forBudget(cv::Size imageSize, int64_t bytesPerPixel, int64_t budgetBytes, int halo) {
+    int64_t pixels = budgetBytes / std::max<int64_t>(1, bytesPerPixel);
+    int side = static_cast<int>(std::sqrt(static_cast<double>(std::max<int64_t>(0, pixels)))) - 2 * std::max(0, halo);
+    side = std::max(kMinTileSide, side);
+    return TileScheduler(imageSize, balancedEdges(imageSize.width, side), balancedEdges(imageSize.height, side), halo);
+}
+
+cv::Rect TileScheduler::scaleRect(const cv::Rect& rect, double scale) {
+    int x0 = cvRound(rect.x * scale);
+    int y0 = cvRound(rect.y * scale);
+    int x1 = cvRound((rect.x + rect.width) * scale);
+    int y1 = cvRound((rect.y + rect.height) * scale);
+    return cv::Rect(x0, y0, x1 - x0, y1 - y0);
+}
+
+}  // namespace eagleeye
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace eagleeye {
+
+/*
+ * One tile of a TileScheduler. region is the area to read, including the halo and clipped to the image.
+ * crop is the part of the image this tile owns; the crops of all tiles cover the image exactly once.
+ */
+struct Tile {
+    int index = 0;
+    int row = 0;
+    int col = 0;
+    cv::Rect region;
+    cv::Rect crop;
+
+    /*
+     * crop relative to the top-left corner of region, i.e. the part of a processed region to keep.
+     */
+    cv::Rect cropInRegion() const { return crop - region.tl(); }
+};
+
+/*
+ * Splits an image into a grid of tiles that overlap by a halo, so that filters and resampling near tile borders
+ * see real neighbouring pixels instead of a border extrapolation and the stitched result has no seams.
+ *
+ * Tiles are processed by reading region, running the operation, and writing back only cropInRegion() of the
+ * result to crop. Crops are disjoint, so tiles can be processed in parallel straight into a shared output.
+ *
+ * This is for OpenCV kernels over a whole frame (UnsharpMask, WarpFusion, ShiftAddFusion, QuadrantMerge), where
+ * tiles may be any size and each output pixel comes from exactly one tile. Model inputs are not laid out here:
+ * they need fixed-size patches that run past the image edge and overlap for feathering, which is what
+ * TileBlender::origins produces for packToNchw and TileBlender.
+ */
+class TileScheduler {
+public:
+    /*
+     * Tiles of at most tileSize (the last row/column is smaller if the image does not divide evenly), each
+     * extended by halo pixels on every side.
+     */
+    TileScheduler(cv::Size imageSize, cv::Size tileSize, int halo);
+
+    /*
+     * The fixed divisionFactor x divisionFactor grid used by the quadrant code (ImageOperator.divideImages /
+     * performJNIInterpolation): the last row/column carries the division remainder.
+     */
+    static TileScheduler grid(cv::Size imageSize, int divisionFactor, int halo);
+
+    /*
+     * Tiles sized so that one tile including its halo takes at most budgetBytes at bytesPerPixel, balanced so
+     * that all tiles of a row/column have about the same size.
+     */
+    static TileScheduler forBudget(cv::Size imageSize, int64_t bytesPerPixel, int64_t budgetBytes, int halo);
+
+    /*
+     * Maps a rect to the grid of the image scaled by `scale`. Adjacent rects map to adjacent rects, so scaled
+     * crops still cover the scaled image exactly once.
+     */
+    static cv::Rect scaleRect(const cv::Rect& rect, double scale);
+
+    const std::vector<Tile>& tiles() const { return tiles_; }
+    cv::Size imageSize() const { return imageSize_; }
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int halo() const { return halo_; }
+
+private:
+    TileScheduler(cv::Size imageSize, const std::vector<int>& xEdges, const std::vector<int>& yEdges, int halo);
+
+    cv::Size imageSize_;
+    int rows_ = 0;
+    int cols_ = 0;
+    int halo_ = 0;
+    std::vector<Tile> tiles_;
+};
+
+}  // namespace eagleeye
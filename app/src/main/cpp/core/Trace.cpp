@@ -0,0 +1,237 @@
+#include "Trace.h"
+
+#include "Log.h"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <sys/stat.h>
+#include <vector>
+
+namespace eagleeye {
+namespace trace {
+
+std::atomic<bool> gEnabled(false);
+
+namespace {
+
+// Recording stops (and the trace is marked truncated) past this many events, so a runaway loop cannot
+// exhaust memory on device.
+constexpr size_t kMaxEvents = 200000;
+
+// Thread id of the task spans coming from ProgressManager.
+constexpr int kPipelineTid = 0;
+
+constexpr const char* kCounterNames[] = {
+    "bytesRead", "bytesWritten", "jpegDecodes", "jpegEncodes", "matsAllocated", "tilesProcessed",
+};
+static_assert(sizeof(kCounterNames) / sizeof(kCounterNames[0]) == static_cast<size_t>(Counter::Count),
+              "every counter needs a name");
+
+using CounterValues = std::array<int64_t, static_cast<size_t>(Counter::Count)>;
+
+struct Event {
+    char phase;        // 'X' complete event, 'C' counter sample
+    std::string name;
+    int tid;
+    int64_t ts;
+    int64_t dur;
+    CounterValues counters;
+};
+
+std::atomic<int64_t> gCounters[static_cast<size_t>(Counter::Count)];
+std::atomic<int> gNextTid(kPipelineTid + 1);
+
+std::mutex gMutex;
+std::vector<Event> gEvents;
+bool gTruncated = false;
+int64_t gEpochMicros = 0;
+std::string gTaskName;
+int64_t gTaskStart = 0;
+
+int64_t steadyMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int currentTid() {
+    thread_local int tid = gNextTid.fetch_add(1, std::memory_order_relaxed);
+    return tid;
+}
+
+CounterValues snapshotCounters() {
+    CounterValues values {};
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = gCounters[i].load(std::memory_order_relaxed);
+    }
+    return values;
+}
+
+// Must be called with gMutex held.
+void pushEvent(Event event) {
+    if (gEvents.size() >= kMaxEvents) {
+        gTruncated = true;
+        return;
+    }
+    gEvents.push_back(std::move(event));
+}
+
+// Must be called with gMutex held.
+void closeTask(int64_t now) {
+    if (gTaskName.empty()) {
+        return;
+    }
+    pushEvent({'X', gTaskName, kPipelineTid, gTaskStart, now - gTaskStart, {}});
+    gTaskName.clear();
+}
+
+// Must be called with gMutex held.
+void sampleCounters(int64_t now) {
+    pushEvent({'C', "counters", kPipelineTid, now, 0, snapshotCounters()});
+}
+
+void writeEscaped(FILE* file, const std::string& text) {
+    for (char c : text) {
+        switch (c) {
+            case '"': std::fputs("\\\"", file); break;
+            case '\\': std::fputs("\\\\", file); break;
+            case '\n': std::fputs("\\n", file); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    std::fprintf(file, "\\u%04x", c);
+                } else {
+                    std::fputc(c, file);
+                }
+        }
+    }
+}
+
+}  // namespace
+
+void beginCapture() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gEvents.clear();
+    gTruncated = false;
+    gTaskName.clear();
+    for (auto& counter : gCounters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    gEpochMicros = steadyMicros();
+    gEnabled.store(true, std::memory_order_relaxed);
+}
+
+bool endCapture(const std::string& path) {
+    std::vector<Event> events;
+    bool truncated;
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        if (!enabled()) {
+            return false;
+        }
+        int64_t now = steadyMicros() - gEpochMicros;
+        closeTask(now);
+        sampleCounters(now);
+        gEnabled.store(false, std::memory_order_relaxed);
+        events.swap(gEvents);
+        truncated = gTruncated;
+    }
+
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        EE_LOGE("Could not open trace file %s", path.c_str());
+        return false;
+    }
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    std::fprintf(file, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"pipeline\"}}",
+                 kPipelineTid);
+    for (const Event& event : events) {
+        std::fputs(",\n{\"ph\":\"", file);
+        std::fputc(event.phase, file);
+        std::fputs("\",\"name\":\"", file);
+        writeEscaped(file, event.name);
+        std::fprintf(file, "\",\"pid\":1,\"tid\":%d,\"ts\":%lld", event.tid, static_cast<long long>(event.ts));
+        if (event.phase == 'X') {
+            std::fprintf(file, ",\"dur\":%lld}", static_cast<long long>(event.dur));
+        } else {
+            std::fputs(",\"args\":{", file);
+            for (size_t i = 0; i < event.counters.size(); i++) {
+                std::fprintf(file, "%s\"%s\":%lld", i == 0 ? "" : ",", kCounterNames[i],
+                             static_cast<long long>(event.counters[i]));
+            }
+            std::fputs("}}", file);
+        }
+    }
+    std::fprintf(file, "\n],\"otherData\":{\"truncated\":%s}}\n", truncated ? "true" : "false");
+    bool ok = std::fclose(file) == 0;
+    EE_LOGI("Wrote %zu trace events to %s", events.size(), path.c_str());
+    return ok;
+}
+
+void beginTask(const std::string& name) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (!enabled()) {
+        return;
+    }
+    int64_t now = steadyMicros() - gEpochMicros;
+    closeTask(now);
+    sampleCounters(now);
+    gTaskName = name;
+    gTaskStart = now;
+}
+
+void endTask() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (!enabled()) {
+        return;
+    }
+    int64_t now = steadyMicros() - gEpochMicros;
+    closeTask(now);
+    sampleCounters(now);
+}
+
+void countSlow(Counter counter, int64_t delta) {
+    gCounters[static_cast<size_t>(counter)].fetch_add(delta, std::memory_order_relaxed);
+}
+
+int64_t counterValue(Counter counter) {
+    return gCounters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+}
+
+void countImageRead(const std::string& path) {
+    if (!enabled()) {
+        return;
+    }
+    struct stat info {};
+    if (::stat(path.c_str(), &info) == 0) {
+        countSlow(Counter::BytesRead, info.st_size);
+    }
+    countSlow(Counter::JpegDecodes, 1);
+}
+
+void countImageWritten(const std::string& path) {
+    if (!enabled()) {
+        return;
+    }
+    struct stat info {};
+    if (::stat(path.c_str(), &info) == 0) {
+        countSlow(Counter::BytesWritten, info.st_size);
+    }
+    countSlow(Counter::JpegEncodes, 1);
+}
+
+int64_t ScopedTimer::nowMicros() {
+    return steadyMicros();
+}
+
+void ScopedTimer::record() {
+    int64_t end = steadyMicros();
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (!enabled()) {
+        return;
+    }
+    pushEvent({'X', name_, currentTid(), start_ - gEpochMicros, end - start_, {}});
+}
+
+}  // namespace trace
+}  // namespace eagleeye
@@ -0,0 +1,106 @@
+#pragma once
+
+// Lightweight tracing for the native stages: scoped timers and global counters, exported as Chrome trace-event
+// JSON (load the file in chrome://tracing or ui.perfetto.dev).
+//
+// Always compiled in. While no capture is running every EE_TRACE_* call is a single relaxed atomic load.
+//
+//    void mergeQuadrants(...) {
+//        EE_TRACE_SCOPE("mergeQuadrants");
+//        ...
+//        EE_TRACE_COUNT(trace::Counter::JpegDecodes, 1);
+//    }
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace eagleeye {
+namespace trace {
+
+enum class Counter {
+    BytesRead = 0,
+    BytesWritten,
+    JpegDecodes,
+    JpegEncodes,
+    MatsAllocated,
+    TilesProcessed,
+    Count
+};
+
+extern std::atomic<bool> gEnabled;
+
+inline bool enabled() {
+    return gEnabled.load(std::memory_order_relaxed);
+}
+
+/*
+ * Starts a new capture: drops previously recorded events, zeroes the counters and enables recording.
+ */
+void beginCapture();
+
+/*
+ * Stops recording and writes the capture to `path` as Chrome trace-event JSON. Returns false if the file could
+ * not be written.
+ */
+bool endCapture(const std::string& path);
+
+/*
+ * Ends the current task span (if any) and starts a new one called `name` on the pipeline track. Task spans
+ * mirror the ProgressManager tasks on the Kotlin side. A sample of every counter is recorded at each boundary.
+ */
+void beginTask(const std::string& name);
+void endTask();
+
+void countSlow(Counter counter, int64_t delta);
+
+inline void count(Counter counter, int64_t delta) {
+    if (enabled()) {
+        countSlow(counter, delta);
+    }
+}
+
+int64_t counterValue(Counter counter);
+
+/*
+ * Adds the size of the file at `path` to BytesRead / BytesWritten and bumps JpegDecodes / JpegEncodes.
+ * The file is only stat'ed while a capture is running.
+ */
+void countImageRead(const std::string& path);
+void countImageWritten(const std::string& path);
+
+/*
+ * Records a complete event from construction to destruction on the calling thread.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* name) : name_(enabled() ? name : nullptr) {
+        if (name_ != nullptr) {
+            start_ = nowMicros();
+        }
+    }
+
+    ~ScopedTimer() {
+        if (name_ != nullptr) {
+            record();
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    static int64_t nowMicros();
+    void record();
+
+    const char* name_;
+    int64_t start_ = 0;
+};
+
+}  // namespace trace
+}  // namespace eagleeye
+
+#define EE_TRACE_CONCAT_INNER(a, b) a##b
+#define EE_TRACE_CONCAT(a, b) EE_TRACE_CONCAT_INNER(a, b)
+#define EE_TRACE_SCOPE(name) ::eagleeye::trace::ScopedTimer EE_TRACE_CONCAT(eeTraceScope, __LINE__)(name)
+#define EE_TRACE_COUNT(counter, delta) ::eagleeye::trace::count(counter, delta)
@@ -0,0 +1,117 @@
+#include "UnsharpMask.h"
+
+#include "Log.h"
+#include "TileScheduler.h"
+#include "Trace.h"
+
+#include <vector>
+
+namespace eagleeye {
+
+namespace {
+
+constexpr int kRadius = 12;  // 25x25 box
+constexpr int kArea = (2 * kRadius + 1) * (2 * kRadius + 1);
+constexpr int kTileSide = 512;
+
+/*
+ * saturate_cast<uchar>(2.25 * a - 1.25 * b) with OpenCV's round-half-even, in integers: (9a - 5b) / 4.
+ */
+inline uchar sharpen(int a, int b) {
+    int v = 9 * a - 5 * b;
+    int q = v >> 2;
+    int r = v & 3;
+    if (r > 2 || (r == 2 && (q & 1))) {
+        q++;
+    }
+    return cv::saturate_cast<uchar>(q);
+}
+
+/*
+ * One tile. The region includes a kRadius halo wherever the tile is not at the image border, and at the border
+ * reflecting inside the region is reflecting inside the image, so the crop comes out as for the whole image.
+ */
+void sharpenTile(const cv::Mat& src, cv::Mat& dst, const Tile& tile, std::vector<int>& rowSums,
+                 std::vector<int>& columnSums) {
+    const cv::Mat region = src(tile.region);
+    const cv::Rect crop = tile.cropInRegion();
+    const int channels = src.channels();
+    const int width = crop.width * channels;
+    rowSums.assign(static_cast<size_t>(region.rows) * width, 0);
+
+    // Horizontal running sums over the crop columns, for every row of the region.
+    for (int y = 0; y < region.rows; y++) {
+        const uchar* in = region.ptr<uchar>(y);
+        int* sums = rowSums.data() + static_cast<size_t>(y) * width;
+        for (int c = 0; c < channels; c++) {
+            int sum = 0;
+            for (int k = -kRadius; k <= kRadius; k++) {
+                sum += in[cv::borderInterpolate(crop.x + k, region.cols, cv::BORDER_REFLECT_101) * channels + c];
+            }
+            sums[c] = sum;
+            for (int x = 1; x < crop.width; x++) {
+                int add = cv::borderInterpolate(crop.x + x + kRadius, region.cols, cv::BORDER_REFLECT_101);
+                int remove = cv::borderInterpolate(crop.x + x - kRadius - 1, region.cols, cv::BORDER_REFLECT_101);
+                sum += in[add * channels + c] - in[remove * channels + c];
+                sums[x * channels + c] = sum;
+            }
+        }
+    }
+
+    // Vertical running sums, fused with the rounding of the blur and the sharpening weights.
+    columnSums.assign(width, 0);
+    for (int k = -kRadius; k <= kRadius; k++) {
+        const int* sums = rowSums.data() +
+                          static_cast<size_t>(cv::borderInterpolate(crop.y + k, region.rows, cv::BORDER_REFLECT_101)) *
+                          width;
+        for (int i = 0; i < width; i++) {
+            columnSums[i] += sums[i];
+        }
+    }
+    for (int y = 0; y < crop.height; y++) {
+        if (y > 0) {
+            int add = cv::borderInterpolate(crop.y + y + kRadius, region.rows, cv::BORDER_REFLECT_101);
+            int remove = cv::borderInterpolate(crop.y + y - kRadius - 1, region.rows, cv::BORDER_REFLECT_101);
+            const int* addSums = rowSums.data() + static_cast<size_t>(add) * width;
+            const int* removeSums = rowSums.data() + static_cast<size_t>(remove) * width;
+            for (int i = 0; i < width; i++) {
+                columnSums[i] += addSums[i] - removeSums[i];
+            }
+        }
+        const uchar* in = region.ptr<uchar>(crop.y + y) + crop.x * channels;
+        uchar* out = dst.ptr<uchar>(tile.crop.y + y) + tile.crop.x * channels;
+        for (int i = 0; i < width; i++) {
+            // The sum is never exactly halfway between two multiples of 625, so this is cvRound(sum / 625.0).
+            int blurred = (columnSums[i] + kArea / 2) / kArea;
+            out[i] = sharpen(in[i], blurred);
+        }
+    }
+}
+
+}  // namespace
+
+bool unsharpMask(const cv::Mat& src, cv::Mat& dst) {
+    EE_TRACE_SCOPE("unsharpMask");
+    if (src.empty() || src.depth() != CV_8U || src.channels() > 4) {
+        EE_LOGE("unsharpMask: unsupported type %d", src.type());
+        return false;
+    }
+    dst.create(src.size(), src.type());
+    if (dst.data == src.data) {
+        EE_LOGE("unsharpMask: dst must not share memory with src");
+        return false;
+    }
+
+    TileScheduler scheduler(src.size(), cv::Size(kTileSide, kTileSide), kRadius);
+    const std::vector<Tile>& tiles = scheduler.tiles();
+    cv::parallel_for_(cv::Range(0, static_cast<int>(tiles.size())), [&](const cv::Range& range) {
+        std::vector<int> rowSums, columnSums;
+        for (int i = range.start; i < range.end; i++) {
+            sharpenTile(src, dst, tiles[i], rowSums, columnSums);
+        }
+    });
+    EE_TRACE_COUNT(trace::Counter::TilesProcessed, static_cast<int64_t>(tiles.size()));
+    return true;
+}
+
+}  // namespace eagleeye
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+namespace eagleeye {
+
+/*
+ * UnsharpMaskOperator: dst = saturate(2.25 * src - 1.25 * blur25(src)) for an 8-bit image with 1 to 4
+ * channels. The 25x25 box blur is a separable running sum, so its cost per pixel does not depend on the
+ * kernel size, and the weighting is fused into the vertical pass; the blurred image is never stored.
+ * Output matches Imgproc.blur (reflect-101 borders) followed by Core.addWeighted bit for bit.
+ *
+ * Runs tile by tile in parallel. dst may be preallocated with the size and type of src; it must not share
+ * memory with src. Returns false if src is not 8-bit.
+ */
+bool unsharpMask(const cv::Mat& src, cv::Mat& dst);
+
+}  // namespace eagleeye
@@ -0,0 +1,117 @@
+#include "WarpEvaluator.h"
+
+#include "EdgeMeasure.h"
+#include "Log.h"
+#include "Trace.h"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace eagleeye {
+
+namespace {
+
+int decodeFlags(int pyramidLevel) {
+    switch (pyramidLevel) {
+        case 1:
+            return cv::IMREAD_REDUCED_COLOR_2;
+        case 2:
+            return cv::IMREAD_REDUCED_COLOR_4;
+        default:
+            return cv::IMREAD_COLOR;
+    }
+}
+
+}  // namespace
+
+WarpEvaluator::WarpEvaluator(int pyramidLevel) : pyramidLevel_(std::clamp(pyramidLevel, 0, 2)) {}
+
+void WarpEvaluator::setReference(const cv::Mat& reference) {
+    EE_TRACE_SCOPE("WarpEvaluator::setReference");
+    if (pyramidLevel_ == 0) {
+        reference_ = reference;
+    } else {
+        // Same rounding of odd sizes as the reduced JPEG decode.
+        int factor = 1 << pyramidLevel_;
+        cv::Size size((reference.cols + factor - 1) / factor, (reference.rows + factor - 1) / factor);
+        cv::resize(reference, reference_, size, 0.0, 0.0, cv::INTER_AREA);
+    }
+    referenceMeasure_ = edgeSobelMeasure(reference_);
+}
+
+int WarpEvaluator::score(const std::string& path) const {
+    EE_TRACE_SCOPE("WarpEvaluator::candidate");
+    cv::Mat candidate = cv::imread(path, decodeFlags(pyramidLevel_));
+    if (candidate.empty()) {
+        EE_LOGE("Could not read alignment candidate %s", path.c_str());
+        return INT_MAX;
+    }
+    trace::countImageRead(path);
+    if (candidate.size() != reference_.size() || candidate.type() != reference_.type()) {
+        EE_LOGE("Alignment candidate %s is %dx%dx%d, reference is %dx%dx%d", path.c_str(), candidate.cols,
+                candidate.rows, candidate.channels(), reference_.cols, reference_.rows, reference_.channels());
+        return INT_MAX;
+    }
+    // Scored whole on this worker: the candidates already keep the pool busy.
+    int measure = edgeSobelCount(candidate, reference_, cv::Rect(0, 0, candidate.cols, candidate.rows));
+    return (measure - referenceMeasure_) * (1 << (2 * pyramidLevel_));
+}
+
+AlignmentChoice WarpEvaluator::evaluate(const std::vector<std::string>& warpedPaths,
+                                        const std::vector<std::string>& medianPaths) const {
+    EE_TRACE_SCOPE("WarpEvaluator::evaluate");
+    CV_Assert(warpedPaths.size() == medianPaths.size());
+    AlignmentChoice result;
+    int count = static_cast<int>(warpedPaths.size());
+    result.warpedScores.assign(count, INT_MAX);
+    result.medianScores.assign(count, INT_MAX);
+    if (reference_.empty()) {
+        EE_LOGE("WarpEvaluator::evaluate without a reference");
+        result.choice.assign(count, 1);
+        return result;
+    }
+
+    cv::parallel_for_(cv::Range(0, 2 * count), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            if (i < count) {
+                result.warpedScores[i] = score(warpedPaths[i]);
+            } else {
+                result.medianScores[i - count] = score(medianPaths[i - count]);
+            }
+        }
+    }, static_cast<double>(2 * count));
+
+    result.choice = choose(result.warpedScores, result.medianScores);
+    for (int i = 0; i < count; i++) {
+        EE_LOGD("Edge measure of %s: %d, %s: %d -> %s", warpedPaths[i].c_str(), result.warpedScores[i],
+                medianPaths[i].c_str(), result.medianScores[i], result.choice[i] == 0 ? "warped" : "median");
+    }
+    return result;
+}
+
+std::vector<int> WarpEvaluator::choose(const std::vector<int>& warpedScores, const std::vector<int>& medianScores) {
+    // Unreadable candidates do not move the mean.
+    double warpedMean = 0.0;
+    int readable = 0;
+    for (int score : warpedScores) {
+        if (score != INT_MAX) {
+            warpedMean += score;
+            readable++;
+        }
+    }
+    warpedMean = readable > 0 ? warpedMean / readable : 0.0;
+
+    std::vector<int> choice(warpedScores.size(), 1);
+    for (size_t i = 0; i < warpedScores.size(); i++) {
+        if (warpedScores[i] < medianScores[i] && std::abs(warpedScores[i] - warpedMean) < kMaxThreshold) {
+            choice[i] = 0;
+        }
+    }
+    return choice;
+}
+
+}  // namespace eagleeye
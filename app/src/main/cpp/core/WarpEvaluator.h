@@ -0,0 +1,59 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+namespace eagleeye {
+
+/*
+ * Edge-consistency scores of both alignment candidates of every frame and the candidate chosen for it.
+ * choice[i] is 0 for warpedPaths[i] and 1 for medianPaths[i]. Candidates that cannot be read score INT_MAX.
+ */
+struct AlignmentChoice {
+    std::vector<int> warpedScores;
+    std::vector<int> medianScores;
+    std::vector<int> choice;
+};
+
+/*
+ * Native counterpart of WarpResultEvaluator. A candidate scores edgeSobelMeasure(reference + candidate) -
+ * edgeSobelMeasure(reference), computed with the fused edgeSobelCount kernel; all 2N candidates are decoded and
+ * scored concurrently on OpenCV's worker pool.
+ *
+ * With pyramidLevel 1 or 2 the measure runs at 1/2 or 1/4 scale: candidates are decoded reduced in the DCT
+ * domain, the reference is area-downsampled, and scores are multiplied by the pixel ratio so they stay
+ * comparable with the full resolution threshold.
+ */
+class WarpEvaluator {
+public:
+    static constexpr int kMaxThreshold = 200000;  // WarpResultEvaluator.MAX_THRESHOLD
+
+    explicit WarpEvaluator(int pyramidLevel = 0);
+
+    /*
+     * Downsamples the 8-bit reference to the evaluation level and measures it. The reference is not kept
+     * beyond that level copy.
+     */
+    void setReference(const cv::Mat& reference);
+
+    int referenceMeasure() const { return referenceMeasure_; }
+
+    AlignmentChoice evaluate(const std::vector<std::string>& warpedPaths,
+                             const std::vector<std::string>& medianPaths) const;
+
+    /*
+     * WarpResultEvaluator.chooseAlignedImages: the warped candidate wins if it scores lower than the median
+     * aligned one and lies within kMaxThreshold of the mean warped score.
+     */
+    static std::vector<int> choose(const std::vector<int>& warpedScores, const std::vector<int>& medianScores);
+
+private:
+    int score(const std::string& path) const;
+
+    int pyramidLevel_;
+    cv::Mat reference_;
+    int referenceMeasure_ = 0;
+};
+
+}  // namespace eagleeye
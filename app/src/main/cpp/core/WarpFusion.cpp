@@ -0,0 +1,110 @@
+#include "WarpFusion.h"
+
+#include "Log.h"
+#include "Trace.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace eagleeye {
+
+namespace {
+
+constexpr int kWarpMargin = 3;  // bicubic support plus rounding of the mapped bounds
+
+/*
+ * warpPerspective(frame, M = inverse^-1) restricted to region of the output. The source is cropped to the
+ * bounding box of where the region maps to, clamped to the frame so that replicated borders stay those of the
+ * whole frame.
+ */
+cv::Mat warpRegion(const cv::Mat& frame, const cv::Matx33d& inverse, const cv::Rect& region) {
+    std::vector<cv::Point2f> corners = {
+        cv::Point2f(static_cast<float>(region.x), static_cast<float>(region.y)),
+        cv::Point2f(static_cast<float>(region.br().x - 1), static_cast<float>(region.y)),
+        cv::Point2f(static_cast<float>(region.br().x - 1), static_cast<float>(region.br().y - 1)),
+        cv::Point2f(static_cast<float>(region.x), static_cast<float>(region.br().y - 1)),
+    };
+    std::vector<cv::Point2f> mapped;
+    cv::perspectiveTransform(corners, mapped, cv::Mat(inverse));
+    float minX = mapped[0].x, maxX = mapped[0].x, minY = mapped[0].y, maxY = mapped[0].y;
+    for (const cv::Point2f& point : mapped) {
+        minX = std::min(minX, point.x);
+        maxX = std::max(maxX, point.x);
+        minY = std::min(minY, point.y);
+        maxY = std::max(maxY, point.y);
+    }
+    int x0 = std::clamp(static_cast<int>(std::floor(minX)) - kWarpMargin, 0, frame.cols - 1);
+    int y0 = std::clamp(static_cast<int>(std::floor(minY)) - kWarpMargin, 0, frame.rows - 1);
+    int x1 = std::clamp(static_cast<int>(std::ceil(maxX)) + kWarpMargin, 0, frame.cols - 1);
+    int y1 = std::clamp(static_cast<int>(std::ceil(maxY)) + kWarpMargin, 0, frame.rows - 1);
+    cv::Rect source(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+
+    cv::Mat map(region.size(), CV_32FC2);
+    for (int y = 0; y < region.height; y++) {
+        cv::Point2f* row = map.ptr<cv::Point2f>(y);
+        double py = region.y + y;
+        for (int x = 0; x < region.width; x++) {
+            double px = region.x + x;
+            double w = inverse(2, 0) * px + inverse(2, 1) * py + inverse(2, 2);
+            w = w != 0.0 ? 1.0 / w : 0.0;
+            row[x].x = static_cast<float>((inverse(0, 0) * px + inverse(0, 1) * py + inverse(0, 2)) * w - x0);
+            row[x].y = static_cast<float>((inverse(1, 0) * px + inverse(1, 1) * py + inverse(1, 2)) * w - y0);
+        }
+    }
+    cv::Mat warped;
+    cv::remap(frame(source), warped, map, cv::noArray(), cv::INTER_CUBIC, cv::BORDER_REPLICATE);
+    return warped;
+}
+
+}  // namespace
+
+WarpFusion::WarpFusion(int tileSide) : tileSide_(std::max(tileSide, 16)) {}
+
+void WarpFusion::begin(const cv::Mat& reference) {
+    EE_TRACE_SCOPE("WarpFusion::begin");
+    reference_ = reference;
+    tiles_ = TileScheduler(reference.size(), cv::Size(tileSide_, tileSide_), 0).tiles();
+    accumulator_.begin(reference.size(), 1.0, reference.channels());
+    accumulator_.add(reference);
+}
+
+bool WarpFusion::addFrame(const cv::Mat& frame, const cv::Mat& homography) {
+    EE_TRACE_SCOPE("WarpFusion::addFrame");
+    if (!accumulator_.isActive() || frame.size() != reference_.size() || frame.type() != reference_.type()) {
+        EE_LOGE("WarpFusion::addFrame frame is %dx%dx%d, expected %dx%dx%d", frame.cols, frame.rows,
+                frame.channels(), reference_.cols, reference_.rows, reference_.channels());
+        return false;
+    }
+    bool warp = homography.rows == 3 && homography.cols == 3;
+    cv::Matx33d inverse;
+    if (warp) {
+        cv::Mat h;
+        homography.convertTo(h, CV_64F);
+        inverse = cv::Matx33d(h).inv();
+    } else {
+        EE_LOGW("WarpFusion: no homography, adding the frame unwarped");
+    }
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(tiles_.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            const Tile& tile = tiles_[i];
+            cv::Mat warped = warp ? warpRegion(frame, inverse, tile.region) : frame(tile.region);
+            accumulator_.addRegion(warped, tile.crop.tl());
+        }
+    }, static_cast<double>(tiles_.size()));
+    accumulator_.endFrame();
+    EE_TRACE_COUNT(trace::Counter::TilesProcessed, static_cast<int64_t>(tiles_.size()));
+    return true;
+}
+
+cv::Mat WarpFusion::finish() {
+    EE_TRACE_SCOPE("WarpFusion::finish");
+    cv::Mat fused = accumulator_.finish();
+    reference_.release();
+    tiles_.clear();
+    return fused;
+}
+
+}  // namespace eagleeye
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "FusionAccumulator.h"
+#include "TileScheduler.h"
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace eagleeye {
+
+/*
+ * Perspective warping and mean fusion in one tiled pass. Each tile of the reference grid is warped from the burst
+ * frame with cv::remap over just the source area its corners map to and folded straight into a FusionAccumulator,
+ * so warped frames are never stored whole, encoded or read back.
+ *
+ * Usage: begin(reference) -> addFrame(frame, homography) for every aligned frame -> finish().
+ */
+class WarpFusion {
+public:
+    static constexpr int kDefaultTileSide = 512;
+
+    explicit WarpFusion(int tileSide = kDefaultTileSide);
+
+    /*
+     * Starts a fusion with the 8-bit reference as its first frame. The reference is not copied and must stay
+     * alive and unchanged until finish().
+     */
+    void begin(const cv::Mat& reference);
+
+    /*
+     * Warps frame by homography (3x3, frame -> reference, as warpPerspective takes it) with bicubic
+     * interpolation and replicated borders, and adds it to the fusion. An empty homography adds the frame as
+     * it is, like LRWarpingOperator does. Returns false if the frame does not match the reference.
+     */
+    bool addFrame(const cv::Mat& frame, const cv::Mat& homography);
+
+    /*
+     * Returns the fused 8-bit image and releases the accumulator.
+     */
+    cv::Mat finish();
+
+private:
+    int tileSide_;
+    cv::Mat reference_;
+    std::vector<Tile> tiles_;
+    FusionAccumulator accumulator_;
+};
+
+}  // namespace eagleeye
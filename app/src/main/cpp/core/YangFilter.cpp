@@ -0,0 +1,139 @@
+#include "YangFilter.h"
+
+#include "Log.h"
+#include "Trace.h"
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace eagleeye {
+
+namespace {
+
+constexpr int kStripeRows = 64;
+
+inline int clampResponse(int value) {
+    return std::min(std::max(value, 0), 255);
+}
+
+inline uchar meanOfResponses(int r1, int r2, int r3, int r4) {
+    int sum = 0;
+    int count = 0;
+    for (int r : {r1, r2, r3, r4}) {
+        if (r > 1) {
+            sum += r;
+            count++;
+        }
+    }
+    return count > 0 ? cv::saturate_cast<uchar>(cvRound(static_cast<float>(sum) / count)) : 0;
+}
+
+/*
+ * Rows [rowBegin, rowEnd) of the fused filter. Vertical neighbours come from reflect-101 row pointers; the
+ * two columns on each side that need horizontal reflection are done in scalar code.
+ */
+void yangEdgeRows(const cv::Mat& src, cv::Mat& dst, int rowBegin, int rowEnd) {
+    const int rows = src.rows;
+    const int cols = src.cols;
+    for (int y = rowBegin; y < rowEnd; y++) {
+        const uchar* up2 = src.ptr<uchar>(cv::borderInterpolate(y - 2, rows, cv::BORDER_REFLECT_101));
+        const uchar* up1 = src.ptr<uchar>(cv::borderInterpolate(y - 1, rows, cv::BORDER_REFLECT_101));
+        const uchar* row = src.ptr<uchar>(y);
+        const uchar* down1 = src.ptr<uchar>(cv::borderInterpolate(y + 1, rows, cv::BORDER_REFLECT_101));
+        const uchar* down2 = src.ptr<uchar>(cv::borderInterpolate(y + 2, rows, cv::BORDER_REFLECT_101));
+        uchar* out = dst.ptr<uchar>(y);
+
+        auto scalarPixel = [&](int x) {
+            int left2 = row[cv::borderInterpolate(x - 2, cols, cv::BORDER_REFLECT_101)];
+            int left1 = row[cv::borderInterpolate(x - 1, cols, cv::BORDER_REFLECT_101)];
+            int right1 = row[cv::borderInterpolate(x + 1, cols, cv::BORDER_REFLECT_101)];
+            int right2 = row[cv::borderInterpolate(x + 2, cols, cv::BORDER_REFLECT_101)];
+            int center = row[x];
+            out[x] = meanOfResponses(clampResponse(down1[x] - up1[x]),
+                                     clampResponse(right1 - left1),
+                                     clampResponse(2 * center - up2[x] - down2[x]),
+                                     clampResponse(2 * center - left2 - right2));
+        };
+
+        int x = 0;
+        for (; x < std::min(2, cols); x++) {
+            scalarPixel(x);
+        }
+#if CV_SIMD
+        const int lanes = cv::VTraits<cv::v_int16>::vlanes();
+        const cv::v_int16 zero = cv::vx_setzero_s16();
+        const cv::v_int16 one = cv::vx_setall_s16(1);
+        const cv::v_int16 max8 = cv::vx_setall_s16(255);
+        const cv::v_int32 one32 = cv::vx_setall_s32(1);
+        auto load = [](const uchar* p) { return cv::v_reinterpret_as_s16(cv::vx_load_expand(p)); };
+        auto clamp = [&](const cv::v_int16& v) { return cv::v_min(cv::v_max(v, zero), max8); };
+        for (; x <= cols - 2 - lanes; x += lanes) {
+            cv::v_int16 center = load(row + x);
+            cv::v_int16 doubled = cv::v_add(center, center);
+            cv::v_int16 responses[4] = {
+                clamp(cv::v_sub(load(down1 + x), load(up1 + x))),
+                clamp(cv::v_sub(load(row + x + 1), load(row + x - 1))),
+                clamp(cv::v_sub(cv::v_sub(doubled, load(up2 + x)), load(down2 + x))),
+                clamp(cv::v_sub(cv::v_sub(doubled, load(row + x - 2)), load(row + x + 2))),
+            };
+            cv::v_int16 sum = zero;
+            cv::v_int16 count = zero;
+            for (const cv::v_int16& response : responses) {
+                cv::v_int16 mask = cv::v_gt(response, one);
+                sum = cv::v_add(sum, cv::v_and(response, mask));
+                count = cv::v_sub(count, mask);  // mask lanes are -1
+            }
+            cv::v_int32 sumLow, sumHigh, countLow, countHigh;
+            cv::v_expand(sum, sumLow, sumHigh);
+            cv::v_expand(count, countLow, countHigh);
+            // Lanes with no response have a zero sum, so dividing them by 1 gives the 0 the Kotlin path writes.
+            cv::v_float32 meanLow = cv::v_div(cv::v_cvt_f32(sumLow), cv::v_cvt_f32(cv::v_max(countLow, one32)));
+            cv::v_float32 meanHigh = cv::v_div(cv::v_cvt_f32(sumHigh), cv::v_cvt_f32(cv::v_max(countHigh, one32)));
+            cv::v_pack_u_store(out + x, cv::v_pack(cv::v_round(meanLow), cv::v_round(meanHigh)));
+        }
+#endif
+        for (; x < cols; x++) {
+            scalarPixel(x);
+        }
+    }
+}
+
+int stripeCount(const cv::Mat& input) {
+    return (input.rows + kStripeRows - 1) / kStripeRows;
+}
+
+}  // namespace
+
+cv::Mat yangEdges(const cv::Mat& input) {
+    std::vector<cv::Mat> outputs = yangEdges(std::vector<cv::Mat>{input});
+    return outputs[0];
+}
+
+std::vector<cv::Mat> yangEdges(const std::vector<cv::Mat>& inputs) {
+    EE_TRACE_SCOPE("yangEdges");
+    std::vector<cv::Mat> outputs(inputs.size());
+    // Flatten (frame, stripe) so that a burst of small energy frames still spreads over every worker.
+    std::vector<std::pair<int, int>> jobs;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (inputs[i].type() != CV_8UC1 || inputs[i].empty()) {
+            EE_LOGE("yangEdges: frame %zu has type %d, expected CV_8UC1", i, inputs[i].type());
+            continue;
+        }
+        outputs[i].create(inputs[i].size(), CV_8UC1);
+        for (int stripe = 0; stripe < stripeCount(inputs[i]); stripe++) {
+            jobs.emplace_back(static_cast<int>(i), stripe);
+        }
+    }
+    cv::parallel_for_(cv::Range(0, static_cast<int>(jobs.size())), [&](const cv::Range& range) {
+        for (int j = range.start; j < range.end; j++) {
+            const cv::Mat& input = inputs[jobs[j].first];
+            int rowBegin = jobs[j].second * kStripeRows;
+            yangEdgeRows(input, outputs[jobs[j].first], rowBegin, std::min(rowBegin + kStripeRows, input.rows));
+        }
+    });
+    return outputs;
+}
+
+}  // namespace eagleeye
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace eagleeye {
+
+/*
+ * YangFilter.perform + YangFilterFusionOperator in one pass over an 8-bit single channel image: the responses
+ * of [-1 0 1] and [-1 0 2 0 -1], vertical and horizontal, each saturated to 8 bits as filter2D does, and the
+ * mean of the responses above 1. The output is bit-exact with the Kotlin path (reflect-101 borders,
+ * round-half-even) but reads every input pixel once and writes 8-bit edges directly, vectorised with OpenCV's
+ * universal intrinsics.
+ *
+ * Returns an empty Mat if the input is not CV_8UC1.
+ */
+cv::Mat yangEdges(const cv::Mat& input);
+
+/*
+ * yangEdges over a batch of frames, with row stripes of all frames processed in parallel.
+ */
+std::vector<cv::Mat> yangEdges(const std::vector<cv::Mat>& inputs);
+
+}  // namespace eagleeye
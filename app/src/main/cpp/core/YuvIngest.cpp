@@ -0,0 +1,90 @@
+#include "YuvIngest.h"
+
+#include "Log.h"
+#include "Sharpness.h"
+#include "Trace.h"
+#include "YangFilter.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <cstring>
+
+namespace eagleeye {
+
+namespace {
+
+constexpr int kEnergyFactor = 8;  // IMREAD_REDUCED_GRAYSCALE_8
+
+void rotate(const cv::Mat& src, cv::Mat& dst, Rotation rotation) {
+    switch (rotation) {
+        case Rotation::Clockwise90:
+            cv::rotate(src, dst, cv::ROTATE_90_CLOCKWISE);
+            break;
+        case Rotation::Rotate180:
+            cv::rotate(src, dst, cv::ROTATE_180);
+            break;
+        case Rotation::CounterClockwise90:
+            cv::rotate(src, dst, cv::ROTATE_90_COUNTERCLOCKWISE);
+            break;
+        default:
+            dst = src;
+            break;
+    }
+}
+
+void packChroma(const uint8_t* plane, int rowStride, int pixelStride, cv::Size size, uint8_t* out) {
+    for (int y = 0; y < size.height; y++) {
+        const uint8_t* in = plane + static_cast<size_t>(y) * rowStride;
+        uint8_t* row = out + static_cast<size_t>(y) * size.width;
+        if (pixelStride == 1) {
+            std::memcpy(row, in, size.width);
+        } else {
+            for (int x = 0; x < size.width; x++) {
+                row[x] = in[x * pixelStride];
+            }
+        }
+    }
+}
+
+}  // namespace
+
+IngestedFrame ingestYuv(const YuvPlanes& planes, Rotation rotation) {
+    EE_TRACE_SCOPE("ingestYuv");
+    IngestedFrame frame;
+    const cv::Size size = planes.size;
+    if (planes.y == nullptr || planes.u == nullptr || planes.v == nullptr || size.width <= 0 ||
+        size.height <= 0 || size.width % 2 != 0 || size.height % 2 != 0) {
+        EE_LOGE("ingestYuv: unusable %dx%d frame", size.width, size.height);
+        return frame;
+    }
+
+    // Energy and sharpness straight from the camera's Y plane, before anything is copied.
+    cv::Mat luma(size, CV_8UC1, const_cast<uint8_t*>(planes.y), planes.yRowStride);
+    cv::Mat energy;
+    cv::resize(luma, energy,
+               cv::Size((size.width + kEnergyFactor - 1) / kEnergyFactor,
+                        (size.height + kEnergyFactor - 1) / kEnergyFactor),
+               0.0, 0.0, cv::INTER_AREA);
+    rotate(energy, frame.energy, rotation);
+    frame.sharpness = edgeDensity(yangEdges(frame.energy));
+
+    const cv::Size chroma(size.width / 2, size.height / 2);
+    frame.i420.create(size.height * 3 / 2, size.width, CV_8UC1);
+    EE_TRACE_COUNT(trace::Counter::MatsAllocated, 1);
+    luma.copyTo(frame.i420.rowRange(0, size.height));
+    uint8_t* u = frame.i420.ptr<uint8_t>(size.height);
+    uint8_t* v = u + chroma.area();
+    packChroma(planes.u, planes.uvRowStride, planes.uvPixelStride, chroma, u);
+    packChroma(planes.v, planes.uvRowStride, planes.uvPixelStride, chroma, v);
+    return frame;
+}
+
+cv::Mat i420ToBgr(const cv::Mat& i420, Rotation rotation) {
+    EE_TRACE_SCOPE("i420ToBgr");
+    cv::Mat bgr, rotated;
+    cv::cvtColor(i420, bgr, cv::COLOR_YUV2BGR_I420);
+    rotate(bgr, rotated, rotation);
+    return rotated;
+}
+
+}  // namespace eagleeye
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ColorRotate.h"
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+
+namespace eagleeye {
+
+/*
+ * The three planes of an android.media.Image in YUV_420_888, as the camera hands them out. Chroma planes may be
+ * planar (pixelStride 1) or interleaved (pixelStride 2, NV12/NV21 memory); rows may be padded.
+ */
+struct YuvPlanes {
+    const uint8_t* y = nullptr;
+    const uint8_t* u = nullptr;
+    const uint8_t* v = nullptr;
+    int yRowStride = 0;
+    int uvRowStride = 0;
+    int uvPixelStride = 1;
+    cv::Size size;
+};
+
+/*
+ * What the burst screening needs from a frame, computed on arrival. i420 holds the planes packed at
+ * 1.5 bytes per pixel (size.height * 3 / 2 rows) until the frame is kept or dropped. energy is the 1/8 scale
+ * luminance the energy reader would produce, rotated like the saved frames; sharpness is jpegSharpness on it.
+ */
+struct IngestedFrame {
+    cv::Mat i420;
+    cv::Mat energy;
+    double sharpness = -1.0;
+};
+
+/*
+ * Copies the planes out of the camera buffers and scores the frame from its Y plane. Returns a frame without
+ * i420 if the planes are unusable (odd size, missing plane).
+ */
+IngestedFrame ingestYuv(const YuvPlanes& planes, Rotation rotation);
+
+/*
+ * Converts a packed I420 frame to BGR with the given rotation.
+ */
+cv::Mat i420ToBgr(const cv::Mat& i420, Rotation rotation);
+
+}  // namespace eagleeye
@@ -0,0 +1,39 @@
+#include "BitmapBridge.h"
+
+#include "core/Log.h"
+
+namespace eagleeye {
+namespace jni {
+
+LockedBitmap::LockedBitmap(JNIEnv* env, jobject bitmap) : env_(env), bitmap_(bitmap) {
+    if (AndroidBitmap_getInfo(env, bitmap, &info_) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        EE_LOGE("AndroidBitmap_getInfo failed");
+        return;
+    }
+    if (info_.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        EE_LOGW("Unsupported bitmap format %d, expected RGBA_8888", info_.format);
+        return;
+    }
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        EE_LOGE("AndroidBitmap_lockPixels failed");
+        return;
+    }
+    pixels_ = pixels;
+}
+
+LockedBitmap::~LockedBitmap() {
+    if (pixels_ != nullptr) {
+        AndroidBitmap_unlockPixels(env_, bitmap_);
+    }
+}
+
+cv::Mat LockedBitmap::mat() const {
+    if (pixels_ == nullptr) {
+        return cv::Mat();
+    }
+    return cv::Mat(static_cast<int>(info_.height), static_cast<int>(info_.width), CV_8UC4, pixels_, info_.stride);
+}
+
+}  // namespace jni
+}  // namespace eagleeye
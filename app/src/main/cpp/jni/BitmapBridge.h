@@ -0,0 +1,37 @@
+#pragma once
+
+#include <jni.h>
+#include <android/bitmap.h>
+#include <opencv2/core.hpp>
+
+namespace eagleeye {
+namespace jni {
+
+/*
+ * Locks an android.graphics.Bitmap for the lifetime of the object and exposes its pixels as a cv::Mat header,
+ * without copying. Only ARGB_8888 bitmaps (RGBA byte order in memory) are supported.
+ */
+class LockedBitmap {
+public:
+    LockedBitmap(JNIEnv* env, jobject bitmap);
+    ~LockedBitmap();
+
+    LockedBitmap(const LockedBitmap&) = delete;
+    LockedBitmap& operator=(const LockedBitmap&) = delete;
+
+    bool isValid() const { return pixels_ != nullptr; }
+
+    /*
+     * CV_8UC4 header over the bitmap pixels. Only valid while this object is alive.
+     */
+    cv::Mat mat() const;
+
+private:
+    JNIEnv* env_;
+    jobject bitmap_;
+    AndroidBitmapInfo info_ {};
+    void* pixels_ = nullptr;
+};
+
+}  // namespace jni
+}  // namespace eagleeye
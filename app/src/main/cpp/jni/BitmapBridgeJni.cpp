@@ -0,0 +1,58 @@
+// JNI adapters for the zero-copy Bitmap <-> Mat conversions used by ImageOperator.
+// A failure returns false, and ImageOperator falls back to OpenCV's Utils; the bitmap is unlocked either way.
+
+#include <jni.h>
+
+#include "core/ColorRotate.h"
+#include "core/Log.h"
+#include "jni/BitmapBridge.h"
+
+#include <exception>
+
+using namespace eagleeye;
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_ImageOperator_bitmapToMatNative(JNIEnv *env,
+                                                                                 jobject thiz,
+                                                                                 jobject bitmap,
+                                                                                 jlong dstMatAddr,
+                                                                                 jint rotation) {
+    try {
+        jni::LockedBitmap lockedBitmap(env, bitmap);
+        if (!lockedBitmap.isValid()) {
+            return JNI_FALSE;
+        }
+        cv::Mat& dst = *reinterpret_cast<cv::Mat*>(dstMatAddr);
+        rgbaToBgr(lockedBitmap.mat(), dst, static_cast<Rotation>(rotation));
+        return JNI_TRUE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("bitmapToMat failed: %s", e.what());
+    } catch (const std::exception& e) {
+        EE_LOGE("bitmapToMat failed: %s", e.what());
+    }
+    return JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_ImageOperator_matToBitmapNative(JNIEnv *env,
+                                                                                 jobject thiz,
+                                                                                 jlong srcMatAddr,
+                                                                                 jobject bitmap,
+                                                                                 jint rotation) {
+    try {
+        jni::LockedBitmap lockedBitmap(env, bitmap);
+        if (!lockedBitmap.isValid()) {
+            return JNI_FALSE;
+        }
+        const cv::Mat& src = *reinterpret_cast<cv::Mat*>(srcMatAddr);
+        cv::Mat pixels = lockedBitmap.mat();
+        return bgrToRgba(src, pixels, static_cast<Rotation>(rotation)) ? JNI_TRUE : JNI_FALSE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("matToBitmap failed: %s", e.what());
+    } catch (const std::exception& e) {
+        EE_LOGE("matToBitmap failed: %s", e.what());
+    }
+    return JNI_FALSE;
+}
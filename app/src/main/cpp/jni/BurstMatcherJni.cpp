@@ -0,0 +1,110 @@
+// JNI adapter for FeatureMatchingOperator's native burst matching.
+
+#include <jni.h>
+
+#include "core/BurstMatcher.h"
+#include "jni/JniHelpers.h"
+
+using namespace eagleeye;
+
+namespace {
+
+struct MatchOutputs {
+    std::vector<cv::Mat*> keypoints;
+    std::vector<cv::Mat*> matches;
+    std::vector<cv::Mat*> homographies;
+};
+
+bool readOutputs(JNIEnv* env, size_t frameCount, jlongArray keypointsAddrs, jlongArray matchesAddrs,
+                 jlongArray homographyAddrs, MatchOutputs& outputs) {
+    outputs.keypoints = jni::toMatPointers(env, keypointsAddrs);
+    outputs.matches = jni::toMatPointers(env, matchesAddrs);
+    outputs.homographies = jni::toMatPointers(env, homographyAddrs);
+    if (outputs.keypoints.size() != frameCount || outputs.matches.size() != frameCount ||
+        outputs.homographies.size() != frameCount) {
+        EE_LOGE("matchBurstNative: %zu frames but %zu/%zu/%zu output mats", frameCount, outputs.keypoints.size(),
+                outputs.matches.size(), outputs.homographies.size());
+        return false;
+    }
+    return true;
+}
+
+BurstMatcher createMatcher(jfloat maxDistance, jboolean pyramid) {
+    BurstMatchOptions options;
+    options.maxDistance = maxDistance;
+    options.pyramid = pyramid == JNI_TRUE;
+    return BurstMatcher(options);
+}
+
+/*
+ * Writes the results into the Java MatOfKeyPoint / MatOfDMatch / Mat objects, one per frame.
+ */
+void writeResults(const std::vector<FrameMatches>& results, const MatchOutputs& outputs) {
+    for (size_t i = 0; i < results.size(); i++) {
+        jni::toMatOfKeyPoint(results[i].keypoints, *outputs.keypoints[i]);
+        jni::toMatOfDMatch(results[i].matches, *outputs.matches[i]);
+        results[i].homography.copyTo(*outputs.homographies[i]);
+    }
+}
+
+}  // namespace
+
+/*
+ * Matches every frame file against the reference mat in one call. The results are written into the Java
+ * MatOfKeyPoint / MatOfDMatch / Mat objects whose native addresses are passed in, one per frame.
+ */
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_multiple_alignment_FeatureMatchingOperator_matchBurstNative(
+        JNIEnv *env, jobject thiz, jlong referenceMatAddr, jobjectArray framePaths, jfloat maxDistance, jboolean pyramid,
+        jlong referenceKeypointsAddr, jlongArray keypointsAddrs, jlongArray matchesAddrs,
+        jlongArray homographyAddrs) {
+    std::vector<std::string> paths = jni::toStringVector(env, framePaths);
+    MatchOutputs outputs;
+    if (!readOutputs(env, paths.size(), keypointsAddrs, matchesAddrs, homographyAddrs, outputs)) {
+        return JNI_FALSE;
+    }
+
+    try {
+        BurstMatcher matcher = createMatcher(maxDistance, pyramid);
+        matcher.setReference(*reinterpret_cast<cv::Mat*>(referenceMatAddr));
+        jni::toMatOfKeyPoint(matcher.referenceKeypoints(), *reinterpret_cast<cv::Mat*>(referenceKeypointsAddr));
+        writeResults(matcher.matchFiles(paths), outputs);
+        return JNI_TRUE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("matchBurstNative failed: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+/*
+ * matchBurstNative for frames that are already in memory, passed as native Mat addresses.
+ */
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_multiple_alignment_FeatureMatchingOperator_matchBurstMatsNative(
+        JNIEnv *env, jobject thiz, jlong referenceMatAddr, jlongArray frameAddrs, jfloat maxDistance, jboolean pyramid,
+        jlong referenceKeypointsAddr, jlongArray keypointsAddrs, jlongArray matchesAddrs,
+        jlongArray homographyAddrs) {
+    std::vector<cv::Mat*> framePointers = jni::toMatPointers(env, frameAddrs);
+    MatchOutputs outputs;
+    if (!readOutputs(env, framePointers.size(), keypointsAddrs, matchesAddrs, homographyAddrs, outputs)) {
+        return JNI_FALSE;
+    }
+
+    try {
+        std::vector<cv::Mat> frames;
+        frames.reserve(framePointers.size());
+        for (cv::Mat* frame : framePointers) {
+            frames.push_back(*frame);
+        }
+        BurstMatcher matcher = createMatcher(maxDistance, pyramid);
+        matcher.setReference(*reinterpret_cast<cv::Mat*>(referenceMatAddr));
+        jni::toMatOfKeyPoint(matcher.referenceKeypoints(), *reinterpret_cast<cv::Mat*>(referenceKeypointsAddr));
+        writeResults(matcher.matchFrames(frames), outputs);
+        return JNI_TRUE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("matchBurstMatsNative failed: %s", e.what());
+        return JNI_FALSE;
+    }
+}
@@ -0,0 +1,38 @@
+// JNI adapter for the native energy reader.
+
+#include <jni.h>
+
+#include "core/EnergyReader.h"
+#include "jni/JniHelpers.h"
+
+using namespace eagleeye;
+
+/*
+ * Reads the 1/8 scale luminance of every path into the Java Mat whose native address is at the same index.
+ * Returns false if any frame could not be read; those Mats are left empty.
+ */
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_assessment_EnergyReader_readEnergyNative(JNIEnv *env, jobject thiz,
+                                                                    jobjectArray paths,
+                                                                    jlongArray outputAddrs) {
+    std::vector<std::string> pathList = jni::toStringVector(env, paths);
+    std::vector<cv::Mat*> outputs = jni::toMatPointers(env, outputAddrs);
+    if (outputs.size() != pathList.size()) {
+        EE_LOGE("readEnergyNative: %zu paths but %zu output mats", pathList.size(), outputs.size());
+        return JNI_FALSE;
+    }
+
+    try {
+        std::vector<cv::Mat> energy = readEnergy(pathList);
+        bool complete = true;
+        for (size_t i = 0; i < energy.size(); i++) {
+            *outputs[i] = energy[i];
+            complete = complete && !energy[i].empty();
+        }
+        return complete ? JNI_TRUE : JNI_FALSE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("readEnergyNative failed: %s", e.what());
+        return JNI_FALSE;
+    }
+}
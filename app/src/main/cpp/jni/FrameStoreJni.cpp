@@ -0,0 +1,109 @@
+// JNI adapters for com.wangGang.eagleEye.io.FrameStore.
+// Everything but nativeStats may decode, spill or copy frames, so failures come back as false / an empty Mat.
+
+#include <jni.h>
+
+#include "core/FrameStore.h"
+#include "jni/JniHelpers.h"
+
+#include <exception>
+
+using namespace eagleeye;
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_io_FrameStore_nativeConfigure(JNIEnv *env, jobject thiz, jlong budgetBytes,
+                                                         jstring spillDirectory) {
+    try {
+        FrameStore::instance().configure(budgetBytes, jni::toString(env, spillDirectory));
+        return JNI_TRUE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("FrameStore configure failed: %s", e.what());
+    } catch (const std::exception& e) {
+        EE_LOGE("FrameStore configure failed: %s", e.what());
+    }
+    return JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_io_FrameStore_nativeRegister(JNIEnv *env, jobject thiz, jint index, jstring path) {
+    try {
+        FrameStore::instance().registerFrame(index, jni::toString(env, path));
+        return JNI_TRUE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("FrameStore register of frame %d failed: %s", index, e.what());
+    } catch (const std::exception& e) {
+        EE_LOGE("FrameStore register of frame %d failed: %s", index, e.what());
+    }
+    return JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_io_FrameStore_nativePut(JNIEnv *env, jobject thiz, jint index, jlong matAddr) {
+    try {
+        FrameStore::instance().putFrame(index, *reinterpret_cast<cv::Mat*>(matAddr));
+        return JNI_TRUE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("FrameStore put of frame %d failed: %s", index, e.what());
+    } catch (const std::exception& e) {
+        EE_LOGE("FrameStore put of frame %d failed: %s", index, e.what());
+    }
+    return JNI_FALSE;
+}
+
+/*
+ * Returns a new org.opencv.core.Mat header sharing the stored buffer; empty if the frame cannot be read.
+ */
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_wangGang_eagleEye_io_FrameStore_nativeAcquire(JNIEnv *env, jobject thiz, jint index) {
+    try {
+        return jni::toJavaMat(env, FrameStore::instance().acquire(index));
+    } catch (const cv::Exception& e) {
+        EE_LOGE("FrameStore acquire failed: %s", e.what());
+    } catch (const std::exception& e) {
+        EE_LOGE("FrameStore acquire failed: %s", e.what());
+    }
+    return jni::toJavaMat(env, cv::Mat());
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_io_FrameStore_nativeRelease(JNIEnv *env, jobject thiz, jint index) {
+    try {
+        FrameStore::instance().release(index);
+        return JNI_TRUE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("FrameStore release of frame %d failed: %s", index, e.what());
+    } catch (const std::exception& e) {
+        EE_LOGE("FrameStore release of frame %d failed: %s", index, e.what());
+    }
+    return JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_io_FrameStore_nativeClear(JNIEnv *env, jobject thiz) {
+    try {
+        FrameStore::instance().clear();
+        return JNI_TRUE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("FrameStore clear failed: %s", e.what());
+    } catch (const std::exception& e) {
+        EE_LOGE("FrameStore clear failed: %s", e.what());
+    }
+    return JNI_FALSE;
+}
+
+// Returned as {decodes, hits, spills, reloads, bytesResident}, see FrameStore.Stats.
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_wangGang_eagleEye_io_FrameStore_nativeStats(JNIEnv *env, jobject thiz) {
+    FrameStoreStats stats = FrameStore::instance().stats();
+    jlong values[] = {stats.decodes, stats.hits, stats.spills, stats.reloads, stats.bytesResident};
+    jlongArray result = env->NewLongArray(5);
+    env->SetLongArrayRegion(result, 0, 5, values);
+    return result;
+}
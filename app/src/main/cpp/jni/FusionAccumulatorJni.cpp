@@ -0,0 +1,85 @@
+// JNI adapters for com.wangGang.eagleEye.processing.multiple.fusion.FusionAccumulator.
+// The Kotlin object owns a FusionAccumulator* stored as a Long handle.
+
+#include <jni.h>
+
+#include "core/FusionAccumulator.h"
+#include "jni/JniHelpers.h"
+
+#include <exception>
+
+using namespace eagleeye;
+
+namespace {
+
+FusionAccumulator* fromHandle(jlong handle) {
+    return reinterpret_cast<FusionAccumulator*>(handle);
+}
+
+}  // namespace
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_wangGang_eagleEye_processing_multiple_fusion_FusionAccumulator_nativeCreate(JNIEnv *env, jobject thiz) {
+    return reinterpret_cast<jlong>(new FusionAccumulator());
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_multiple_fusion_FusionAccumulator_nativeBegin(JNIEnv *env,
+                                                                                    jobject thiz,
+                                                                                    jlong handle,
+                                                                                    jint width,
+                                                                                    jint height,
+                                                                                    jfloat scale,
+                                                                                    jint channels) {
+    try {
+        fromHandle(handle)->begin(cv::Size(width, height), scale, channels);
+        return JNI_TRUE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("FusionAccumulator begin failed: %s", e.what());
+    } catch (const std::exception& e) {
+        EE_LOGE("FusionAccumulator begin of %dx%d failed: %s", width, height, e.what());
+    }
+    return JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_multiple_fusion_FusionAccumulator_nativeAdd(JNIEnv *env,
+                                                                                  jobject thiz,
+                                                                                  jlong handle,
+                                                                                  jlong frameMatAddr) {
+    try {
+        const cv::Mat& frame = *reinterpret_cast<cv::Mat*>(frameMatAddr);
+        return fromHandle(handle)->add(frame) ? JNI_TRUE : JNI_FALSE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("FusionAccumulator add failed: %s", e.what());
+    } catch (const std::exception& e) {
+        EE_LOGE("FusionAccumulator add failed: %s", e.what());
+    }
+    return JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_wangGang_eagleEye_processing_multiple_fusion_FusionAccumulator_nativeFinish(JNIEnv *env,
+                                                                                     jobject thiz,
+                                                                                     jlong handle) {
+    try {
+        return jni::toJavaMat(env, fromHandle(handle)->finish());
+    } catch (const cv::Exception& e) {
+        EE_LOGE("FusionAccumulator finish failed: %s", e.what());
+    } catch (const std::exception& e) {
+        EE_LOGE("FusionAccumulator finish failed: %s", e.what());
+    }
+    return jni::toJavaMat(env, cv::Mat());
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_wangGang_eagleEye_processing_multiple_fusion_FusionAccumulator_nativeRelease(JNIEnv *env,
+                                                                                      jobject thiz,
+                                                                                      jlong handle) {
+    delete fromHandle(handle);
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <jni.h>
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "core/Log.h"
+
+namespace eagleeye {
+namespace jni {
+
+/*
+ * Copies a Java String[] into a vector of std::string.
+ */
+inline std::vector<std::string> toStringVector(JNIEnv* env, jobjectArray array) {
+    std::vector<std::string> result;
+    if (array == nullptr) {
+        return result;
+    }
+    jsize length = env->GetArrayLength(array);
+    result.reserve(length);
+    for (jsize i = 0; i < length; i++) {
+        jstring element = (jstring) env->GetObjectArrayElement(array, i);
+        const char* chars = env->GetStringUTFChars(element, nullptr);
+        result.emplace_back(chars);
+        env->ReleaseStringUTFChars(element, chars);
+        env->DeleteLocalRef(element);
+    }
+    return result;
+}
+
+inline std::string toString(JNIEnv* env, jstring string) {
+    if (string == nullptr) {
+        return std::string();
+    }
+    const char* chars = env->GetStringUTFChars(string, nullptr);
+    std::string result(chars);
+    env->ReleaseStringUTFChars(string, chars);
+    return result;
+}
+
+/*
+ * Wraps a heap-allocated cv::Mat into an org.opencv.core.Mat. The Java object takes ownership of the pointer.
+ */
+inline jobject toJavaMat(JNIEnv* env, cv::Mat* mat) {
+    jclass matClass = env->FindClass("org/opencv/core/Mat");
+    if (matClass == nullptr) {
+        EE_LOGE("Cannot find org/opencv/core/Mat class");
+        delete mat;
+        return nullptr;
+    }
+    // The constructor signature is (J)V meaning it accepts a native pointer.
+    jmethodID matConstructor = env->GetMethodID(matClass, "<init>", "(J)V");
+    if (matConstructor == nullptr) {
+        EE_LOGE("Cannot find Mat(long addr) constructor");
+        delete mat;
+        return nullptr;
+    }
+    return env->NewObject(matClass, matConstructor, reinterpret_cast<jlong>(mat));
+}
+
+inline jobject toJavaMat(JNIEnv* env, cv::Mat mat) {
+    return toJavaMat(env, new cv::Mat(std::move(mat)));
+}
+
+/*
+ * Fills the Mat behind an org.opencv.core.MatOfKeyPoint, in the layout of OpenCV's Java converters
+ * (N x 1 CV_32FC(7): x, y, size, angle, response, octave, class_id).
+ */
+inline void toMatOfKeyPoint(const std::vector<cv::KeyPoint>& keypoints, cv::Mat& mat) {
+    mat.create(static_cast<int>(keypoints.size()), 1, CV_32FC(7));
+    for (size_t i = 0; i < keypoints.size(); i++) {
+        const cv::KeyPoint& kp = keypoints[i];
+        mat.at<cv::Vec<float, 7>>(static_cast<int>(i), 0) = cv::Vec<float, 7>(
+                kp.pt.x, kp.pt.y, kp.size, kp.angle, kp.response, static_cast<float>(kp.octave),
+                static_cast<float>(kp.class_id));
+    }
+}
+
+/*
+ * Fills the Mat behind an org.opencv.core.MatOfDMatch (N x 1 CV_32FC4: queryIdx, trainIdx, imgIdx, distance).
+ */
+inline void toMatOfDMatch(const std::vector<cv::DMatch>& matches, cv::Mat& mat) {
+    mat.create(static_cast<int>(matches.size()), 1, CV_32FC4);
+    for (size_t i = 0; i < matches.size(); i++) {
+        const cv::DMatch& match = matches[i];
+        mat.at<cv::Vec4f>(static_cast<int>(i), 0) = cv::Vec4f(
+                static_cast<float>(match.queryIdx), static_cast<float>(match.trainIdx),
+                static_cast<float>(match.imgIdx), match.distance);
+    }
+}
+
+/*
+ * Reads a Java long[] of Mat.nativeObj addresses.
+ */
+inline std::vector<cv::Mat*> toMatPointers(JNIEnv* env, jlongArray addresses) {
+    std::vector<cv::Mat*> result;
+    if (addresses == nullptr) {
+        return result;
+    }
+    jsize length = env->GetArrayLength(addresses);
+    std::vector<jlong> values(length);
+    env->GetLongArrayRegion(addresses, 0, length, values.data());
+    result.reserve(length);
+    for (jlong value : values) {
+        result.push_back(reinterpret_cast<cv::Mat*>(value));
+    }
+    return result;
+}
+
+/*
+ * The floats of a direct FloatBuffer from offset on, or nullptr (logged with caller as prefix) if the buffer is not
+ * direct or has fewer than count floats there.
+ */
+inline float* directFloats(JNIEnv* env, jobject buffer, jint offset, int64_t count, const char* caller) {
+    auto* floats = static_cast<float*>(env->GetDirectBufferAddress(buffer));
+    if (floats == nullptr) {
+        EE_LOGE("%s: buffer is not a direct FloatBuffer", caller);
+        return nullptr;
+    }
+    if (offset < 0 || offset + count > env->GetDirectBufferCapacity(buffer)) {
+        EE_LOGE("%s: %lld floats at offset %d do not fit a buffer of %lld", caller, static_cast<long long>(count),
+                offset, static_cast<long long>(env->GetDirectBufferCapacity(buffer)));
+        return nullptr;
+    }
+    return floats + offset;
+}
+
+}  // namespace jni
+}  // namespace eagleeye
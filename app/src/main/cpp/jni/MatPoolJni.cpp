@@ -0,0 +1,43 @@
+// JNI adapters for com.wangGang.eagleEye.processing.imagetools.MatPool.
+
+#include <jni.h>
+
+#include "core/MatPool.h"
+
+using namespace eagleeye;
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_MatPool_nativeBeginSession(JNIEnv *env, jobject thiz) {
+    MatPool::instance().beginSession();
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_MatPool_nativeEndSession(JNIEnv *env, jobject thiz) {
+    MatPool::instance().endSession();
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_MatPool_nativeSetCacheLimit(JNIEnv *env, jobject thiz,
+                                                                             jlong bytes) {
+    MatPool::instance().setCacheLimit(bytes);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_MatPool_nativeTrim(JNIEnv *env, jobject thiz) {
+    MatPool::instance().trim();
+}
+
+// Returned as {hits, misses, bytesInUse, highWaterBytes, bytesCached}, see MatPool.Stats.
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_MatPool_nativeStats(JNIEnv *env, jobject thiz) {
+    MatPoolStats stats = MatPool::instance().stats();
+    jlong values[] = {stats.hits, stats.misses, stats.bytesInUse, stats.highWaterBytes, stats.bytesCached};
+    jlongArray result = env->NewLongArray(5);
+    env->SetLongArrayRegion(result, 0, 5, values);
+    return result;
+}
@@ -0,0 +1,27 @@
+// JNI adapter for OnlineSharpnessScorer.
+
+#include <jni.h>
+
+#include "core/Sharpness.h"
+#include "jni/JniHelpers.h"
+
+using namespace eagleeye;
+
+extern "C"
+JNIEXPORT jdouble JNICALL
+Java_com_wangGang_eagleEye_model_multiple_OnlineSharpnessScorer_scoreJpegNative(JNIEnv *env, jobject thiz,
+                                                                                jbyteArray jpegBytes) {
+    jsize length = env->GetArrayLength(jpegBytes);
+    jbyte* bytes = env->GetByteArrayElements(jpegBytes, nullptr);
+    if (bytes == nullptr) {
+        return -1.0;
+    }
+    double score = -1.0;
+    try {
+        score = jpegSharpness(cv::Mat(1, length, CV_8UC1, bytes));
+    } catch (const cv::Exception& e) {
+        EE_LOGE("scoreJpegNative failed: %s", e.what());
+    }
+    env->ReleaseByteArrayElements(jpegBytes, bytes, JNI_ABORT);
+    return score;
+}
@@ -0,0 +1,102 @@
+// JNI adapters for the shift-and-add super-resolution engine and ImageOperator's zero-fill helpers.
+
+#include <jni.h>
+
+#include "core/Log.h"
+#include "core/ShiftAddFusion.h"
+#include "jni/JniHelpers.h"
+
+using namespace eagleeye;
+
+/*
+ * Reconstructs the HR image from frames aligned by homographies (frame -> reference, empty Mat for none).
+ * Returns an empty Mat on failure.
+ */
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_wangGang_eagleEye_processing_multiple_fusion_ShiftAddOperator_shiftAddNative(
+        JNIEnv *env, jobject thiz, jlongArray frameAddrs, jlongArray homographyAddrs, jint scale) {
+    std::vector<cv::Mat*> frames = jni::toMatPointers(env, frameAddrs);
+    std::vector<cv::Mat*> homographies = jni::toMatPointers(env, homographyAddrs);
+    if (homographies.size() != frames.size()) {
+        EE_LOGE("shiftAddNative: %zu frames but %zu homographies", frames.size(), homographies.size());
+        return jni::toJavaMat(env, cv::Mat());
+    }
+
+    try {
+        ShiftAddOptions options;
+        options.scale = scale;
+        ShiftAddFusion fusion(options);
+        for (size_t i = 0; i < frames.size(); i++) {
+            if (!fusion.addFrame(*frames[i], *homographies[i])) {
+                EE_LOGW("shiftAddNative: skipping frame %zu", i);
+            }
+        }
+        return jni::toJavaMat(env, fusion.reconstruct());
+    } catch (const cv::Exception& e) {
+        EE_LOGE("shiftAddNative failed: %s", e.what());
+        return jni::toJavaMat(env, cv::Mat());
+    }
+}
+
+/*
+ * Reconstructs the HR image from frames with per-pixel displacement maps (LR pixels, single channel).
+ */
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_wangGang_eagleEye_processing_multiple_fusion_ShiftAddOperator_shiftAddDisplacedNative(
+        JNIEnv *env, jobject thiz, jlongArray frameAddrs, jlongArray xDisplacementAddrs,
+        jlongArray yDisplacementAddrs, jint scale) {
+    std::vector<cv::Mat*> frames = jni::toMatPointers(env, frameAddrs);
+    std::vector<cv::Mat*> xDisplacements = jni::toMatPointers(env, xDisplacementAddrs);
+    std::vector<cv::Mat*> yDisplacements = jni::toMatPointers(env, yDisplacementAddrs);
+    if (xDisplacements.size() != frames.size() || yDisplacements.size() != frames.size()) {
+        EE_LOGE("shiftAddDisplacedNative: %zu frames but %zu/%zu displacement maps", frames.size(),
+                xDisplacements.size(), yDisplacements.size());
+        return jni::toJavaMat(env, cv::Mat());
+    }
+
+    try {
+        ShiftAddOptions options;
+        options.scale = scale;
+        ShiftAddFusion fusion(options);
+        for (size_t i = 0; i < frames.size(); i++) {
+            if (!fusion.addFrame(*frames[i], *xDisplacements[i], *yDisplacements[i])) {
+                EE_LOGW("shiftAddDisplacedNative: skipping frame %zu", i);
+            }
+        }
+        return jni::toJavaMat(env, fusion.reconstruct());
+    } catch (const cv::Exception& e) {
+        EE_LOGE("shiftAddDisplacedNative failed: %s", e.what());
+        return jni::toJavaMat(env, cv::Mat());
+    }
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_ImageOperator_zeroFillNative(
+        JNIEnv *env, jobject thiz, jlong lrMatAddr, jlong hrMatAddr, jint scale, jint xOffset, jint yOffset) {
+    try {
+        zeroFill(*reinterpret_cast<cv::Mat*>(lrMatAddr), *reinterpret_cast<cv::Mat*>(hrMatAddr), scale,
+                 cv::Point(xOffset, yOffset));
+        return JNI_TRUE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("zeroFillNative failed: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_ImageOperator_zeroFillDisplacedNative(
+        JNIEnv *env, jobject thiz, jlong lrMatAddr, jlong hrMatAddr, jint scale, jlong xDisplacementAddr,
+        jlong yDisplacementAddr) {
+    try {
+        zeroFill(*reinterpret_cast<cv::Mat*>(lrMatAddr), *reinterpret_cast<cv::Mat*>(hrMatAddr), scale,
+                 *reinterpret_cast<cv::Mat*>(xDisplacementAddr), *reinterpret_cast<cv::Mat*>(yDisplacementAddr));
+        return JNI_TRUE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("zeroFillDisplacedNative failed: %s", e.what());
+        return JNI_FALSE;
+    }
+}
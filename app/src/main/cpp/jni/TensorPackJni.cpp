@@ -0,0 +1,82 @@
+// JNI adapter for TensorPack: packing between Mats and the direct FloatBuffers ONNX tensors are created from.
+
+#include <jni.h>
+
+#include "core/TensorPack.h"
+#include "jni/JniHelpers.h"
+
+#include <algorithm>
+
+using namespace eagleeye;
+
+namespace {
+
+// One value applies to every channel.
+cv::Scalar toScalar(JNIEnv* env, jdoubleArray values, double fallback) {
+    cv::Scalar scalar = cv::Scalar::all(fallback);
+    jsize length = values == nullptr ? 0 : std::min(env->GetArrayLength(values), 4);
+    if (length == 1) {
+        double value;
+        env->GetDoubleArrayRegion(values, 0, 1, &value);
+        scalar = cv::Scalar::all(value);
+    } else if (length > 1) {
+        env->GetDoubleArrayRegion(values, 0, length, scalar.val);
+    }
+    return scalar;
+}
+
+}  // namespace
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_TensorPack_packNative(JNIEnv *env, jobject thiz, jlong srcAddr,
+                                                                       jint x, jint y, jint width, jint height,
+                                                                       jobject buffer, jint offset, jdouble scale,
+                                                                       jdoubleArray mean, jdoubleArray std,
+                                                                       jboolean swapRB, jint borderType) {
+    try {
+        const cv::Mat& src = *reinterpret_cast<cv::Mat*>(srcAddr);
+        float* planes = jni::directFloats(env, buffer, offset, static_cast<int64_t>(width) * height * src.channels(),
+                                          "TensorPack");
+        if (planes == nullptr) {
+            return JNI_FALSE;
+        }
+        PackParams params;
+        params.scale = scale;
+        params.mean = toScalar(env, mean, 0.0);
+        params.std = toScalar(env, std, 1.0);
+        params.swapRB = swapRB == JNI_TRUE;
+        params.borderType = borderType;
+        return packToNchw(src, cv::Rect(x, y, width, height), planes, params) ? JNI_TRUE : JNI_FALSE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("packNative failed: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_TensorPack_unpackNative(JNIEnv *env, jobject thiz, jobject buffer,
+                                                                         jint offset, jint planeWidth,
+                                                                         jint planeHeight, jint x, jint y,
+                                                                         jlong dstAddr, jdouble scale, jdouble bias,
+                                                                         jboolean clamp, jboolean swapRB) {
+    try {
+        cv::Mat& dst = *reinterpret_cast<cv::Mat*>(dstAddr);
+        const float* planes = jni::directFloats(
+                env, buffer, offset, static_cast<int64_t>(planeWidth) * planeHeight * dst.channels(), "TensorPack");
+        if (planes == nullptr) {
+            return JNI_FALSE;
+        }
+        UnpackParams params;
+        params.scale = scale;
+        params.offset = bias;
+        params.clamp = clamp == JNI_TRUE;
+        params.swapRB = swapRB == JNI_TRUE;
+        return unpackFromNchw(planes, cv::Size(planeWidth, planeHeight), cv::Rect(x, y, dst.cols, dst.rows), dst,
+                              params) ? JNI_TRUE : JNI_FALSE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("unpackNative failed: %s", e.what());
+        return JNI_FALSE;
+    }
+}
@@ -0,0 +1,89 @@
+// JNI adapters for com.wangGang.eagleEye.processing.imagetools.TileBlender.
+// The Kotlin object owns a TileBlender* stored as a Long handle.
+
+#include <jni.h>
+
+#include "core/TileBlend.h"
+#include "jni/JniHelpers.h"
+
+#include <new>
+
+using namespace eagleeye;
+
+namespace {
+
+TileBlender* fromHandle(jlong handle) {
+    return reinterpret_cast<TileBlender*>(handle);
+}
+
+}  // namespace
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_TileBlender_nativeCreate(JNIEnv *env, jobject thiz) {
+    try {
+        return reinterpret_cast<jlong>(new TileBlender());
+    } catch (const std::bad_alloc&) {
+        EE_LOGE("TileBlender: out of memory");
+        return 0;
+    }
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_TileBlender_nativeBegin(JNIEnv *env, jobject thiz, jlong handle,
+                                                                         jlong dstAddr, jint patchSize, jint halo,
+                                                                         jdouble scale, jdouble bias, jboolean clamp,
+                                                                         jboolean swapRB) {
+    try {
+        UnpackParams params;
+        params.scale = scale;
+        params.offset = bias;
+        params.clamp = clamp == JNI_TRUE;
+        params.swapRB = swapRB == JNI_TRUE;
+        const cv::Mat& dst = *reinterpret_cast<cv::Mat*>(dstAddr);
+        return fromHandle(handle)->begin(dst, patchSize, halo, params) ? JNI_TRUE : JNI_FALSE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("TileBlender begin failed: %s", e.what());
+        return JNI_FALSE;
+    } catch (const std::bad_alloc&) {
+        EE_LOGE("TileBlender: out of memory for a %d row accumulator", patchSize);
+        return JNI_FALSE;
+    }
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_TileBlender_nativeAdd(JNIEnv *env, jobject thiz, jlong handle,
+                                                                       jobject buffer, jint offset, jint channels,
+                                                                       jint patchSize, jint x, jint y) {
+    try {
+        const float* planes = jni::directFloats(
+                env, buffer, offset, static_cast<int64_t>(channels) * patchSize * patchSize, "TileBlender");
+        if (planes == nullptr) {
+            return JNI_FALSE;
+        }
+        return fromHandle(handle)->add(planes, cv::Point(x, y)) ? JNI_TRUE : JNI_FALSE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("TileBlender add failed: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_TileBlender_nativeFinish(JNIEnv *env, jobject thiz, jlong handle) {
+    try {
+        return fromHandle(handle)->finish() ? JNI_TRUE : JNI_FALSE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("TileBlender finish failed: %s", e.what());
+        return JNI_FALSE;
+    }
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_wangGang_eagleEye_processing_imagetools_TileBlender_nativeRelease(JNIEnv *env, jobject thiz, jlong handle) {
+    // Only runs destructors, which cannot throw.
+    delete fromHandle(handle);
+}
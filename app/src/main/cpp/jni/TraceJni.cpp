@@ -0,0 +1,34 @@
+// JNI adapters for com.wangGang.eagleEye.utils.NativeTrace.
+
+#include <jni.h>
+
+#include "core/Trace.h"
+#include "jni/JniHelpers.h"
+
+using namespace eagleeye;
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_wangGang_eagleEye_utils_NativeTrace_beginCapture(JNIEnv *env, jobject thiz) {
+    trace::beginCapture();
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_utils_NativeTrace_endCapture(JNIEnv *env, jobject thiz, jstring outputPath) {
+    return trace::endCapture(jni::toString(env, outputPath)) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_wangGang_eagleEye_utils_NativeTrace_beginTask(JNIEnv *env, jobject thiz, jstring name) {
+    if (trace::enabled()) {
+        trace::beginTask(jni::toString(env, name));
+    }
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_wangGang_eagleEye_utils_NativeTrace_endTask(JNIEnv *env, jobject thiz) {
+    trace::endTask();
+}
@@ -0,0 +1,23 @@
+// JNI adapter for UnsharpMaskOperator's native kernel.
+
+#include <jni.h>
+
+#include "core/UnsharpMask.h"
+#include "jni/JniHelpers.h"
+
+using namespace eagleeye;
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_multiple_enhancement_UnsharpMaskOperator_unsharpMaskNative(JNIEnv *env,
+                                                                                                 jobject thiz,
+                                                                                                 jlong srcMatAddr,
+                                                                                                 jlong dstMatAddr) {
+    try {
+        return unsharpMask(*reinterpret_cast<cv::Mat*>(srcMatAddr), *reinterpret_cast<cv::Mat*>(dstMatAddr))
+               ? JNI_TRUE : JNI_FALSE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("unsharpMaskNative failed: %s", e.what());
+        return JNI_FALSE;
+    }
+}
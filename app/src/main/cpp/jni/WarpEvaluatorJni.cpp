@@ -0,0 +1,42 @@
+// JNI adapter for WarpResultEvaluator's native candidate scoring.
+
+#include <jni.h>
+
+#include "core/Log.h"
+#include "core/WarpEvaluator.h"
+#include "jni/JniHelpers.h"
+
+using namespace eagleeye;
+
+/*
+ * Scores the warped and median aligned candidate of every frame against the reference and writes the chosen
+ * candidate per frame into choices (0 = warped, 1 = median aligned) and the scores into the score arrays.
+ * Returns false if the arguments do not line up or OpenCV failed; the arrays are then left untouched.
+ */
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_multiple_alignment_WarpResultEvaluator_evaluateNative(
+        JNIEnv *env, jobject thiz, jlong referenceMatAddr, jobjectArray warpedPaths, jobjectArray medianPaths,
+        jint pyramidLevel, jintArray warpedScores, jintArray medianScores, jintArray choices) {
+    std::vector<std::string> warped = jni::toStringVector(env, warpedPaths);
+    std::vector<std::string> median = jni::toStringVector(env, medianPaths);
+    jsize count = static_cast<jsize>(warped.size());
+    if (median.size() != warped.size() || env->GetArrayLength(warpedScores) != count ||
+        env->GetArrayLength(medianScores) != count || env->GetArrayLength(choices) != count) {
+        EE_LOGE("evaluateNative: %zu warped but %zu median aligned candidates", warped.size(), median.size());
+        return JNI_FALSE;
+    }
+
+    try {
+        WarpEvaluator evaluator(pyramidLevel);
+        evaluator.setReference(*reinterpret_cast<cv::Mat*>(referenceMatAddr));
+        AlignmentChoice result = evaluator.evaluate(warped, median);
+        env->SetIntArrayRegion(warpedScores, 0, count, result.warpedScores.data());
+        env->SetIntArrayRegion(medianScores, 0, count, result.medianScores.data());
+        env->SetIntArrayRegion(choices, 0, count, result.choice.data());
+        return JNI_TRUE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("evaluateNative failed: %s", e.what());
+        return JNI_FALSE;
+    }
+}
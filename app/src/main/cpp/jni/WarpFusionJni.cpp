@@ -0,0 +1,40 @@
+// JNI adapter for WarpFusionOperator's fused warp + mean fusion stage.
+
+#include <jni.h>
+
+#include "core/Log.h"
+#include "core/WarpFusion.h"
+#include "jni/JniHelpers.h"
+
+using namespace eagleeye;
+
+/*
+ * Warps every frame onto the reference with its homography and folds it into the mean. Frames are passed as
+ * native Mat addresses. Returns the fused image, or an empty Mat on failure.
+ */
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_wangGang_eagleEye_processing_multiple_fusion_WarpFusionOperator_warpFuseNative(
+        JNIEnv *env, jobject thiz, jlong referenceMatAddr, jlongArray frameAddrs, jlongArray homographyAddrs) {
+    std::vector<cv::Mat*> frames = jni::toMatPointers(env, frameAddrs);
+    std::vector<cv::Mat*> homographies = jni::toMatPointers(env, homographyAddrs);
+    if (homographies.size() != frames.size()) {
+        EE_LOGE("warpFuseNative: %zu frames but %zu homographies", frames.size(), homographies.size());
+        return jni::toJavaMat(env, cv::Mat());
+    }
+
+    cv::Mat fused;
+    try {
+        WarpFusion fusion;
+        fusion.begin(*reinterpret_cast<cv::Mat*>(referenceMatAddr));
+        for (size_t i = 0; i < frames.size(); i++) {
+            // A frame that does not match the reference is logged and left out of the mean.
+            fusion.addFrame(*frames[i], *homographies[i]);
+        }
+        fused = fusion.finish();
+    } catch (const cv::Exception& e) {
+        EE_LOGE("warpFuseNative failed: %s", e.what());
+        fused.release();
+    }
+    return jni::toJavaMat(env, fused);
+}
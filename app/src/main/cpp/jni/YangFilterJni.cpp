@@ -0,0 +1,43 @@
+// JNI adapter for YangFilter's fused native edge filter.
+
+#include <jni.h>
+
+#include "core/YangFilter.h"
+#include "jni/JniHelpers.h"
+
+using namespace eagleeye;
+
+/*
+ * Runs the fused Yang filter over every input Mat in parallel and writes the 8-bit edges into the output Mat at
+ * the same index. Returns false if any input is not CV_8UC1.
+ */
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_processing_filters_YangFilter_yangFilterNative(JNIEnv *env, jobject thiz,
+                                                                          jlongArray inputAddrs,
+                                                                          jlongArray outputAddrs) {
+    std::vector<cv::Mat*> inputPointers = jni::toMatPointers(env, inputAddrs);
+    std::vector<cv::Mat*> outputs = jni::toMatPointers(env, outputAddrs);
+    if (outputs.size() != inputPointers.size()) {
+        EE_LOGE("yangFilterNative: %zu inputs but %zu output mats", inputPointers.size(), outputs.size());
+        return JNI_FALSE;
+    }
+
+    try {
+        std::vector<cv::Mat> inputs;
+        inputs.reserve(inputPointers.size());
+        for (cv::Mat* input : inputPointers) {
+            inputs.push_back(*input);
+        }
+        std::vector<cv::Mat> edges = yangEdges(inputs);
+        bool complete = true;
+        for (size_t i = 0; i < edges.size(); i++) {
+            *outputs[i] = edges[i];
+            complete = complete && !edges[i].empty();
+        }
+        return complete ? JNI_TRUE : JNI_FALSE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("yangFilterNative failed: %s", e.what());
+        return JNI_FALSE;
+    }
+}
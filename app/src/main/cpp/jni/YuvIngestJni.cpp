@@ -0,0 +1,56 @@
+// JNI adapter for YuvIngest: YUV_420_888 camera frames handed over as direct ByteBuffers.
+
+#include <jni.h>
+
+#include "core/Log.h"
+#include "core/YuvIngest.h"
+#include "jni/JniHelpers.h"
+
+using namespace eagleeye;
+
+/*
+ * Packs the planes into i420Addr, writes the 1/8 scale luminance into energyAddr and returns the sharpness
+ * score, or -1 if the frame could not be ingested. The buffers only need to stay valid for the call.
+ */
+extern "C"
+JNIEXPORT jdouble JNICALL
+Java_com_wangGang_eagleEye_io_YuvIngest_ingestNative(JNIEnv *env, jobject thiz, jobject yBuffer, jobject uBuffer,
+                                                     jobject vBuffer, jint width, jint height, jint yRowStride,
+                                                     jint uvRowStride, jint uvPixelStride, jint rotation,
+                                                     jlong i420Addr, jlong energyAddr) {
+    YuvPlanes planes;
+    planes.y = static_cast<const uint8_t*>(env->GetDirectBufferAddress(yBuffer));
+    planes.u = static_cast<const uint8_t*>(env->GetDirectBufferAddress(uBuffer));
+    planes.v = static_cast<const uint8_t*>(env->GetDirectBufferAddress(vBuffer));
+    planes.yRowStride = yRowStride;
+    planes.uvRowStride = uvRowStride;
+    planes.uvPixelStride = uvPixelStride;
+    planes.size = cv::Size(width, height);
+
+    try {
+        IngestedFrame frame = ingestYuv(planes, static_cast<Rotation>(rotation));
+        if (frame.i420.empty()) {
+            return -1.0;
+        }
+        *reinterpret_cast<cv::Mat*>(i420Addr) = frame.i420;
+        *reinterpret_cast<cv::Mat*>(energyAddr) = frame.energy;
+        return frame.sharpness;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("ingestNative failed: %s", e.what());
+        return -1.0;
+    }
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_wangGang_eagleEye_io_YuvIngest_toBgrNative(JNIEnv *env, jobject thiz, jlong i420Addr, jint rotation,
+                                                    jlong bgrAddr) {
+    try {
+        *reinterpret_cast<cv::Mat*>(bgrAddr) =
+                i420ToBgr(*reinterpret_cast<cv::Mat*>(i420Addr), static_cast<Rotation>(rotation));
+        return JNI_TRUE;
+    } catch (const cv::Exception& e) {
+        EE_LOGE("toBgrNative failed: %s", e.what());
+        return JNI_FALSE;
+    }
+}
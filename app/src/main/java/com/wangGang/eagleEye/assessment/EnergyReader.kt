@@ -0,0 +1,37 @@
+package com.wangGang.eagleEye.assessment
+
+import android.util.Log
+import org.opencv.core.Mat
+import java.util.concurrent.Semaphore
+
+/**
+ * Reads the 1/8 scale luminance of every burst frame in one native call. JPEGs are decoded at 1/8 scale in the
+ * DCT domain straight to gray and all frames are decoded in parallel. Frames the native reader cannot handle
+ * fall back to InputImageEnergyReader.
+ */
+object EnergyReader {
+    private const val TAG = "EnergyReader"
+
+    init {
+        System.loadLibrary("eagleEye")
+    }
+
+    fun readAll(paths: List<String>): Array<Mat> {
+        val energyMats = Array(paths.size) { Mat() }
+        val complete = readEnergyNative(paths.toTypedArray(), LongArray(paths.size) { energyMats[it].nativeObj })
+        if (!complete) {
+            for (i in paths.indices) {
+                if (energyMats[i].empty()) {
+                    Log.w(TAG, "Native energy read failed for ${paths[i]}, decoding at full resolution.")
+                    val reader = InputImageEnergyReader(Semaphore(0), paths[i])
+                    reader.run()
+                    energyMats[i].release()
+                    energyMats[i] = reader.outputMat!!
+                }
+            }
+        }
+        return energyMats
+    }
+
+    private external fun readEnergyNative(paths: Array<String>, outputAddrs: LongArray): Boolean
+}
@@ -311,10 +311,10 @@ class CameraController(private val context: Context, private val viewModel: Came
 
 
     // helpers
-    fun getHighestResolution(): Size? {
+    fun getHighestResolution(format: Int = ImageFormat.JPEG): Size? {
         val characteristics = cameraManager.getCameraCharacteristics(cameraId)
         val map = characteristics.get(CameraCharacteristics.SCALER_STREAM_CONFIGURATION_MAP)
-        val sizes = map?.getOutputSizes(ImageFormat.JPEG)
+        val sizes = map?.getOutputSizes(format)
         return sizes?.sortedWith(compareBy { it.width * it.height })?.last()
     }
 
@@ -30,6 +30,11 @@ class ParameterConfig private constructor(appContext: Context) {
 
         const val FEATURE_MINIMUM_DISTANCE_KEY = "FEATURE_MINIMUM_DISTANCE_KEY"
         const val WARP_CHOICE_KEY = "WARP_CHOICE_KEY"
+        const val PYRAMID_ALIGNMENT_KEY = "PYRAMID_ALIGNMENT_KEY"
+        const val SHARPNESS_SCREENING_KEY = "SHARPNESS_SCREENING_KEY"
+        const val WARP_EVALUATION_LEVEL_KEY = "WARP_EVALUATION_LEVEL_KEY"
+        const val YUV_CAPTURE_KEY = "YUV_CAPTURE_KEY"
+        const val DENOISE_BATCH_SIZE_KEY = "DENOISE_BATCH_SIZE_KEY"
 
         @JvmStatic
         fun hasInitialized(): Boolean {
@@ -215,6 +220,21 @@ class ParameterConfig private constructor(appContext: Context) {
             return sharedInstance?.sharedPrefs?.getFloat(EXPOSURE_COMPENSATION_KEY, 0f) ?: 0f
         }
 
+        /*
+        * Alignment technique of the super-resolution stage: 1 = best alignment, 2 = median alignment,
+        * 3 = perspective warping (default), 4 = shift-and-add super-resolution
+        * */
+        @JvmStatic
+        fun setWarpChoice(choice: Int) {
+            setPrefs(WARP_CHOICE_KEY, choice)
+            Log.d(TAG, "Warp choice set to: $choice")
+        }
+
+        @JvmStatic
+        fun getWarpChoice(): Int {
+            return getPrefsInt(WARP_CHOICE_KEY, 3)
+        }
+
         @JvmStatic
         fun revertToDefault() {
             sharedInstance?.editorPrefs?.clear()?.apply()
@@ -12,6 +12,7 @@ class DirectoryStorage private constructor() {
         const val DEBUG_FILE_PREFIX = "/DEBUG"
         const val RESULT_ALBUM_NAME_PREFIX = "/Results"
         const val SR_ALBUM_NAME_PREFIX = "/SR"
+        const val TRACE_ALBUM_NAME_PREFIX = "/Traces"
 
         private val SUB_ALBUM_NAME_PREFIX: List<String> = listOf(
             RESULT_ALBUM_NAME_PREFIX,
@@ -84,6 +85,10 @@ class DirectoryStorage private constructor() {
         return Environment.getExternalStoragePublicDirectory(Environment.DIRECTORY_PICTURES).toString() + ROOT_ALBUM_NAME_PREFIX + startingAlbum + RESULT_ALBUM_NAME_PREFIX
     }
 
+    fun getTraceFilePath(): String {
+        return Environment.getExternalStoragePublicDirectory(Environment.DIRECTORY_PICTURES).toString() + ROOT_ALBUM_NAME_PREFIX + startingAlbum + TRACE_ALBUM_NAME_PREFIX
+    }
+
     fun getDebugFilePath(): String {
         return Environment.getExternalStoragePublicDirectory(Environment.DIRECTORY_PICTURES).toString() + DEBUG_FILE_PREFIX
     }
@@ -0,0 +1,108 @@
+package com.wangGang.eagleEye.io
+
+import android.util.Log
+import com.wangGang.eagleEye.processing.imagetools.ImageOperator
+import org.opencv.core.Mat
+import java.io.File
+
+/**
+ * Native store of the decoded burst frames of one super-resolution run, keyed by capture index (the position in
+ * imageInputMap), and of frames derived from them, such as the sharpened burst, under derivedIndex(). Every capture is decoded once, on first use, and then shared by all stages. Frames beyond the memory budget are spilled to raw files and read
+ * back from there instead of being decoded again.
+ *
+ * acquire() returns a view that shares the stored buffer: release the Mat as usual and call release(index)
+ * when done, and never modify it in place.
+ */
+object FrameStore {
+    init {
+        System.loadLibrary("eagleEye")
+    }
+
+    private const val TAG = "FrameStore"
+
+    // Resident frames are capped at this, or at a quarter of the available memory if that is lower.
+    private const val MAX_BUDGET_BYTES = 1024L * 1024 * 1024
+
+    // Derived frames are kept under indices well clear of the capture indices.
+    private const val DERIVED_INDEX_BASE = 1 shl 16
+
+    data class Stats(
+        val decodes: Long,
+        val hits: Long,
+        val spills: Long,
+        val reloads: Long,
+        val bytesResident: Long
+    )
+
+    private var spillDirectory: File? = null
+
+    /*
+     * Starts a run over the given capture files. Spill files go to a directory under spillRoot, if given.
+     */
+    fun open(paths: List<String>, spillRoot: String?) {
+        check(nativeClear()) { "Frame store could not be cleared" }
+        spillDirectory = spillRoot?.let { File(it, "frame_store") }?.takeIf { it.isDirectory || it.mkdirs() }
+        val available = ImageOperator.availableNativeMemory()
+        check(nativeConfigure(
+            if (available > 0) minOf(MAX_BUDGET_BYTES, available / 4) else MAX_BUDGET_BYTES,
+            spillDirectory?.absolutePath ?: ""
+        )) { "Frame store could not be configured" }
+        for (i in paths.indices) {
+            check(nativeRegister(i, paths[i])) { "Frame $i could not be registered" }
+        }
+    }
+
+    /*
+     * The frame at the given index. Throws if it cannot be read.
+     */
+    fun acquire(index: Int): Mat {
+        val mat = nativeAcquire(index)
+        check(!mat.empty()) { "Frame $index could not be read" }
+        return mat
+    }
+
+    fun release(index: Int) {
+        // The frame is unpinned either way; a failure here is in evicting other frames to the budget.
+        if (!nativeRelease(index)) {
+            Log.w(TAG, "Enforcing the budget after releasing frame $index failed")
+        }
+    }
+
+    /*
+     * The index under which a frame derived from the capture at index is put. Derived frames have no file, so
+     * they count against the same budget but are spilled rather than dropped.
+     */
+    fun derivedIndex(index: Int) = DERIVED_INDEX_BASE + index
+
+    /*
+     * Hands a decoded frame to the store under the given index, e.g. straight from capture.
+     */
+    fun put(index: Int, mat: Mat) {
+        check(nativePut(index, mat.nativeObj)) { "Frame $index could not be stored" }
+    }
+
+    /*
+     * Drops every frame and its spill file.
+     */
+    fun close() {
+        Log.d(TAG, "Frame store: ${stats()}")
+        if (!nativeClear()) {
+            Log.e(TAG, "Frame store could not be cleared")
+        }
+        spillDirectory?.let { FileImageWriter.getInstance()?.deleteRecursive(it) }
+        spillDirectory = null
+    }
+
+    fun stats(): Stats {
+        val values = nativeStats()
+        return Stats(values[0], values[1], values[2], values[3], values[4])
+    }
+
+    private external fun nativeConfigure(budgetBytes: Long, spillDirectory: String): Boolean
+    private external fun nativeRegister(index: Int, path: String): Boolean
+    private external fun nativePut(index: Int, matAddr: Long): Boolean
+    private external fun nativeAcquire(index: Int): Mat
+    private external fun nativeRelease(index: Int): Boolean
+    private external fun nativeClear(): Boolean
+    private external fun nativeStats(): LongArray
+}
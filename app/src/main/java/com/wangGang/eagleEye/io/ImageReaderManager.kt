@@ -11,6 +11,7 @@ import android.util.Size
 import com.wangGang.eagleEye.camera.CameraController
 import com.wangGang.eagleEye.camera.CameraController.Companion.MAX_BURST_IMAGES
 import com.wangGang.eagleEye.constants.ParameterConfig
+import com.wangGang.eagleEye.model.multiple.OnlineSharpnessScorer
 import com.wangGang.eagleEye.processing.ConcreteSuperResolution
 import com.wangGang.eagleEye.processing.commands.Dehaze
 import com.wangGang.eagleEye.processing.commands.Denoising
@@ -19,14 +20,18 @@ import com.wangGang.eagleEye.processing.commands.SuperResolution
 import com.wangGang.eagleEye.processing.commands.Upscale
 import com.wangGang.eagleEye.processing.dehaze.SynthDehaze
 import com.wangGang.eagleEye.processing.denoise.AKDT
+import com.wangGang.eagleEye.processing.imagetools.ImageOperator
+import com.wangGang.eagleEye.processing.imagetools.MatPool
 import com.wangGang.eagleEye.processing.shadow_remove.SynthShadowRemoval
 import com.wangGang.eagleEye.processing.upscale.Interpolation
 import com.wangGang.eagleEye.ui.utils.ProgressManager
 import com.wangGang.eagleEye.ui.viewmodels.CameraViewModel
+import com.wangGang.eagleEye.utils.NativeTrace
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
+import org.opencv.core.Mat
 
 class ImageReaderManager(
     private val context: Context,
@@ -39,18 +44,36 @@ class ImageReaderManager(
     private var saveAfter = true
     private val TAG = "ImageReaderManager"
 
+    // Burst being screened for sharpness as it arrives. Frames provisionally rejected stay encoded.
+    private var burstScorer: OnlineSharpnessScorer? = null
+    private var burstBytes = arrayOfNulls<ByteArray>(0)
+    private var burstBitmaps = arrayOfNulls<Bitmap>(0)
+    private var burstFramesReady = 0
+    private var burstScreened = false
+
+    // YUV capture: frames arrive as packed planes and are only converted to BGR once kept. With super-resolution
+    // as the first stage the kept frames go to it in memory, without the JPEG save and re-read.
+    private var yuvFrames = arrayOfNulls<YuvFrame>(0)
+    private var yuvBurstMats: Array<Mat>? = null
+    private var yuvBurstEnergy: Array<Mat>? = null
+
     fun initializeImageReader() {
         concreteSuperResolution.initialize(viewModel.getImageInputMap()!!)
-        val highestResolution = cameraController.getHighestResolution()
-        setupImageReader(highestResolution)
+        val format = if (ParameterConfig.getPrefsBoolean(ParameterConfig.YUV_CAPTURE_KEY, false)) {
+            ImageFormat.YUV_420_888
+        } else {
+            ImageFormat.JPEG
+        }
+        val highestResolution = cameraController.getHighestResolution(format)
+        setupImageReader(highestResolution, format)
     }
 
-    private fun setupImageReader(highestResolution: Size?) {
+    private fun setupImageReader(highestResolution: Size?, format: Int) {
         imageReader = if (highestResolution != null) {
             Log.d("ImageReaderManager", "Setting up image reader with resolution: ${highestResolution.width}x${highestResolution.height}")
-            ImageReader.newInstance(highestResolution.width, highestResolution.height, ImageFormat.JPEG, 20)
+            ImageReader.newInstance(highestResolution.width, highestResolution.height, format, 20)
         } else {
-            ImageReader.newInstance(1920, 1080, ImageFormat.JPEG, 1)
+            ImageReader.newInstance(1920, 1080, format, 1)
         }
         cameraController.setImageReader(imageReader)
     }
@@ -64,6 +87,17 @@ class ImageReaderManager(
 
             imageReader.setOnImageAvailableListener({ reader ->
                 val image = reader?.acquireNextImage()
+                if (image?.format == ImageFormat.YUV_420_888) {
+                    // Ingested on the camera thread so the buffer goes back to the camera right away.
+                    val frame = YuvIngest.ingest(image, sensorRotation())
+                    image.close()
+                    frame?.let {
+                        CoroutineScope(Dispatchers.Main).launch {
+                            waitForYuvBurst(it)
+                        }
+                    }
+                    return@setOnImageAvailableListener
+                }
                 image?.let {
                     CoroutineScope(Dispatchers.Main).launch {
                         waitForImageBurst(it) // Now we call the suspend function properly
@@ -78,14 +112,133 @@ class ImageReaderManager(
         val bytes = ByteArray(buffer.remaining())
         buffer.get(bytes)
         image.close()
-        imageList.add(BitmapFactory.decodeByteArray(bytes, 0, bytes.size))
         val totalCaptures = if (ParameterConfig.isSuperResolutionEnabled()) MAX_BURST_IMAGES else 1
         Log.d(TAG, "Total captures: $totalCaptures")
+        if (totalCaptures > 1 && ParameterConfig.getPrefsBoolean(ParameterConfig.SHARPNESS_SCREENING_KEY, true)) {
+            screenBurstFrame(bytes, totalCaptures)
+            return
+        }
+        imageList.add(BitmapFactory.decodeByteArray(bytes, 0, bytes.size))
         if (imageList.size == totalCaptures) {
-            ProgressManager.getInstance().showFirstTask()
+            burstScreened = false
+            processBurst()
+        }
+    }
+
+    /*
+     * Scores the frame from a 1/8 scale decode before anything else is done with it. Frames below the running
+     * mean are not decoded; when the burst is complete only the frames at or above the burst mean are decoded
+     * and go on to be saved and processed.
+     */
+    private suspend fun screenBurstFrame(bytes: ByteArray, totalCaptures: Int) {
+        val scorer = burstScorer ?: OnlineSharpnessScorer(totalCaptures).also {
+            burstScorer = it
+            burstBytes = arrayOfNulls(totalCaptures)
+            burstBitmaps = arrayOfNulls(totalCaptures)
+            burstFramesReady = 0
+        }
+        val index = scorer.nextIndex()
+        burstBytes[index] = bytes
+
+        val score = withContext(Dispatchers.Default) { scorer.score(bytes) }
+        if (scorer.add(index, score)) {
+            burstBitmaps[index] = withContext(Dispatchers.Default) {
+                BitmapFactory.decodeByteArray(bytes, 0, bytes.size)
+            }
+            burstBytes[index] = null
+        } else {
+            Log.d(TAG, "Frame $index provisionally rejected: sharpness $score < running mean ${scorer.runningMean}")
+        }
+
+        burstFramesReady++
+        if (burstFramesReady < totalCaptures) {
+            return
+        }
+
+        val selection = scorer.finalSelection()
+        Log.d(TAG, "Sharpness scores: ${scorer.getScores().joinToString()} keeping frames $selection")
+        for (i in selection) {
+            val frameBytes = burstBytes[i]
+            imageList.add(burstBitmaps[i] ?: withContext(Dispatchers.Default) {
+                BitmapFactory.decodeByteArray(frameBytes, 0, frameBytes!!.size)
+            })
+        }
+        burstScorer = null
+        burstBytes = arrayOfNulls(0)
+        burstBitmaps = arrayOfNulls(0)
+        burstScreened = true
+        processBurst()
+    }
+
+    /*
+     * The rotation saveImageToStorage applies to captured frames.
+     */
+    private fun sensorRotation(): Int {
+        return when (cameraController.getSensorOrientation()) {
+            90 -> ImageOperator.ROTATION_CLOCKWISE_90
+            180 -> ImageOperator.ROTATION_180
+            270 -> ImageOperator.ROTATION_COUNTERCLOCKWISE_90
+            else -> ImageOperator.ROTATION_NONE
+        }
+    }
+
+    /*
+     * YUV counterpart of waitForImageBurst + screenBurstFrame. Frames were scored on ingest and stay packed at
+     * 1.5 bytes per pixel until the burst is complete; then the kept frames are converted to BGR once.
+     */
+    private suspend fun waitForYuvBurst(frame: YuvFrame) {
+        val totalCaptures = if (ParameterConfig.isSuperResolutionEnabled()) MAX_BURST_IMAGES else 1
+        val scorer = burstScorer ?: OnlineSharpnessScorer(totalCaptures).also {
+            burstScorer = it
+            yuvFrames = arrayOfNulls(totalCaptures)
+            burstFramesReady = 0
+        }
+        val index = scorer.nextIndex()
+        yuvFrames[index] = frame
+        scorer.add(index, frame.sharpness)
+
+        burstFramesReady++
+        if (burstFramesReady < totalCaptures) {
+            return
+        }
+
+        val screening = totalCaptures > 1 && ParameterConfig.getPrefsBoolean(ParameterConfig.SHARPNESS_SCREENING_KEY, true)
+        val selection = if (screening) scorer.finalSelection() else (0 until totalCaptures).toList()
+        Log.d(TAG, "Sharpness scores: ${scorer.getScores().joinToString()} keeping frames $selection")
+        val kept = selection.mapNotNull { yuvFrames[it] }
+        yuvFrames.forEachIndexed { i, rejected -> if (i !in selection) rejected?.release() }
+        yuvFrames = arrayOfNulls(0)
+        burstScorer = null
+
+        val mats = withContext(Dispatchers.Default) { kept.map { it.toBgr() }.toTypedArray() }
+        val inMemorySr = totalCaptures > 1 &&
+                ParameterConfig.getProcessingOrder().firstOrNull() == SuperResolution.displayName
+        if (inMemorySr) {
+            // Only the "before" image is needed as a bitmap; the frames go to super-resolution as they are.
+            imageList.add(ImageOperator.matToBitmap(mats[0]))
+            yuvBurstMats = mats
+            yuvBurstEnergy = kept.map { it.energy }.toTypedArray()
+        } else {
+            for (mat in mats) {
+                imageList.add(ImageOperator.matToBitmap(mat))
+                mat.release()
+            }
+            kept.forEach { it.energy.release() }
+        }
+        burstScreened = screening
+        processBurst()
+    }
+
+    private suspend fun processBurst() {
+        NativeTrace.beginCapture()
+        ProgressManager.getInstance().showFirstTask()
+        try {
             processImage()
-            clearSrImages()
+        } finally {
+            // A failed burst must not leave the capture open into the next one.
+            NativeTrace.endCaptureToTraceDir()
         }
+        clearSrImages()
     }
 
     private fun clearSrImages() {
@@ -103,15 +256,19 @@ class ImageReaderManager(
         cameraController.closeCamera()
         if (order.isNotEmpty()) {
             Log.d("order", ""+order)
-            for (each in order) {
-                Log.d(TAG, "Processing image with: $each")
-                when (each) {
-                    Dehaze.displayName -> handleDehazeImage()
-                    SuperResolution.displayName -> handleSuperResolutionImage()
-                    Upscale.displayName -> handleUpscaleImage()
-                    ShadowRemoval.displayName -> handleShadowRemoval()
-                    Denoising.displayName -> handleDenoisingImage()
+            // Pool the Mat buffers for the whole run, the stages allocate and drop full-frame Mats constantly.
+            MatPool.session {
+                for (each in order) {
+                    Log.d(TAG, "Processing image with: $each")
+                    when (each) {
+                        Dehaze.displayName -> handleDehazeImage()
+                        SuperResolution.displayName -> handleSuperResolutionImage()
+                        Upscale.displayName -> handleUpscaleImage()
+                        ShadowRemoval.displayName -> handleShadowRemoval()
+                        Denoising.displayName -> handleDenoisingImage()
+                    }
                 }
+                Log.d(TAG, "Mat pool: ${MatPool.stats()}")
             }
         }
         saveImages(oldBitmap)
@@ -211,6 +368,17 @@ class ImageReaderManager(
         Log.d(TAG, "handleSuperResolutionImage()")
 
         val newImageList = mutableListOf<Bitmap>()
+        val burstMats = yuvBurstMats
+        val burstEnergy = yuvBurstEnergy
+        if (burstMats != null && burstEnergy != null) {
+            yuvBurstMats = null
+            yuvBurstEnergy = null
+            newImageList.add(concreteSuperResolution.superResolutionFrames(burstMats, burstEnergy, burstScreened))
+            imageList.clear()
+            imageList.addAll(newImageList)
+            return@withContext
+        }
+        val frameCount = imageList.size
         // Process each image sequentially
 
         for (each in imageList.toList()) {
@@ -221,9 +389,11 @@ class ImageReaderManager(
             }
         }
         imageList.clear()
-        if (viewModel.imageInputMap.value?.size == 10) {
+        if (viewModel.imageInputMap.value?.size == frameCount) {
             // Run super resolution and update image list immediately
-            newImageList.add(concreteSuperResolution.superResolutionImage(viewModel.imageInputMap.value!!))
+            newImageList.add(
+                concreteSuperResolution.superResolutionImage(viewModel.imageInputMap.value!!, burstScreened)
+            )
             viewModel.clearImageInputMap()
         }
 
@@ -0,0 +1,86 @@
+package com.wangGang.eagleEye.io
+
+import android.graphics.ImageFormat
+import android.media.Image
+import android.util.Log
+import org.opencv.core.Mat
+import java.nio.ByteBuffer
+
+/**
+ * A YUV_420_888 burst frame after native ingest: the planes packed as I420, the 1/8 scale luminance the energy
+ * reader would have produced and the sharpness score. Converted to BGR only if the frame is kept.
+ */
+class YuvFrame(private val i420: Mat, val energy: Mat, val sharpness: Double, private val rotation: Int) {
+    /*
+     * The frame as BGR, rotated like the JPEGs saveImageToStorage writes. Releases the packed planes.
+     */
+    fun toBgr(): Mat {
+        val bgr = Mat()
+        val converted = YuvIngest.toBgr(i420, rotation, bgr)
+        i420.release()
+        check(converted) { "YUV to BGR conversion failed" }
+        return bgr
+    }
+
+    fun release() {
+        i420.release()
+        energy.release()
+    }
+}
+
+/**
+ * Native ingest of YUV_420_888 camera frames. The planes are read through their direct ByteBuffers, so the frame
+ * is never JPEG encoded by the camera nor decoded again by the app; energy and sharpness come straight from the
+ * Y plane while the Image is still open.
+ */
+object YuvIngest {
+    private const val TAG = "YuvIngest"
+
+    init {
+        System.loadLibrary("eagleEye")
+    }
+
+    /*
+     * Copies the frame out of the image. The image can be closed as soon as this returns.
+     */
+    fun ingest(image: Image, rotation: Int): YuvFrame? {
+        if (image.format != ImageFormat.YUV_420_888) {
+            Log.e(TAG, "Expected YUV_420_888, got format ${image.format}")
+            return null
+        }
+        val y = image.planes[0]
+        val u = image.planes[1]
+        val v = image.planes[2]
+        val i420 = Mat()
+        val energy = Mat()
+        val sharpness = ingestNative(
+            y.buffer, u.buffer, v.buffer, image.width, image.height,
+            y.rowStride, u.rowStride, u.pixelStride, rotation,
+            i420.nativeObj, energy.nativeObj
+        )
+        if (sharpness < 0.0) {
+            i420.release()
+            energy.release()
+            return null
+        }
+        return YuvFrame(i420, energy, sharpness, rotation)
+    }
+
+    internal fun toBgr(i420: Mat, rotation: Int, bgr: Mat): Boolean = toBgrNative(i420.nativeObj, rotation, bgr.nativeObj)
+
+    private external fun ingestNative(
+        yBuffer: ByteBuffer,
+        uBuffer: ByteBuffer,
+        vBuffer: ByteBuffer,
+        width: Int,
+        height: Int,
+        yRowStride: Int,
+        uvRowStride: Int,
+        uvPixelStride: Int,
+        rotation: Int,
+        i420Addr: Long,
+        energyAddr: Long
+    ): Double
+
+    private external fun toBgrNative(i420Addr: Long, rotation: Int, bgrAddr: Long): Boolean
+}
@@ -0,0 +1,66 @@
+package com.wangGang.eagleEye.model.multiple
+
+/**
+ * Incremental counterpart of SharpnessMeasure for burst frames as they arrive from the ImageReader.
+ * Each JPEG is scored natively from a 1/8 scale decode with the same measure as the energy + Yang filter +
+ * measureSharpness stages, and folded into a running mean. A frame below the running mean is provisionally
+ * rejected, so the caller can skip decoding it. Once the burst is complete, finalSelection() keeps the frames
+ * at or above the burst mean, the same frames SharpnessMeasure.trimMatList would have kept after the fact.
+ */
+class OnlineSharpnessScorer(private val frameCount: Int) {
+
+    companion object {
+        init {
+            System.loadLibrary("eagleEye")
+        }
+    }
+
+    private val scores = DoubleArray(frameCount)
+    private var arrived = 0
+    private var scored = 0
+    private var sum = 0.0
+
+    val runningMean: Double
+        get() = if (scored == 0) 0.0 else sum / scored
+
+    /*
+     * Reserves the burst index of the next arriving frame. Call on the thread that receives the frames.
+     */
+    fun nextIndex(): Int {
+        check(arrived < frameCount) { "All $frameCount frames have already arrived" }
+        return arrived++
+    }
+
+    /*
+     * Sharpness of an encoded JPEG. Does not touch the scorer state, so it can run off the main thread.
+     */
+    fun score(jpegBytes: ByteArray): Double {
+        return scoreJpegNative(jpegBytes).coerceAtLeast(0.0)
+    }
+
+    /*
+     * Records the score of frame index. Returns false if the frame is below the running mean (itself included)
+     * and is provisionally rejected.
+     */
+    fun add(index: Int, score: Double): Boolean {
+        scores[index] = score
+        sum += score
+        scored++
+        return score >= runningMean
+    }
+
+    fun isComplete(): Boolean = scored == frameCount
+
+    /*
+     * Indices of the frames at or above the mean of the whole burst, in capture order.
+     */
+    fun finalSelection(): List<Int> {
+        check(isComplete()) { "Only $scored of $frameCount frames have been scored" }
+        val mean = sum / frameCount
+        return scores.indices.filter { scores[it] >= mean }
+    }
+
+    fun getScores(): DoubleArray = scores.copyOf()
+
+    private external fun scoreJpegNative(jpegBytes: ByteArray): Double
+}
@@ -4,11 +4,12 @@ package com.wangGang.eagleEye.processing
 import android.graphics.Bitmap
 import android.util.Log
 import com.wangGang.eagleEye.processing.multiple.alignment.LRWarpingOperator
-import com.wangGang.eagleEye.assessment.InputImageEnergyReader
+import com.wangGang.eagleEye.assessment.EnergyReader
 import com.wangGang.eagleEye.constants.ParameterConfig
 import com.wangGang.eagleEye.io.DirectoryStorage
 import com.wangGang.eagleEye.io.FileImageReader
 import com.wangGang.eagleEye.io.FileImageWriter
+import com.wangGang.eagleEye.io.FrameStore
 import com.wangGang.eagleEye.io.ImageFileAttribute
 import com.wangGang.eagleEye.model.AttributeHolder
 import com.wangGang.eagleEye.model.multiple.SharpnessMeasure
@@ -20,6 +21,8 @@ import com.wangGang.eagleEye.processing.multiple.alignment.MedianAlignmentOperat
 import com.wangGang.eagleEye.processing.multiple.alignment.WarpResultEvaluator
 import com.wangGang.eagleEye.processing.multiple.enhancement.UnsharpMaskOperator
 import com.wangGang.eagleEye.processing.multiple.fusion.MeanFusionOperator
+import com.wangGang.eagleEye.processing.multiple.fusion.ShiftAddOperator
+import com.wangGang.eagleEye.processing.multiple.fusion.WarpFusionOperator
 import com.wangGang.eagleEye.ui.activities.CameraControllerActivity
 import com.wangGang.eagleEye.ui.utils.ProgressManager
 import com.wangGang.eagleEye.ui.viewmodels.CameraViewModel
@@ -31,7 +34,6 @@ import kotlinx.coroutines.withContext
 import org.opencv.core.Mat
 import org.opencv.imgproc.Imgproc
 import java.io.File
-import java.util.concurrent.Semaphore
 
 const val TAG = "ConcreteSuperResolution"
 
@@ -39,28 +41,7 @@ class ConcreteSuperResolution(private val viewModel: CameraViewModel) : SuperRes
 
     override fun readEnergy(imageInputMap: List<String>): Array<Mat> {
 //        viewModel.updateLoadingText("Reading energy")
-        val inputMatList: Array<Mat> = Array(imageInputMap.size) { Mat() }
-
-        try {
-            for (i in imageInputMap.indices) {
-                // Create a dummy semaphore because InputImageEnergyReader requires one.
-                // Its release from finishWork() is not used in sequential processing.
-                val dummySem = Semaphore(0)
-                val reader = InputImageEnergyReader(dummySem, imageInputMap[i])
-
-                // Start the reader and wait for it to finish before proceeding
-                reader.start()
-                reader.join()  // Wait until this thread completes
-
-                // Copy the result from the reader to the array
-                inputMatList[i] = reader.outputMat!!
-            }
-
-        } catch (e: InterruptedException) {
-            e.printStackTrace()
-        }
-
-        return inputMatList
+        return EnergyReader.readAll(imageInputMap)
     }
 
 
@@ -75,33 +56,58 @@ class ConcreteSuperResolution(private val viewModel: CameraViewModel) : SuperRes
         return SharpnessMeasure.getSharedInstance().measureSharpness(filteredMatList)
     }
 
-    override fun performSuperResolution(filteredMatList: Array<Mat>, imageInputMap: List<String>): Bitmap {
+    override fun performSuperResolution(
+        filteredMatList: Array<Mat>,
+        imageInputMap: List<String>,
+        prescreened: Boolean,
+        frames: Array<Mat>?
+    ): Bitmap {
         viewModel.updateLoadingText("Measuring Sharpness")
         val sharpnessResult = SharpnessMeasure.getSharedInstance().measureSharpness(filteredMatList)
-        val inputIndices: Array<Int> = SharpnessMeasure.getSharedInstance().trimMatList(imageInputMap.size, sharpnessResult, 0.0)
+        // Prescreened bursts only contain the frames at or above the burst mean, trimming again would halve them.
+        val inputIndices: Array<Int> = if (prescreened) {
+            Array(imageInputMap.size) { it }
+        } else {
+            SharpnessMeasure.getSharedInstance().trimMatList(imageInputMap.size, sharpnessResult, 0.0)
+        }
 
         ProgressManager.getInstance().nextTask()
 
-        val rgbInputMatList = Array(inputIndices.size) { "" }
-
         val bestIndex = inputIndices.indexOf(sharpnessResult.bestIndex)
 
         ProgressManager.getInstance().nextTask()
 
-        runBlocking {
-            for ((index, i) in inputIndices.withIndex()) {
-                withContext(Dispatchers.IO) {
-                    val inputMat = FileImageReader.getInstance()!!.imReadFullPath(imageInputMap[i])
-                    val unsharpMaskOperator = UnsharpMaskOperator(inputMat, i)
-                    unsharpMaskOperator.perform()
-                    rgbInputMatList[index] = unsharpMaskOperator.getFilePath()!!
-                    inputMat.release()
-                }
+        // Every capture is decoded once into the frame store; the later stages that need the reference again
+        // take it from there instead of decoding its file another time.
+        FrameStore.open(imageInputMap, FileImageWriter.getInstance()?.getFilePath())
+        try {
+            // Frames captured as YUV have no files; the store keeps the only reference and spills them if needed.
+            frames?.forEachIndexed { i, frame ->
+                FrameStore.put(i, frame)
+                frame.release()
+            }
+            // Each sharpened frame goes back into the store under its derived index as soon as it is done, so it
+            // counts against the budget and can be spilled; it is only written out if the alignment needs files.
+            val sharpenedIndices = runBlocking {
+                inputIndices.map { i ->
+                    withContext(Dispatchers.IO) {
+                        val inputMat = FrameStore.acquire(i)
+                        val unsharpMaskOperator = UnsharpMaskOperator(inputMat, i)
+                        unsharpMaskOperator.perform()
+                        FrameStore.release(i)
+                        val sharpenedIndex = FrameStore.derivedIndex(i)
+                        FrameStore.put(sharpenedIndex, unsharpMaskOperator.getOutputMat())
+                        unsharpMaskOperator.getOutputMat().release()
+                        sharpenedIndex
+                    }
+                }.toTypedArray()
             }
-        }
 
-        // Perform actual super-resolution
-        return performFullSRMode(rgbInputMatList, inputIndices, imageInputMap, bestIndex, false)
+            // Perform actual super-resolution
+            return performFullSRMode(sharpenedIndices, inputIndices, imageInputMap, bestIndex, false)
+        } finally {
+            FrameStore.close()
+        }
     }
 
     private fun performMedianAlignment(imagesToAlignList: Array<String>, resultNames: Array<String>) {
@@ -111,25 +117,58 @@ class ConcreteSuperResolution(private val viewModel: CameraViewModel) : SuperRes
     }
 
     private fun interpolateImage(index: Int, imageInputMap: List<String>) {
-        val inputMat = FileImageReader.getInstance()!!.imReadFullPath(imageInputMap[index])
+        val inputMat = FrameStore.acquire(index)
 
         val outputMat = ImageOperator.performInterpolation(inputMat, ParameterConfig.getScalingFactor().toFloat(), Imgproc.INTER_LINEAR)
         FileImageWriter.getInstance()?.saveMatrixToImage(outputMat, DirectoryStorage.SR_ALBUM_NAME_PREFIX, "linear", ImageFileAttribute.FileType.JPEG)
         outputMat.release()
 
         inputMat.release()
+        FrameStore.release(index)
         System.gc()
     }
 
     private fun performFullSRMode(
-        rgbInputMatList: Array<String>,
+        sharpenedIndices: Array<Int>,
         inputIndices: Array<Int>,
         imageInputMap: List<String>,
         bestIndex: Int,
         debug: Boolean
     ): Bitmap {
         // Perform feature matching of LR images against the first image as reference mat.
-        val warpChoice = ParameterConfig.getPrefsInt(ParameterConfig.WARP_CHOICE_KEY, 3)
+        val warpChoice = ParameterConfig.getWarpChoice()
+
+        // The in-memory engines register and fuse the whole burst at once, so they pin every sharpened frame.
+        if (warpChoice == 4 && !debug && sharpenedIndices.size > 1) {
+            ProgressManager.getInstance().nextTask()
+            viewModel.updateLoadingText("Performing Shift-and-Add Super-Resolution")
+            val sharpenedMats = Array(sharpenedIndices.size) { FrameStore.acquire(sharpenedIndices[it]) }
+            try {
+                return performShiftAdd(sharpenedMats, imageInputMap)
+            } finally {
+                sharpenedIndices.forEach { FrameStore.release(it) }
+            }
+        }
+
+        if (warpChoice == 3 && !debug && sharpenedIndices.size > 2) {
+            ProgressManager.getInstance().nextTask()
+            viewModel.updateLoadingText("Performing Perspective Warping")
+            val sharpenedMats = Array(sharpenedIndices.size) { FrameStore.acquire(sharpenedIndices[it]) }
+            try {
+                return performWarpFusion(sharpenedMats, imageInputMap, inputIndices[0])
+            } finally {
+                sharpenedIndices.forEach { FrameStore.release(it) }
+            }
+        }
+
+        // The remaining alignment techniques work on files, written one frame at a time.
+        val rgbInputMatList = Array(sharpenedIndices.size) {
+            val sharpenedMat = FrameStore.acquire(sharpenedIndices[it])
+            val path = UnsharpMaskOperator.saveToFile(sharpenedMat, inputIndices[it])!!
+            sharpenedMat.release()
+            FrameStore.release(sharpenedIndices[it])
+            path
+        }
 
         // Perform perspective warping and alignment
 //        Preprocessing Images
@@ -141,6 +180,7 @@ class ConcreteSuperResolution(private val viewModel: CameraViewModel) : SuperRes
         // 1 = Best Alignment Technique
         // 2 = Median Alignment
         // 3 = Perspective Warping
+        // 4 = Shift-and-add super-resolution (handled above)
         // 3 is default
         when (warpChoice) {
             1 -> {
@@ -185,7 +225,8 @@ class ConcreteSuperResolution(private val viewModel: CameraViewModel) : SuperRes
             imagesToWarpList,
             resultNames,
             matchingOperator.getdMatchesList(),
-            matchingOperator.lrKeypointsList
+            matchingOperator.lrKeypointsList,
+            matchingOperator.homographyList
         )
         perspectiveWarpOperator.perform()
 
@@ -193,6 +234,73 @@ class ConcreteSuperResolution(private val viewModel: CameraViewModel) : SuperRes
         matchingOperator.refKeypoint.release()
     }
 
+    /*
+     * Perspective warping straight into the mean fusion: the warped frames only ever exist tile by tile in
+     * native memory, so no warp_i images are encoded, re-read by an evaluator or re-read by the fusion.
+     */
+    private fun performWarpFusion(
+        sharpenedMats: Array<Mat>,
+        imageInputMap: List<String>,
+        index: Int
+    ): Bitmap {
+        val refMat = sharpenedMats[0]
+        val candidateMats = sharpenedMats.sliceArray(1 until sharpenedMats.size)
+        val matchingOperator = FeatureMatchingOperator(refMat, candidateMats)
+        matchingOperator.perform()
+        refMat.release()
+        matchingOperator.refKeypoint.release()
+        matchingOperator.lrKeypointsList.forEach { it?.release() }
+        matchingOperator.getdMatchesList().forEach { it?.release() }
+
+        ProgressManager.getInstance().nextTask()
+        SharpnessMeasure.destroy()
+        ProgressManager.getInstance().nextTask()
+
+        viewModel.updateLoadingText("Performing Mean Fusion")
+        // Pinned before the capture files go, so the store cannot drop it and find nothing to decode.
+        val inputMat = FrameStore.acquire(index)
+        for (i in imageInputMap.indices) {
+            FileImageWriter.getInstance()?.deleteRecursive(File(imageInputMap[i]))
+        }
+
+        val fusionOperator = WarpFusionOperator(inputMat, candidateMats, matchingOperator.homographyList)
+        val bitmapResult = fusionOperator.perform()
+        FrameStore.release(index)
+
+        ProgressManager.getInstance().nextTask()
+        return bitmapResult
+    }
+
+    /*
+     * Multi-frame super-resolution proper: the burst is registered with homographies and every frame's samples
+     * are placed at their sub-pixel positions on the HR grid, instead of fusing at LR resolution.
+     */
+    private fun performShiftAdd(sharpenedMats: Array<Mat>, imageInputMap: List<String>): Bitmap {
+        val refMat = sharpenedMats[0]
+        val candidateMats = sharpenedMats.sliceArray(1 until sharpenedMats.size)
+        val matchingOperator = FeatureMatchingOperator(refMat, candidateMats)
+        matchingOperator.perform()
+        matchingOperator.refKeypoint.release()
+        matchingOperator.lrKeypointsList.forEach { it?.release() }
+        matchingOperator.getdMatchesList().forEach { it?.release() }
+
+        ProgressManager.getInstance().nextTask()
+        SharpnessMeasure.destroy()
+        ProgressManager.getInstance().nextTask()
+
+        for (i in imageInputMap.indices) {
+            FileImageWriter.getInstance()?.deleteRecursive(File(imageInputMap[i]))
+        }
+
+        // The reference goes in first and unwarped.
+        val homographies = arrayOf<Mat?>(null) + matchingOperator.homographyList
+        val shiftAddOperator = ShiftAddOperator(sharpenedMats, homographies, ParameterConfig.getScalingFactor())
+        val bitmapResult = shiftAddOperator.perform()
+
+        ProgressManager.getInstance().nextTask()
+        return bitmapResult
+    }
+
     private fun assessImageWarpResults(
         index: Int,
         alignmentUsed: Int,
@@ -209,11 +317,14 @@ class ConcreteSuperResolution(private val viewModel: CameraViewModel) : SuperRes
                     referenceMat = if (useLocalDir) {
                         fileImageReader.imReadOpenCV("input_$index", ImageFileAttribute.FileType.JPEG)
                     } else {
-                        fileImageReader.imReadFullPath(imageInputMap[index])
+                        FrameStore.acquire(index)
                     }
 
                     val warpResultEvaluator = WarpResultEvaluator(referenceMat, warpedImageNames, medianAlignedNames)
                     warpResultEvaluator.perform()
+                    if (!useLocalDir) {
+                        FrameStore.release(index)
+                    }
 
                     // Filter out null values and convert to a non-nullable array
                     warpResultEvaluator.chosenAlignedNames.filterNotNull().toTypedArray()
@@ -242,14 +353,16 @@ class ConcreteSuperResolution(private val viewModel: CameraViewModel) : SuperRes
                     ImageFileAttribute.FileType.JPEG
                 ) ?: throw IllegalStateException("FileImageReader instance is null")
             } else {
-                FileImageReader.getInstance()?.imReadFullPath(
-                    imageInputMap[bestIndex]
-                ) ?: throw IllegalStateException("FileImageReader instance is null")
+                FrameStore.acquire(bestIndex)
             }
 
             ProgressManager.getInstance().nextTask()
 
-            return ImageOperator.matToBitmap(resultMat)
+            val bitmap = ImageOperator.matToBitmap(resultMat)
+            if (!debugMode) {
+                FrameStore.release(bestIndex)
+            }
+            return bitmap
 
         } else {
             viewModel.updateLoadingText("Performing Mean Fusion")
@@ -262,9 +375,7 @@ class ConcreteSuperResolution(private val viewModel: CameraViewModel) : SuperRes
                     ImageFileAttribute.FileType.JPEG
                 ) ?: throw IllegalStateException("FileImageReader instance is null")
             } else {
-                FileImageReader.getInstance()?.imReadFullPath(
-                    imageInputMap[index]
-                ) ?: throw IllegalStateException("FileImageReader instance is null")
+                FrameStore.acquire(index)
             }
 
             for (alignedImageName in alignedImageNames) {
@@ -278,6 +389,9 @@ class ConcreteSuperResolution(private val viewModel: CameraViewModel) : SuperRes
             }
 
             val bitmapResult = fusionOperator.perform()
+            if (!debugMode) {
+                FrameStore.release(index)
+            }
 
             ProgressManager.getInstance().nextTask()
 
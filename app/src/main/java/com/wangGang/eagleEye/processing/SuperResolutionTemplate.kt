@@ -11,13 +11,26 @@ import org.opencv.core.Mat
 
 abstract class SuperResolutionTemplate {
 
-    // Template method
-    fun superResolutionImage(imageInputMap: List<String>): Bitmap {
+    // Template method. prescreened: frames below the burst sharpness mean were already dropped at capture.
+    fun superResolutionImage(imageInputMap: List<String>, prescreened: Boolean = false): Bitmap {
         val filteredMatList = initialize(imageInputMap)
-        return performSuperResolution(filteredMatList, imageInputMap)
+        return performSuperResolution(filteredMatList, imageInputMap, prescreened, null)
 //        finalizeProcess()
     }
 
+    // Same for frames that are already decoded (YUV capture), with the energy images computed at ingest.
+    fun superResolutionFrames(frames: Array<Mat>, energyMats: Array<Mat>, prescreened: Boolean): Bitmap {
+        SharpnessMeasure.initialize()
+        ProgressManager.getInstance().nextTask()
+
+        val filteredMatList = applyFilter(energyMats)
+        ProgressManager.getInstance().nextTask()
+
+        energyMats.forEach { it.release() }
+
+        return performSuperResolution(filteredMatList, List(frames.size) { "" }, prescreened, frames)
+    }
+
     open fun initialize(imageInputMap: List<String>): Array<Mat> {
 
         SharpnessMeasure.initialize()
@@ -39,7 +52,12 @@ abstract class SuperResolutionTemplate {
 
     protected abstract fun measureSharpness(filteredMatList: Array<Mat>): SharpnessResult
 
-    protected abstract fun performSuperResolution(filteredMatList: Array<Mat>, imageInputMap: List<String>): Bitmap
+    protected abstract fun performSuperResolution(
+        filteredMatList: Array<Mat>,
+        imageInputMap: List<String>,
+        prescreened: Boolean,
+        frames: Array<Mat>?
+    ): Bitmap
 
     protected open fun finalizeProcess() {
         SRProcessManager.getInstance().srProcessCompleted()
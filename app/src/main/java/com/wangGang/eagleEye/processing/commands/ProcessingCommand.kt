@@ -1,8 +1,17 @@
 package com.wangGang.eagleEye.processing.commands
 
 import androidx.compose.ui.graphics.Color
+import com.wangGang.eagleEye.processing.dehaze.SynthDehaze
+import com.wangGang.eagleEye.processing.denoise.AKDT
+import com.wangGang.eagleEye.processing.shadow_remove.SynthShadowRemoval
 
-sealed class ProcessingCommand(val displayName: String, val tasks: List<String>, color: Color) {
+// models: the ONNX model assets the command runs, loaded ahead of time while it is in the processing order.
+sealed class ProcessingCommand(
+    val displayName: String,
+    val tasks: List<String>,
+    color: Color,
+    val models: List<String> = emptyList()
+) {
     // Function to return the size of the tasks list.
     fun calculate(): Int = tasks.size
 
@@ -60,7 +69,8 @@ data object Dehaze : ProcessingCommand(
         "Processing Image",
         "Converting Image"
     ),
-    color = Color.Yellow
+    color = Color.Yellow,
+    models = listOf(SynthDehaze.MODEL_ALBEDO, SynthDehaze.MODEL_TRANSMISSION, SynthDehaze.MODEL_AIRLIGHT)
 )
 
 data object Upscale : ProcessingCommand(
@@ -84,7 +94,8 @@ data object ShadowRemoval : ProcessingCommand(
         "Running Shadow Model",
         "Cropping Final Output"
     ),
-    color = Color.Gray
+    color = Color.Gray,
+    models = listOf(SynthShadowRemoval.MODEL_SHADOW_MATTE, SynthShadowRemoval.MODEL_SHADOW_REMOVAL)
 )
 
 data object Denoising : ProcessingCommand(
@@ -94,5 +105,6 @@ data object Denoising : ProcessingCommand(
         "Loading Model",
         "Denoising Image"
     ),
-    color = Color.Red
+    color = Color.Red,
+    models = listOf(AKDT.MODEL_PATH)
 )
\ No newline at end of file
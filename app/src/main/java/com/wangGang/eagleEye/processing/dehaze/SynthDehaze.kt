@@ -2,7 +2,6 @@ package com.wangGang.eagleEye.processing.dehaze
 
 import ai.onnxruntime.OnnxTensor
 import ai.onnxruntime.OrtEnvironment
-import ai.onnxruntime.OrtSession
 import android.content.Context
 import android.graphics.Bitmap
 import android.util.Log
@@ -12,6 +11,8 @@ import com.wangGang.eagleEye.io.ImageFileAttribute
 import com.wangGang.eagleEye.io.ImageUtils
 import com.wangGang.eagleEye.io.ResultType
 import com.wangGang.eagleEye.processing.TAG
+import com.wangGang.eagleEye.processing.imagetools.OnnxSessions
+import com.wangGang.eagleEye.processing.imagetools.TensorPack
 import com.wangGang.eagleEye.ui.activities.CameraControllerActivity
 import com.wangGang.eagleEye.ui.utils.ProgressManager
 import com.wangGang.eagleEye.ui.viewmodels.CameraViewModel
@@ -20,6 +21,7 @@ import org.opencv.core.Core
 import org.opencv.core.CvType
 import org.opencv.core.Mat
 import org.opencv.core.MatOfByte
+import org.opencv.core.Rect
 import org.opencv.core.Scalar
 import org.opencv.core.Size
 import org.opencv.imgcodecs.Imgcodecs
@@ -28,6 +30,12 @@ import java.io.InputStream
 import java.nio.FloatBuffer
 
 class SynthDehaze(private val context: Context) {
+    companion object {
+        const val MODEL_ALBEDO = "model/albedo_model.onnx"
+        const val MODEL_TRANSMISSION = "model/transmission_model.onnx"
+        const val MODEL_AIRLIGHT = "model/airlight_model.onnx"
+    }
+
     private fun loadAndResize(bitmap: Bitmap, size: Size): Triple<Mat, Size, Mat> {
 
         // Save before image
@@ -76,56 +84,28 @@ class SynthDehaze(private val context: Context) {
         return Triple(origImg, imSize, img)
     }
 
-    private fun loadModelFromAssets(env: OrtEnvironment, sessionOptions: OrtSession.SessionOptions, modelPath: String): OrtSession {
-        return context.assets.open(modelPath).use { inputStream ->
-            val modelBytes = inputStream.readBytes()
-            env.createSession(modelBytes, sessionOptions)
-        }
-    }
-
     private fun preprocess(img: Mat, env: OrtEnvironment): OnnxTensor {
+        // img is left channel swapped, which the airlight input (resized from the albedo input) relies on; the
+        // tensor itself keeps the channel order img came in with.
         Imgproc.cvtColor(img, img, Imgproc.COLOR_BGR2RGB)
-        val imgFloat = Mat()
-        img.convertTo(imgFloat, CvType.CV_32F, 1.0 / 255.0)
-
-        Core.subtract(imgFloat, Scalar(0.5, 0.5, 0.5), imgFloat)
-        Core.divide(imgFloat, Scalar(0.5, 0.5, 0.5), imgFloat)
-
-        Imgproc.cvtColor(imgFloat, imgFloat, Imgproc.COLOR_BGR2RGB)
-
-        val chwData = FloatArray(3 * img.rows() * img.cols())
-        val channels = mutableListOf(Mat(), Mat(), Mat())
-        Core.split(imgFloat, channels)
-
-        val height = img.rows()
-        val width = img.cols()
-
-        for (i in 0 until height) {
-            for (j in 0 until width) {
-                chwData[i * width + j] = channels[0].get(i, j)[0].toFloat()
-                chwData[height * width + i * width + j] = channels[1].get(i, j)[0].toFloat()
-                chwData[2 * height * width + i * width + j] = channels[2].get(i, j)[0].toFloat()
-            }
-        }
+        val buffer = TensorPack.allocate(3 * img.rows() * img.cols())
+        TensorPack.pack(
+            img, Rect(0, 0, img.cols(), img.rows()), buffer,
+            mean = doubleArrayOf(0.5), std = doubleArrayOf(0.5), swapRB = true
+        )
         val inputShape = longArrayOf(1, 3, img.rows().toLong(), img.cols().toLong())
-        return OnnxTensor.createTensor(env, FloatBuffer.wrap(chwData), inputShape)
+        return OnnxTensor.createTensor(env, buffer, inputShape)
     }
 
     fun dehazeImage(bitmap: Bitmap): Bitmap {
-        val env = OrtEnvironment.getEnvironment()
-        val sessionOptions = OrtSession.SessionOptions().apply {
-            setMemoryPatternOptimization(true)
-            addConfigEntry("session.use_device_memory_mapping", "1")
-            addConfigEntry("session.enable_stream_execution", "1")
-        }
+        val env = OnnxSessions.environment
 
         // Loading and Resizing Image
         val (origImg, imSize, hazyImg) = loadAndResize(bitmap, Size(256.0, 256.0))
         //val (origImg, imSize, hazyImg) = loadAndResizeFromAssets(Size(512.0, 512.0))
         ProgressManager.getInstance().nextTask()
 
-        // Loading Albedo Image
-        val ortSessionAlbedo = loadModelFromAssets(env, sessionOptions, "model/albedo_model.onnx")
+        // The models come from OnnxSessions, usually already loaded by its warm-up
         ProgressManager.getInstance().nextTask()
 
         // Preprocessing Image
@@ -134,50 +114,40 @@ class SynthDehaze(private val context: Context) {
 
         // Running Albedo Model
         val albedoOutput = hazyInput.use { input ->
-            ortSessionAlbedo.run(mapOf("input.1" to input)).use { results ->
-                (results.get(0) as OnnxTensor).use { tensor ->
-                    FloatArray(tensor.floatBuffer.remaining()).also { tensor.floatBuffer.get(it) }
+            OnnxSessions.withSession(context, MODEL_ALBEDO) { session ->
+                session.run(mapOf("input.1" to input)).use { results ->
+                    (results.get(0) as OnnxTensor).use { tensor ->
+                        FloatArray(tensor.floatBuffer.remaining()).also { tensor.floatBuffer.get(it) }
+                    }
                 }
             }
         }
         ProgressManager.getInstance().nextTask()
 
-        // Close the session
-        ortSessionAlbedo.close()
-
         Log.d("dehaze", "Albedo output computed successfully")
 
-        // Loading Transmission Model
-        val ortSessionTransmission = loadModelFromAssets(env, sessionOptions, "model/transmission_model.onnx")
         ProgressManager.getInstance().nextTask()
 
         val transmissionInput = OnnxTensor.createTensor(env, FloatBuffer.wrap(albedoOutput), longArrayOf(1, 3, 256, 256))
 
         // Running Transmission Model
         val transmissionOutput = transmissionInput.use { input ->
-            ortSessionTransmission.run(mapOf("input.1" to input)).use { results ->
-                (results.get(0) as OnnxTensor).use { tensor ->
-                    FloatArray(tensor.floatBuffer.remaining()).also { tensor.floatBuffer.get(it) }
+            OnnxSessions.withSession(context, MODEL_TRANSMISSION) { session ->
+                session.run(mapOf("input.1" to input)).use { results ->
+                    (results.get(0) as OnnxTensor).use { tensor ->
+                        FloatArray(tensor.floatBuffer.remaining()).also { tensor.floatBuffer.get(it) }
+                    }
                 }
             }
         }
         ProgressManager.getInstance().nextTask()
 
-        // Close the session
-        ortSessionTransmission.close()
         val size = 256
-        val reshapedTransmission = Array(size) { FloatArray(size) }
-        for (h in 0 until size) {
-            for (w in 0 until size) {
-                reshapedTransmission[h][w] = transmissionOutput[h * size + w]
-            }
-        }
         val transmissionMat = Mat(size, size, CvType.CV_32F)
-        for (h in 0 until size) {
-            for (w in 0 until size) {
-                transmissionMat.put(h, w, floatArrayOf(reshapedTransmission[h][w] * 0.5f + 0.5f))  // Wrap the value in a FloatArray
-            }
-        }
+        TensorPack.unpack(
+            FloatBuffer.wrap(transmissionOutput), size, size, 0, 0, transmissionMat,
+            scale = 0.5, bias = 0.5, clamp = false
+        )
         val TResized = Mat()
         Imgproc.resize(transmissionMat, TResized, imSize, 0.0, 0.0, Imgproc.INTER_CUBIC)
         TResized.convertTo(TResized, CvType.CV_32F)
@@ -196,24 +166,19 @@ class SynthDehaze(private val context: Context) {
         hazyResized.release()
         ProgressManager.getInstance().nextTask()
 
-        Log.d(TAG, "Loading Airlight Model")
-        // Loading Airlight Model
-        val ortSessionAirlight = loadModelFromAssets(env, sessionOptions, "model/airlight_model.onnx")
-        sessionOptions.close()
         ProgressManager.getInstance().nextTask()
 
         Log.d(TAG, "Running Airlight Model")
         // Running Airlight Model
         val airlightOutput = airlightInput.use { input ->
-            ortSessionAirlight.run(mapOf("input.1" to input)).use { results ->
-                (results.get(0) as OnnxTensor).floatBuffer.array()
+            OnnxSessions.withSession(context, MODEL_AIRLIGHT) { session ->
+                session.run(mapOf("input.1" to input)).use { results ->
+                    (results.get(0) as OnnxTensor).floatBuffer.array()
+                }
             }
         }
         ProgressManager.getInstance().nextTask()
 
-        // Close the session
-        ortSessionAirlight.close()
-
         Log.d("dehaze", "Airlight output computed successfully")
 
         val airlightRed = airlightOutput[0]
@@ -1,36 +1,36 @@
 package com.wangGang.eagleEye.processing.denoise
 
-import ai.onnxruntime.OnnxTensor
-import ai.onnxruntime.OrtEnvironment
 import ai.onnxruntime.OrtSession
 import android.content.Context
 import android.graphics.Bitmap
 import android.util.Log
+import com.wangGang.eagleEye.constants.ParameterConfig
 import com.wangGang.eagleEye.processing.imagetools.ImageOperator.bitmapToMat
+import com.wangGang.eagleEye.processing.imagetools.OnnxSessions
+import com.wangGang.eagleEye.processing.imagetools.TensorPack
+import com.wangGang.eagleEye.processing.imagetools.TileBlender
+import com.wangGang.eagleEye.processing.imagetools.TiledInference
 import com.wangGang.eagleEye.ui.utils.ProgressManager
 import org.opencv.android.Utils
 import org.opencv.core.Core
 import org.opencv.core.CvType
 import org.opencv.core.Mat
 import org.opencv.core.MatOfByte
-import org.opencv.core.Scalar
+import org.opencv.core.Rect
 import org.opencv.imgcodecs.Imgcodecs
 import org.opencv.imgproc.Imgproc
 import java.io.InputStream
-import java.nio.FloatBuffer
 
 class AKDT(private val context: Context) {
-    private val ortEnvironment by lazy { OrtEnvironment.getEnvironment() }
-    private val ortSessionOptions by lazy {
-        OrtSession.SessionOptions().apply {
-            setMemoryPatternOptimization(true)
-            addConfigEntry("session.use_device_memory_mapping", "1")
-            addConfigEntry("session.enable_stream_execution", "1")
-        }
-    }
+    companion object {
+        const val MODEL_PATH = "model/akdt.onnx"
+
+        private const val PATCH_SIZE = 512
+        // Patches overlap by this much and are feathered into each other, see TileBlender.
+        private const val HALO = 8
 
-    fun release() {
-        ortEnvironment.close()
+        // Patches per inference run if the model's batch dimension is dynamic, see TiledInference.
+        private const val DEFAULT_BATCH_SIZE = 2
     }
 
     private fun loadFromAssets(): Mat {
@@ -61,25 +61,9 @@ class AKDT(private val context: Context) {
         }
     }
 
-    private fun loadModelFromAssets(modelPath: String): OrtSession {
-        return context.assets.open(modelPath).use { inputStream ->
-            val modelBytes = inputStream.readBytes()
-            ortEnvironment.createSession(modelBytes, ortSessionOptions)
-        }
-    }
-
     fun denoiseImage(bitmap: Bitmap): Bitmap {
-        val patchWithOverlap = 512
-        val overlap = 28
-        val validPatchSize = 512 - overlap * 2
-
-        var mat: Mat = Mat()
-        var imagePadded: Mat? = null
+        var mat = Mat()
         var outputImage: Mat? = null
-        var denoiseSession: OrtSession? = null
-        var finalOutputImage: Mat? = null
-        var outputBgr: Mat? = null
-        var outputBitmap: Bitmap? = null
 
         try {
             Utils.bitmapToMat(bitmap, mat)
@@ -89,150 +73,19 @@ class AKDT(private val context: Context) {
                 mat.release()
                 mat = tmp
             }
-            
-            mat.convertTo(mat, CvType.CV_32F, 1.0 / 255.0)
-
-            val h = mat.rows()
-            val w = mat.cols()
-            // val c = mat.channels()
-
-            val padH = (validPatchSize - (h % validPatchSize)) % validPatchSize
-            val padW = (validPatchSize - (w % validPatchSize)) % validPatchSize
-
-            imagePadded = Mat()
-            Core.copyMakeBorder(
-                mat, imagePadded, overlap, padH + overlap, overlap, padW + overlap,
-                Core.BORDER_REFLECT
-            )
-            mat.release()
-
-            val paddedH = imagePadded.rows()
-            val paddedW = imagePadded.cols()
-            outputImage = Mat.zeros(imagePadded.size(), imagePadded.type())
 
             ProgressManager.getInstance().nextTask()
 
-            denoiseSession = loadModelFromAssets("model/akdt.onnx")
-            val inputName = denoiseSession.inputNames.iterator().next()
-            // val outputName = denoiseSession.outputNames.iterator().next()
-
-            val totalPatches = ((paddedH - 2 * overlap) / validPatchSize) * ((paddedW - 2 * overlap) / validPatchSize)
-            var patchCount = 0
-
-            ProgressManager.getInstance().nextTask()
-            Log.d("AKDT", "denoiseImage - Denoising Image")
-
-            for (i in overlap until paddedH - overlap step validPatchSize) {
-                for (j in overlap until paddedW - overlap step validPatchSize) {
-                    patchCount++
-                    val progress = (patchCount.toDouble() / totalPatches * 100).toInt()
-                    if (patchCount % 5 == 0 || patchCount == totalPatches) {
-                        Log.d("DenoiseImage", "Processing patch $patchCount of $totalPatches ($progress%)")
-                    }
-
-                    var iStart = i - overlap
-                    var jStart = j - overlap
-
-                    var iEnd = (iStart + patchWithOverlap).coerceAtMost(paddedH)
-                    var jEnd = (jStart + patchWithOverlap).coerceAtMost(paddedW)
-
-                    if (iEnd - iStart < patchWithOverlap) {
-                        iStart = iEnd - patchWithOverlap
-                    }
-                    if (jEnd - jStart < patchWithOverlap) {
-                        jStart = jEnd - patchWithOverlap
-                    }
+            outputImage = OnnxSessions.withSession(context, MODEL_PATH) { session ->
+                ProgressManager.getInstance().nextTask()
+                Log.d("AKDT", "denoiseImage - Denoising Image")
 
-                    val patch = imagePadded.submat(iStart, iEnd, jStart, jEnd)
-
-                    val inputShape = longArrayOf(1, patch.channels().toLong(), patch.rows().toLong(), patch.cols().toLong())
-                    val patchData = FloatArray(patch.rows() * patch.cols() * patch.channels())
-                    patch.get(0, 0, patchData)
-
-                    val chwData = FloatArray(patch.channels() * patch.rows() * patch.cols())
-                    val channels = patch.channels()
-                    val rows = patch.rows()
-                    val cols = patch.cols()
-
-                    for (r in 0 until rows) {
-                        for (cl in 0 until cols) {
-                            for (ch in 0 until channels) {
-                                chwData[ch * rows * cols + r * cols + cl] =
-                                    patchData[r * cols * channels + cl * channels + ch]
-                            }
-                        }
-                    }
-
-                    var inputTensor: OnnxTensor? = null
-                    var results: OrtSession.Result? = null
-                    var outputOnnxTensor: OnnxTensor? = null
-                    var outputMat: Mat? = null
-                    var destSubmat: Mat? = null
-                    var srcSubmat: Mat? = null
-
-                    try {
-                        inputTensor = OnnxTensor.createTensor(ortEnvironment, FloatBuffer.wrap(chwData), inputShape)
-                        results = denoiseSession.run(mapOf(inputName to inputTensor))
-                        outputOnnxTensor = results.get(0) as OnnxTensor
-                        val outputFloatBuffer = outputOnnxTensor.floatBuffer
-                        val outputShape = outputOnnxTensor.info.shape
-
-                        val outChannels = outputShape[1].toInt()
-                        val outH = outputShape[2].toInt()
-                        val outW = outputShape[3].toInt()
-
-                        val outputHwc = FloatArray(outChannels * outH * outW)
-
-                        for (ch in 0 until outChannels) {
-                            for (r in 0 until outH) {
-                                for (cl in 0 until outW) {
-                                    outputHwc[r * outW * outChannels + cl * outChannels + ch] =
-                                        outputFloatBuffer.get(ch * outH * outW + r * outW + cl)
-                                }
-                            }
-                        }
-
-                        outputMat = Mat(outH, outW, CvType.CV_32FC3)
-                        outputMat.put(0, 0, outputHwc)
-
-                        Core.max(outputMat, Scalar(0.0, 0.0, 0.0), outputMat)
-                        Core.min(outputMat, Scalar(1.0, 1.0, 1.0), outputMat)
-
-                        val destRoiRowsStart = i
-                        val destRoiRowsEnd = (i + validPatchSize).coerceAtMost(paddedH - overlap)
-                        val destRoiColsStart = j
-                        val destRoiColsEnd = (j + validPatchSize).coerceAtMost(paddedW - overlap)
-
-                        val srcRoiRowsStart = overlap
-                        val srcRoiRowsEnd = overlap + (destRoiRowsEnd - destRoiRowsStart)
-                        val srcRoiColsStart = overlap
-                        val srcRoiColsEnd = overlap + (destRoiColsEnd - destRoiColsStart)
-
-                        destSubmat = outputImage.submat(destRoiRowsStart, destRoiRowsEnd, destRoiColsStart, destRoiColsEnd)
-                        srcSubmat = outputMat.submat(srcRoiRowsStart, srcRoiRowsEnd, srcRoiColsStart, srcRoiColsEnd)
-
-                        srcSubmat.copyTo(destSubmat)
-
-                    } finally {
-                        inputTensor?.close()
-                        outputOnnxTensor?.close()
-                        results?.close()
-                        outputMat?.release()
-                        destSubmat?.release()
-                        srcSubmat?.release()
-                    }
-                }
+                denoisePatches(session, mat)
             }
+//            Imgproc.cvtColor(outputImage, outputImage, Imgproc.COLOR_RGB2BGR)
 
-            finalOutputImage = outputImage.submat(overlap, h + overlap, overlap, w + overlap)
-            outputImage.release()
-
-            outputBgr = Mat()
-            finalOutputImage.convertTo(outputBgr, CvType.CV_8U, 255.0)
-//            Imgproc.cvtColor(outputBgr, outputBgr, Imgproc.COLOR_RGB2BGR)
-
-            outputBitmap = Bitmap.createBitmap(outputBgr.cols(), outputBgr.rows(), Bitmap.Config.ARGB_8888)
-            Utils.matToBitmap(outputBgr, outputBitmap)
+            val outputBitmap = Bitmap.createBitmap(outputImage.cols(), outputImage.rows(), Bitmap.Config.ARGB_8888)
+            Utils.matToBitmap(outputImage, outputBitmap)
 
             Log.d("AKDT", "Denoising completed successfully")
             Log.d("AKDT", "Output image size: ${outputBitmap.width}x${outputBitmap.height}")
@@ -242,167 +95,22 @@ class AKDT(private val context: Context) {
             return outputBitmap
 
         } finally {
-            mat?.release()
-            imagePadded?.release()
+            mat.release()
             outputImage?.release()
-            denoiseSession?.close()
-            finalOutputImage?.release()
-            outputBgr?.release()
         }
     }
 
     fun denoiseImageTest(bitmap: Bitmap, filename: String): Bitmap {
-        val patchWithOverlap = 512
-        val overlap = 28
-        val validPatchSize = 512 - overlap * 2
-
         var mat: Mat? = null
-        var imagePadded: Mat? = null
         var outputImage: Mat? = null
-        var denoiseSession: OrtSession? = null
-        var finalOutputImage: Mat? = null
-        var outputBgr: Mat? = null
-        var outputBitmap: Bitmap? = null
 
         try {
-            mat = loadAndResizeFromAssetsTest(filename)
-            mat.convertTo(mat, CvType.CV_32F, 1.0 / 255.0)
-
-            val h = mat.rows()
-            val w = mat.cols()
-            // val c = mat.channels()
-
-            val padH = (validPatchSize - (h % validPatchSize)) % validPatchSize
-            val padW = (validPatchSize - (w % validPatchSize)) % validPatchSize
-
-            imagePadded = Mat()
-            Core.copyMakeBorder(
-                mat, imagePadded, overlap, padH + overlap, overlap, padW + overlap,
-                Core.BORDER_REFLECT
-            )
-            mat.release()
-
-            val paddedH = imagePadded.rows()
-            val paddedW = imagePadded.cols()
-            outputImage = Mat.zeros(imagePadded.size(), imagePadded.type())
-
-            denoiseSession = loadModelFromAssets("model/akdt.onnx")
-            val inputName = denoiseSession.inputNames.iterator().next()
-            // val outputName = denoiseSession.outputNames.iterator().next()
-
-            val totalPatches = ((paddedH - 2 * overlap) / validPatchSize) * ((paddedW - 2 * overlap) / validPatchSize)
-            var patchCount = 0
-
-            for (i in overlap until paddedH - overlap step validPatchSize) {
-                for (j in overlap until paddedW - overlap step validPatchSize) {
-                    patchCount++
-                    val progress = (patchCount.toDouble() / totalPatches * 100).toInt()
-                    if (patchCount % 5 == 0 || patchCount == totalPatches) {
-                        Log.d("DenoiseImage", "Processing patch $patchCount of $totalPatches ($progress%)")
-                    }
-
-                    var iStart = i - overlap
-                    var jStart = j - overlap
-
-                    var iEnd = (iStart + patchWithOverlap).coerceAtMost(paddedH)
-                    var jEnd = (jStart + patchWithOverlap).coerceAtMost(paddedW)
-
-                    if (iEnd - iStart < patchWithOverlap) {
-                        iStart = iEnd - patchWithOverlap
-                    }
-                    if (jEnd - jStart < patchWithOverlap) {
-                        jStart = jEnd - patchWithOverlap
-                    }
-
-                    val patch = imagePadded.submat(iStart, iEnd, jStart, jEnd)
-
-                    val inputShape = longArrayOf(1, patch.channels().toLong(), patch.rows().toLong(), patch.cols().toLong())
-                    val patchData = FloatArray(patch.rows() * patch.cols() * patch.channels())
-                    patch.get(0, 0, patchData)
-
-                    val chwData = FloatArray(patch.channels() * patch.rows() * patch.cols())
-                    val channels = patch.channels()
-                    val rows = patch.rows()
-                    val cols = patch.cols()
-
-                    for (r in 0 until rows) {
-                        for (cl in 0 until cols) {
-                            for (ch in 0 until channels) {
-                                chwData[ch * rows * cols + r * cols + cl] =
-                                    patchData[r * cols * channels + cl * channels + ch]
-                            }
-                        }
-                    }
-
-                    var inputTensor: OnnxTensor? = null
-                    var results: OrtSession.Result? = null
-                    var outputOnnxTensor: OnnxTensor? = null
-                    var outputMat: Mat? = null
-                    var destSubmat: Mat? = null
-                    var srcSubmat: Mat? = null
-
-                    try {
-                        inputTensor = OnnxTensor.createTensor(ortEnvironment, FloatBuffer.wrap(chwData), inputShape)
-                        results = denoiseSession.run(mapOf(inputName to inputTensor))
-                        outputOnnxTensor = results.get(0) as OnnxTensor
-                        val outputFloatBuffer = outputOnnxTensor.floatBuffer
-                        val outputShape = outputOnnxTensor.info.shape
-
-                        val outChannels = outputShape[1].toInt()
-                        val outH = outputShape[2].toInt()
-                        val outW = outputShape[3].toInt()
+            val input = loadAndResizeFromAssetsTest(filename)
+            mat = input
+            outputImage = OnnxSessions.withSession(context, MODEL_PATH) { session -> denoisePatches(session, input) }
 
-                        val outputHwc = FloatArray(outChannels * outH * outW)
-
-                        for (ch in 0 until outChannels) {
-                            for (r in 0 until outH) {
-                                for (cl in 0 until outW) {
-                                    outputHwc[r * outW * outChannels + cl * outChannels + ch] =
-                                        outputFloatBuffer.get(ch * outH * outW + r * outW + cl)
-                                }
-                            }
-                        }
-
-                        outputMat = Mat(outH, outW, CvType.CV_32FC3)
-                        outputMat.put(0, 0, outputHwc)
-
-                        Core.max(outputMat, Scalar(0.0, 0.0, 0.0), outputMat)
-                        Core.min(outputMat, Scalar(1.0, 1.0, 1.0), outputMat)
-
-                        val destRoiRowsStart = i
-                        val destRoiRowsEnd = (i + validPatchSize).coerceAtMost(paddedH - overlap)
-                        val destRoiColsStart = j
-                        val destRoiColsEnd = (j + validPatchSize).coerceAtMost(paddedW - overlap)
-
-                        val srcRoiRowsStart = overlap
-                        val srcRoiRowsEnd = overlap + (destRoiRowsEnd - destRoiRowsStart)
-                        val srcRoiColsStart = overlap
-                        val srcRoiColsEnd = overlap + (destRoiColsEnd - destRoiColsStart)
-
-                        destSubmat = outputImage.submat(destRoiRowsStart, destRoiRowsEnd, destRoiColsStart, destRoiColsEnd)
-                        srcSubmat = outputMat.submat(srcRoiRowsStart, srcRoiRowsEnd, srcRoiColsStart, srcRoiColsEnd)
-
-                        srcSubmat.copyTo(destSubmat)
-
-                    } finally {
-                        inputTensor?.close()
-                        outputOnnxTensor?.close()
-                        results?.close()
-                        outputMat?.release()
-                        destSubmat?.release()
-                        srcSubmat?.release()
-                    }
-                }
-            }
-
-            finalOutputImage = outputImage.submat(overlap, h + overlap, overlap, w + overlap)
-            outputImage.release()
-
-            outputBgr = Mat()
-            finalOutputImage.convertTo(outputBgr, CvType.CV_8U, 255.0)
-
-            outputBitmap = Bitmap.createBitmap(outputBgr.cols(), outputBgr.rows(), Bitmap.Config.ARGB_8888)
-            Utils.matToBitmap(outputBgr, outputBitmap)
+            val outputBitmap = Bitmap.createBitmap(outputImage.cols(), outputImage.rows(), Bitmap.Config.ARGB_8888)
+            Utils.matToBitmap(outputImage, outputBitmap)
 
             Log.d("AKDT", "Denoising completed successfully")
             Log.d("AKDT", "Output image size: ${outputBitmap.width}x${outputBitmap.height}")
@@ -410,14 +118,48 @@ class AKDT(private val context: Context) {
 
         } finally {
             mat?.release()
-            imagePadded?.release()
             outputImage?.release()
-            denoiseSession?.close()
-            finalOutputImage?.release()
-            outputBgr?.release()
         }
     }
 
+    /*
+     * Runs the model over an 8-bit RGB image in 512 patches that overlap by HALO pixels and returns the 8-bit
+     * result. Each patch is packed straight from the image into the input buffer, the reflect padding around the
+     * image included, and the outputs are feathered into each other by TileBlender, which writes the result rows
+     * as they are done. TiledInference packs the next batch of patches and blends the previous one while a batch
+     * is in inference.
+     */
+    private fun denoisePatches(session: OrtSession, image: Mat): Mat {
+        val channels = image.channels()
+        val xs = TileBlender.origins(image.cols(), PATCH_SIZE, HALO)
+        val ys = TileBlender.origins(image.rows(), PATCH_SIZE, HALO)
+        // Raster order, as TileBlender needs.
+        val tiles = ys.flatMap { y -> xs.map { x -> x to y } }
+
+        val output = Mat(image.rows(), image.cols(), CvType.CV_8UC(channels))
+        val batchSize = ParameterConfig.getPrefsInt(ParameterConfig.DENOISE_BATCH_SIZE_KEY, DEFAULT_BATCH_SIZE)
+        val engine = TiledInference(session, channels, channels, PATCH_SIZE, batchSize)
+        Log.d("DenoiseImage", "Denoising ${tiles.size} patches, ${engine.batchSize} per run")
+
+        try {
+            TileBlender().use { blender ->
+                blender.begin(output, PATCH_SIZE, HALO)
+                engine.run(
+                    tiles,
+                    pack = { (x, y), buffer, offset ->
+                        TensorPack.pack(image, Rect(x, y, PATCH_SIZE, PATCH_SIZE), buffer, offset)
+                    },
+                    write = { (x, y), buffer, offset -> blender.add(buffer, offset, x, y) }
+                )
+                blender.finish()
+            }
+        } catch (e: Exception) {
+            output.release()
+            throw e
+        }
+        return output
+    }
+
     private fun loadAndResizeFromAssetsTest(filename: String): Mat {
         var img: Mat? = null
         try {
@@ -3,15 +3,24 @@ package com.wangGang.eagleEye.processing.filters
 
 import com.wangGang.eagleEye.processing.multiple.fusion.YangFilterFusionOperator
 import org.opencv.core.Core
+import org.opencv.core.CvType
 import org.opencv.core.Mat
 import org.opencv.imgproc.Imgproc
 import org.opencv.utils.Converters
 
 /**
  * Implements the yang filter edge features on a set of images
+ * 8-bit single channel inputs (the energy images) go through a fused native kernel that computes the four
+ * responses and their masked mean in one pass, for all images in parallel. Other inputs use the OpenCV path.
  * Created by NeilDG on 7/17/2016.
  */
 class YangFilter(private val inputMatList: Array<Mat>)  {
+    companion object {
+        init {
+            System.loadLibrary("eagleEye")
+        }
+    }
+
     private val f1Kernel: Mat
     private val f2Kernel: Mat
     private val f3Kernel: Mat
@@ -36,6 +45,13 @@ class YangFilter(private val inputMatList: Array<Mat>)  {
     fun perform() {
         edgeMatList = Array(inputMatList.size) { Mat() }
 
+        if (inputMatList.all { it.type() == CvType.CV_8UC1 } && yangFilterNative(
+                LongArray(inputMatList.size) { inputMatList[it].nativeObj },
+                LongArray(edgeMatList.size) { edgeMatList[it].nativeObj })
+        ) {
+            return
+        }
+
         for (i in inputMatList.indices) {
             val inputf1 = Mat()
             val inputf2 = Mat()
@@ -75,4 +91,6 @@ class YangFilter(private val inputMatList: Array<Mat>)  {
     fun getEdgeMatList(): Array<Mat> {
         return edgeMatList
     }
+
+    private external fun yangFilterNative(inputAddrs: LongArray, outputAddrs: LongArray): Boolean
 }
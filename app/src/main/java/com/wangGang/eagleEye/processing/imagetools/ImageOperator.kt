@@ -26,6 +26,15 @@ object ImageOperator {
     }
     private const val TAG = "ImageOperator"
 
+    // The in-memory merge needs the output Mat plus the Bitmap written by matToBitmap.
+    private const val IN_MEMORY_MERGE_HEADROOM = 2
+
+    // Rotations applied by bitmapToMat / matToBitmap. The values are shared with core/ColorRotate.h.
+    const val ROTATION_NONE = 0
+    const val ROTATION_CLOCKWISE_90 = 1
+    const val ROTATION_180 = 2
+    const val ROTATION_COUNTERCLOCKWISE_90 = 3
+
     external fun mergeQuadrants(
         filenames: Array<String>,  // or List<String> if you prefer using a list
         divisionFactor: Int,
@@ -43,6 +52,46 @@ object ImageOperator {
         outputFile: String,
         outputFile1: String
     )
+
+    /*
+     * Resizes each quadrant of the source mat directly into its region of the preallocated destination mat.
+     * Returns false if the destination does not match the scaled size and type of the source.
+     */
+    external fun upscaleAndMerge(
+        srcMatAddr: Long,
+        dstMatAddr: Long,
+        divisionFactor: Int,
+        scaling: Float
+    ): Boolean
+
+    /*
+     * Available system memory in bytes as reported by the kernel, or -1 if unknown.
+     */
+    external fun availableNativeMemory(): Long
+
+    /*
+     * Converts an ARGB_8888 bitmap to a BGR mat and applies the rotation in one pass over the locked bitmap pixels.
+     * Returns false if the bitmap could not be locked or is not ARGB_8888.
+     */
+    private external fun bitmapToMatNative(bitmap: Bitmap, dstMatAddr: Long, rotation: Int): Boolean
+
+    /*
+     * Converts a BGR (or gray / BGRA) mat to RGBA and applies the rotation, writing straight into the locked pixels
+     * of the given ARGB_8888 bitmap. The bitmap must already have the rotated size.
+     */
+    private external fun matToBitmapNative(srcMatAddr: Long, bitmap: Bitmap, rotation: Int): Boolean
+
+    /*
+     * Scatter loops of performZeroFill / copyMat over the whole mat, instead of one get and one put per pixel.
+     */
+    private external fun zeroFillNative(lrMatAddr: Long, hrMatAddr: Long, scale: Int, xOffset: Int, yOffset: Int): Boolean
+    private external fun zeroFillDisplacedNative(
+        lrMatAddr: Long,
+        hrMatAddr: Long,
+        scale: Int,
+        xDisplacementAddr: Long,
+        yDisplacementAddr: Long
+    ): Boolean
     /*
      * Adds random noise. Returns the same mat with the noise operator applied.
      */
@@ -227,20 +276,10 @@ object ImageOperator {
      */
     fun performZeroFill(fromMat: Mat, scaling: Int, xOffset: Int, yOffset: Int): Mat {
         val hrMat = Mat.zeros(fromMat.rows() * scaling, fromMat.cols() * scaling, fromMat.type())
-
-        for (row in 0 until fromMat.rows()) {
-            for (col in 0 until fromMat.cols()) {
-                val lrPixelData = fromMat[row, col]
-
-                val resultRow = (row * scaling) + yOffset
-                val resultCol = (col * scaling) + xOffset
-
-                if (resultRow < hrMat.rows() && resultCol < hrMat.cols()) {
-                    hrMat.put(resultRow, resultCol, *lrPixelData)
-                }
-            }
+        if (!zeroFillNative(fromMat.nativeObj, hrMat.nativeObj, scaling, xOffset, yOffset)) {
+            hrMat.release()
+            throw IllegalStateException("Zero-fill of ${fromMat.cols()} x ${fromMat.rows()} by $scaling failed")
         }
-
         return hrMat
     }
 
@@ -249,24 +288,11 @@ object ImageOperator {
      */
     fun performZeroFill(fromMat: Mat, scaling: Int, xDisplacement: Mat, yDisplacement: Mat): Mat {
         val hrMat = Mat.zeros(fromMat.rows() * scaling, fromMat.cols() * scaling, fromMat.type())
-
-        for (row in 0 until fromMat.rows()) {
-            for (col in 0 until fromMat.cols()) {
-                val lrPixelData = fromMat[row, col]
-
-                val xOffset = xDisplacement[row, col][0]
-                val yOffset = yDisplacement[row, col][0]
-
-                val floorRow = Math.round(yOffset).toInt() * scaling
-                val floorCol = Math.round(xOffset).toInt() * scaling
-
-                if (floorRow < hrMat.rows() && floorCol < hrMat.cols()) {
-                    //Log.d(TAG, "Debug values. xOffset: " +xOffset+ " yOffset: " +yOffset+ " X: " +floorCol+ " Y: " +floorRow);
-                    hrMat.put(floorRow, floorCol, *lrPixelData)
-                }
-            }
+        if (!zeroFillDisplacedNative(
+                fromMat.nativeObj, hrMat.nativeObj, scaling, xDisplacement.nativeObj, yDisplacement.nativeObj)) {
+            hrMat.release()
+            throw IllegalStateException("Displaced zero-fill of ${fromMat.cols()} x ${fromMat.rows()} failed")
         }
-
         return hrMat
     }
 
@@ -274,17 +300,8 @@ object ImageOperator {
      * Copies the rows of a given mat to the hr mat by zero-filling.
      */
     fun copyMat(fromMat: Mat, hrMat: Mat, scaling: Int, xOffset: Int, yOffset: Int) {
-        for (row in 0 until fromMat.rows()) {
-            for (col in 0 until fromMat.cols()) {
-                val lrPixelData = fromMat[row, col]
-
-                val resultRow = (row * scaling) + yOffset
-                val resultCol = (col * scaling) + xOffset
-
-                if (resultRow < hrMat.rows() && resultCol < hrMat.cols()) {
-                    hrMat.put(resultRow, resultCol, *lrPixelData)
-                }
-            }
+        check(zeroFillNative(fromMat.nativeObj, hrMat.nativeObj, scaling, xOffset, yOffset)) {
+            "Zero-fill copy of ${fromMat.cols()} x ${fromMat.rows()} by $scaling failed"
         }
     }
 
@@ -338,26 +355,80 @@ object ImageOperator {
         return hrMat
     }
 
-    fun bitmapToMat(bitmap: Bitmap): Mat {
+    /*
+     * Converts a bitmap to a BGR mat, optionally rotated. ARGB_8888 bitmaps are read in place without copies,
+     * other configs go through an ARGB_8888 copy first.
+     */
+    fun bitmapToMat(bitmap: Bitmap, rotation: Int = ROTATION_NONE): Mat {
         val mat = Mat()
+        if (bitmap.config == Bitmap.Config.ARGB_8888 &&
+            bitmapToMatNative(bitmap, mat.nativeObj, rotation)) {
+            return mat
+        }
+
         val bmp32 = bitmap.copy(Bitmap.Config.ARGB_8888, true) // Ensure it's in ARGB_8888 format
         Utils.bitmapToMat(bmp32, mat)
-        Imgproc.cvtColor(mat, mat, Imgproc.COLOR_RGB2BGR)
+        Imgproc.cvtColor(mat, mat, Imgproc.COLOR_RGBA2BGR)
+        rotate(mat, rotation)
         return mat
     }
 
+    /*
+     * Converts a BGR mat to a bitmap rotated 90 degrees counterclockwise. The conversion and rotation are written
+     * directly into the bitmap pixels; the mat itself is left untouched.
+     */
     fun matToBitmap(mat: Mat): Bitmap {
+        val bitmap = Bitmap.createBitmap(mat.rows(), mat.cols(), Bitmap.Config.ARGB_8888)
+        if (matToBitmapNative(mat.nativeObj, bitmap, ROTATION_COUNTERCLOCKWISE_90)) {
+            return bitmap
+        }
+
+        Log.w(TAG, "Native matToBitmap failed, using OpenCV Utils.")
         val newMat = Mat()
         mat.copyTo(newMat)
         Core.rotate(newMat, newMat, Core.ROTATE_90_COUNTERCLOCKWISE)
         Imgproc.cvtColor(newMat, newMat, Imgproc.COLOR_BGR2RGB)
-        val bitmap = Bitmap.createBitmap(newMat.cols(), newMat.rows(), Bitmap.Config.ARGB_8888)
         Utils.matToBitmap(newMat, bitmap)
+        newMat.release()
         return bitmap
     }
 
+    private fun rotate(mat: Mat, rotation: Int) {
+        when (rotation) {
+            ROTATION_CLOCKWISE_90 -> Core.rotate(mat, mat, Core.ROTATE_90_CLOCKWISE)
+            ROTATION_180 -> Core.rotate(mat, mat, Core.ROTATE_180)
+            ROTATION_COUNTERCLOCKWISE_90 -> Core.rotate(mat, mat, Core.ROTATE_90_COUNTERCLOCKWISE)
+        }
+    }
+
 
+    /*
+     * Upscales the mat quadrant by quadrant and merges the result in memory. Falls back to the file based
+     * quadrant merge when there is not enough memory to hold the upscaled image.
+     */
     fun performJNIInterpolationWithMerge(fromMat: Mat, scaling: Float): Bitmap {
+        val divisionFactor = 4
+        val newRows = Math.round(fromMat.rows() * scaling)
+        val newCols = Math.round(fromMat.cols() * scaling)
+        val outputBytes = newRows.toLong() * newCols.toLong() * fromMat.elemSize()
+
+        if (availableNativeMemory() >= outputBytes * IN_MEMORY_MERGE_HEADROOM) {
+            val hrMat = Mat(newRows, newCols, fromMat.type())
+            if (upscaleAndMerge(fromMat.nativeObj, hrMat.nativeObj, divisionFactor, scaling)) {
+                fromMat.release()
+                val bitmap = matToBitmap(hrMat)
+                hrMat.release()
+                return bitmap
+            }
+            hrMat.release()
+            Log.w(TAG, "Native in-memory merge of $newCols x $newRows failed. Using file based merge.")
+        } else {
+            Log.w(TAG, "Not enough memory for in-memory merge of $newCols x $newRows. Using file based merge.")
+        }
+        return performFileInterpolationWithMerge(fromMat, scaling)
+    }
+
+    private fun performFileInterpolationWithMerge(fromMat: Mat, scaling: Float): Bitmap {
         val divisionFactor = 4
         val width = fromMat.cols()
         val height = fromMat.rows()
@@ -0,0 +1,67 @@
+package com.wangGang.eagleEye.processing.imagetools
+
+/**
+ * Native pooled allocator for OpenCV Mats. While a session is open every Mat buffer (native stages as well as
+ * Mats created from Kotlin) is taken from per size class free lists and returned to them on release, instead of
+ * going back to the system allocator. The cached buffers are freed when the outermost session ends.
+ */
+object MatPool {
+    init {
+        System.loadLibrary("eagleEye")
+    }
+
+    // Cached buffers are capped at this, or at a quarter of the available memory if that is lower.
+    private const val MAX_CACHE_BYTES = 256L * 1024 * 1024
+
+    data class Stats(
+        val hits: Long,
+        val misses: Long,
+        val bytesInUse: Long,
+        val highWaterBytes: Long,
+        val bytesCached: Long
+    ) {
+        val hitRate: Float
+            get() = if (hits + misses == 0L) 0f else hits.toFloat() / (hits + misses)
+    }
+
+    /*
+     * Runs block inside a pool session. Sessions nest; the statistics are reset when the outermost one begins.
+     */
+    inline fun <T> session(block: () -> T): T {
+        beginSession()
+        try {
+            return block()
+        } finally {
+            endSession()
+        }
+    }
+
+    fun beginSession() {
+        val available = ImageOperator.availableNativeMemory()
+        nativeSetCacheLimit(if (available > 0) minOf(MAX_CACHE_BYTES, available / 4) else MAX_CACHE_BYTES)
+        nativeBeginSession()
+    }
+
+    fun endSession() = nativeEndSession()
+
+    fun stats(): Stats {
+        val values = nativeStats()
+        return Stats(values[0], values[1], values[2], values[3], values[4])
+    }
+
+    /*
+     * Upper bound for the bytes kept in the free lists.
+     */
+    fun setCacheLimit(bytes: Long) = nativeSetCacheLimit(bytes)
+
+    /*
+     * Frees the cached buffers, e.g. on memory pressure. Live Mats are not affected.
+     */
+    fun trim() = nativeTrim()
+
+    private external fun nativeBeginSession()
+    private external fun nativeEndSession()
+    private external fun nativeSetCacheLimit(bytes: Long)
+    private external fun nativeTrim()
+    private external fun nativeStats(): LongArray
+}
@@ -0,0 +1,63 @@
+package com.wangGang.eagleEye.processing.imagetools
+
+import android.content.Context
+import android.util.Log
+import java.io.File
+
+/**
+ * Copies the ONNX model assets once into app-private storage, so sessions can be created from a file path instead
+ * of a ByteArray holding the whole model on the Java heap. ONNX Runtime then reads the model itself and can map
+ * external data files (model.onnx.data and the like, extracted alongside the model) instead of copying them.
+ *
+ * A copy is reused until the app is updated: its modification time is set to the package's lastUpdateTime.
+ * Models are stored uncompressed in the APK (see noCompress in build.gradle.kts), so extracting is a plain copy.
+ */
+object ModelStore {
+    private const val TAG = "ModelStore"
+    private const val DIRECTORY = "onnx_models"
+
+    /*
+     * The extracted file of the model asset, extracting it (and its external data) first if needed.
+     */
+    @Synchronized
+    fun modelFile(context: Context, assetPath: String): File {
+        val stamp = packageStamp(context)
+        val file = File(File(context.noBackupFilesDir, DIRECTORY), assetPath)
+        if (file.isFile && file.lastModified() == stamp) {
+            return file
+        }
+
+        val start = System.nanoTime()
+        val assetDir = assetPath.substringBeforeLast('/', "")
+        val name = assetPath.substringAfterLast('/')
+        val externalData = context.assets.list(assetDir).orEmpty().filter { it != name && it.startsWith("$name.") }
+        for (asset in externalData + name) {
+            extract(context, if (assetDir.isEmpty()) asset else "$assetDir/$asset", File(file.parentFile, asset), stamp)
+        }
+        Log.d(TAG, "Extracted $assetPath in ${(System.nanoTime() - start) / 1_000_000} ms")
+        return file
+    }
+
+    // The model itself is extracted last, so a model file with the current stamp implies its data is complete.
+    private fun extract(context: Context, assetPath: String, target: File, stamp: Long) {
+        target.parentFile?.mkdirs()
+        val temp = File(target.parentFile, "${target.name}.tmp")
+        try {
+            context.assets.open(assetPath).use { input ->
+                temp.outputStream().use { output -> input.copyTo(output, 1 shl 16) }
+            }
+            check(temp.renameTo(target)) { "Could not move $temp to $target" }
+            if (!target.setLastModified(stamp)) {
+                Log.w(TAG, "Could not stamp $target; it will be extracted again next time")
+            }
+        } finally {
+            temp.delete()
+        }
+    }
+
+    // Second precision, as some file systems keep no more than that for modification times.
+    private fun packageStamp(context: Context): Long {
+        val lastUpdate = context.packageManager.getPackageInfo(context.packageName, 0).lastUpdateTime
+        return lastUpdate / 1000 * 1000
+    }
+}
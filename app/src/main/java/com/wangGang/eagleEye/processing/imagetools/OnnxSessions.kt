@@ -0,0 +1,185 @@
+package com.wangGang.eagleEye.processing.imagetools
+
+import ai.onnxruntime.OrtEnvironment
+import ai.onnxruntime.OrtSession
+import android.content.Context
+import android.util.Log
+import com.wangGang.eagleEye.processing.commands.ProcessingCommand
+import java.util.concurrent.CancellationException
+import java.util.concurrent.ExecutionException
+import java.util.concurrent.Executors
+import java.util.concurrent.FutureTask
+import java.util.concurrent.atomic.AtomicBoolean
+
+/**
+ * App-wide registry of ONNX Runtime sessions, keyed by model asset and session options. Creating a session
+ * (reading the model, optimising the graph, allocating the weights) often costs more than running it, so sessions
+ * stay open between captures: the models of the commands in the processing order are loaded in the background
+ * by warmUp() and the enhancement stages borrow them with withSession().
+ *
+ * Sessions are closed by evict(), e.g. from onTrimMemory. A session that is in use when it is evicted is closed
+ * when its last user returns it.
+ */
+object OnnxSessions {
+    private const val TAG = "OnnxSessions"
+
+    val environment: OrtEnvironment by lazy { OrtEnvironment.getEnvironment() }
+
+    /*
+     * What a session is created with. Every model uses the defaults today.
+     */
+    data class Options(
+        val memoryPatternOptimization: Boolean = true,
+        val configEntries: Map<String, String> = mapOf(
+            "session.use_device_memory_mapping" to "1",
+            "session.enable_stream_execution" to "1"
+        )
+    ) {
+        fun toSessionOptions(): OrtSession.SessionOptions {
+            return OrtSession.SessionOptions().apply {
+                setMemoryPatternOptimization(memoryPatternOptimization)
+                configEntries.forEach { (key, value) -> addConfigEntry(key, value) }
+            }
+        }
+    }
+
+    private data class Key(val modelPath: String, val options: Options)
+
+    // claimed is taken by whichever comes first: the load starting, or evict() cancelling it before it starts.
+    private class Entry(val claimed: AtomicBoolean, val load: FutureTask<OrtSession>) {
+        var users = 0
+        var evicted = false
+    }
+
+    private val lock = Any()
+    private val entries = HashMap<Key, Entry>()
+
+    // Warm-up loads run one at a time, so they do not compete with each other for memory or cores.
+    private val loader = Executors.newSingleThreadExecutor { runnable ->
+        Thread(runnable, "onnx-warmup").apply { priority = Thread.MIN_PRIORITY }
+    }
+
+    /*
+     * Runs block with the session for the model, creating it on this thread if it is neither open nor being
+     * loaded in the background (in which case this waits for it).
+     */
+    fun <T> withSession(
+        context: Context,
+        modelPath: String,
+        options: Options = Options(),
+        block: (OrtSession) -> T
+    ): T {
+        val key = Key(modelPath, options)
+        val entry = synchronized(lock) {
+            entries.getOrPut(key) { newEntry(context.applicationContext, key) }.also { it.users++ }
+        }
+        try {
+            entry.load.run()  // no-op if it already ran or is running on the warm-up thread
+            val session = try {
+                entry.load.get()
+            } catch (e: ExecutionException) {
+                synchronized(lock) {
+                    if (entries[key] === entry) {
+                        entries.remove(key)  // the next caller tries again
+                    }
+                }
+                throw e.cause ?: e
+            }
+            return block(session)
+        } finally {
+            release(key, entry)
+        }
+    }
+
+    /*
+     * Starts loading, in the background, the models of the commands in the processing order, and closes idle
+     * sessions of models that no enabled command uses any more.
+     */
+    fun warmUp(context: Context, processingOrder: List<String>) {
+        val appContext = context.applicationContext
+        val models = processingOrder.mapNotNull { ProcessingCommand.fromDisplayName(it) }.flatMap { it.models }.toSet()
+        synchronized(lock) {
+            entries.keys.filter { it.modelPath !in models }.forEach { evictLocked(it) }
+            for (model in models) {
+                val key = Key(model, Options())
+                if (key !in entries) {
+                    val entry = newEntry(appContext, key)
+                    entries[key] = entry
+                    loader.execute {
+                        entry.load.run()
+                    }
+                }
+            }
+        }
+    }
+
+    /*
+     * Closes every session, or marks it to be closed once it is no longer in use.
+     */
+    fun evict() {
+        synchronized(lock) {
+            entries.keys.toList().forEach { evictLocked(it) }
+        }
+    }
+
+    private fun evictLocked(key: Key) {
+        val entry = entries.remove(key) ?: return
+        entry.evicted = true
+        if (entry.users == 0) {
+            closeWhenLoaded(key, entry)
+        }
+    }
+
+    private fun release(key: Key, entry: Entry) {
+        synchronized(lock) {
+            entry.users--
+            if (entry.evicted && entry.users == 0) {
+                closeWhenLoaded(key, entry)
+            }
+        }
+    }
+
+    /*
+     * An evicted entry may still be waiting for the warm-up thread, in which case it is cancelled, or loading on
+     * it, in which case it is closed there once it is done.
+     */
+    private fun closeWhenLoaded(key: Key, entry: Entry) {
+        val close = Runnable {
+            try {
+                entry.load.get().close()
+                Log.d(TAG, "Closed session for ${key.modelPath}")
+            } catch (e: Exception) {
+                // Never loaded; nothing to close.
+            }
+        }
+        if (entry.claimed.compareAndSet(false, true)) {
+            // Loading a model only to close it would add memory at the worst moment, e.g. in onTrimMemory.
+            entry.load.cancel(false)
+            Log.d(TAG, "Cancelled warm-up of ${key.modelPath}")
+        } else if (entry.load.isDone) {
+            close.run()
+        } else {
+            loader.execute(close)
+        }
+    }
+
+    private fun newEntry(context: Context, key: Key): Entry {
+        val claimed = AtomicBoolean(false)
+        return Entry(claimed, loadTask(context, key, claimed))
+    }
+
+    private fun loadTask(context: Context, key: Key, claimed: AtomicBoolean): FutureTask<OrtSession> {
+        return FutureTask {
+            if (!claimed.compareAndSet(false, true)) {
+                throw CancellationException("${key.modelPath} was evicted before it was loaded")
+            }
+            val start = System.nanoTime()
+            val modelFile = ModelStore.modelFile(context, key.modelPath)
+            val session = key.options.toSessionOptions().use { options ->
+                environment.createSession(modelFile.path, options)
+            }
+            Log.d(TAG, "Loaded ${key.modelPath} in ${(System.nanoTime() - start) / 1_000_000} ms")
+            session
+        }
+    }
+}
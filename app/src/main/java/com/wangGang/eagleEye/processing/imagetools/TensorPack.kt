@@ -0,0 +1,103 @@
+package com.wangGang.eagleEye.processing.imagetools
+
+import org.opencv.core.Core
+import org.opencv.core.Mat
+import org.opencv.core.Rect
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.FloatBuffer
+
+/**
+ * Native packing between OpenCV's interleaved (HWC) Mats and the planar NCHW float layout of the ONNX models, in
+ * one SIMD pass with the normalisation fused in. Tensors created from a buffer of allocate() use it without a
+ * copy, so a buffer can be packed again and the same tensor run for the next patch.
+ */
+object TensorPack {
+    init {
+        System.loadLibrary("eagleEye")
+    }
+
+    /*
+     * A direct, native order buffer of the given number of floats.
+     */
+    fun allocate(floats: Int): FloatBuffer {
+        return ByteBuffer.allocateDirect(floats * Float.SIZE_BYTES).order(ByteOrder.nativeOrder()).asFloatBuffer()
+    }
+
+    /*
+     * Packs region of src (8-bit or float, 1 to 4 channels) into dst from offset on, as
+     * (pixel * scale - mean[c]) / std[c]. A single mean or std value applies to every channel. The region may
+     * extend past src; that part is padded per borderType, with pixel value 0 for BORDER_CONSTANT.
+     */
+    fun pack(
+        src: Mat,
+        region: Rect,
+        dst: FloatBuffer,
+        offset: Int = 0,
+        scale: Double = 1.0 / 255.0,
+        mean: DoubleArray = doubleArrayOf(0.0),
+        std: DoubleArray = doubleArrayOf(1.0),
+        swapRB: Boolean = false,
+        borderType: Int = Core.BORDER_REFLECT
+    ) {
+        check(
+            packNative(
+                src.nativeObj, region.x, region.y, region.width, region.height, dst, offset, scale, mean, std,
+                swapRB, borderType
+            )
+        ) { "Packing ${src.cols()}x${src.rows()} type ${src.type()} into a tensor failed" }
+    }
+
+    /*
+     * Unpacks the dst sized region at (x, y) of planes that are planeWidth x planeHeight large into dst, usually an
+     * ROI of a larger Mat, as tensor * scale + bias clamped to [0, 1]. 8-bit dst is quantised to round(255 * value).
+     * Model outputs are usually not direct buffers; they are copied into one first.
+     */
+    fun unpack(
+        src: FloatBuffer,
+        planeWidth: Int,
+        planeHeight: Int,
+        x: Int,
+        y: Int,
+        dst: Mat,
+        offset: Int = 0,
+        scale: Double = 1.0,
+        bias: Double = 0.0,
+        clamp: Boolean = true,
+        swapRB: Boolean = false
+    ) {
+        val planes = if (src.isDirect) src else allocate(src.remaining()).also { it.put(src.duplicate()).rewind() }
+        check(
+            unpackNative(planes, offset, planeWidth, planeHeight, x, y, dst.nativeObj, scale, bias, clamp, swapRB)
+        ) { "Unpacking a tensor into ${dst.cols()}x${dst.rows()} type ${dst.type()} failed" }
+    }
+
+    private external fun packNative(
+        srcAddr: Long,
+        x: Int,
+        y: Int,
+        width: Int,
+        height: Int,
+        buffer: FloatBuffer,
+        offset: Int,
+        scale: Double,
+        mean: DoubleArray,
+        std: DoubleArray,
+        swapRB: Boolean,
+        borderType: Int
+    ): Boolean
+
+    private external fun unpackNative(
+        buffer: FloatBuffer,
+        offset: Int,
+        planeWidth: Int,
+        planeHeight: Int,
+        x: Int,
+        y: Int,
+        dstAddr: Long,
+        scale: Double,
+        bias: Double,
+        clamp: Boolean,
+        swapRB: Boolean
+    ): Boolean
+}
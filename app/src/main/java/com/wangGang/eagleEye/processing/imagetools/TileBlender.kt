@@ -0,0 +1,116 @@
+package com.wangGang.eagleEye.processing.imagetools
+
+import org.opencv.core.Mat
+import java.nio.FloatBuffer
+
+/**
+ * Feathered blending of overlapping model output patches, backed by a native float accumulator and weight plane.
+ * Each patch is weighted with a raised-cosine ramp over the halo pixels along its edges, so neighbouring patches
+ * fade into each other instead of meeting at a hard seam. That hides seams with a much smaller halo than copying
+ * only each patch's centre, so fewer and less padded patches have to go through the model.
+ *
+ * Lay the patches out with origins() and add them one at a time, in raster order, as they come out of the model.
+ * The accumulator only spans one patch height; finished rows go straight into the output Mat.
+ */
+class TileBlender : AutoCloseable {
+
+    companion object {
+        init {
+            System.loadLibrary("eagleEye")
+        }
+
+        /*
+         * Patch origins along an axis of the given length, the same layout as the native TileBlender::origins:
+         * the first at -halo, then every patchSize - halo pixels, the last moved back to end halo pixels past
+         * the image. Patches are padded by the halo at the image borders, where the ramps fall.
+         */
+        fun origins(length: Int, patchSize: Int, halo: Int): List<Int> {
+            val stride = patchSize - halo
+            require(length > 0 && stride > halo) { "No layout of $patchSize patches with halo $halo over $length" }
+            val last = maxOf(-halo, length + halo - patchSize)
+            return (-halo until last step stride) + last
+        }
+    }
+
+    private var nativeHandle: Long = nativeCreate()
+
+    init {
+        check(nativeHandle != 0L) { "Cannot create the native TileBlender" }
+    }
+    private var channels = 0
+    private var patchSize = 0
+
+    /*
+     * Starts blending patches of patchSize x patchSize, one plane per channel, into dst (allocated, 8-bit or
+     * float). Values are written as value * scale + bias, clamped to [0, 1] if clamp is set and quantised to
+     * round(255 * value) for 8-bit dst, as TensorPack.unpack does.
+     */
+    fun begin(
+        dst: Mat,
+        patchSize: Int,
+        halo: Int,
+        scale: Double = 1.0,
+        bias: Double = 0.0,
+        clamp: Boolean = true,
+        swapRB: Boolean = false
+    ) {
+        check(nativeHandle != 0L) { "TileBlender has been closed" }
+        check(nativeBegin(nativeHandle, dst.nativeObj, patchSize, halo, scale, bias, clamp, swapRB)) {
+            "Cannot blend $patchSize patches with halo $halo into ${dst.cols()}x${dst.rows()} type ${dst.type()}"
+        }
+        this.channels = dst.channels()
+        this.patchSize = patchSize
+    }
+
+    /*
+     * Adds the NCHW patch at offset of buffer (a direct buffer, as TiledInference's outputs are) with its
+     * top-left corner at (x, y) in the image.
+     */
+    fun add(buffer: FloatBuffer, offset: Int, x: Int, y: Int) {
+        check(nativeHandle != 0L) { "TileBlender has been closed" }
+        check(nativeAdd(nativeHandle, buffer, offset, channels, patchSize, x, y)) {
+            "Adding a patch at ($x, $y) failed"
+        }
+    }
+
+    /*
+     * Writes the remaining rows and releases the native accumulation buffers.
+     */
+    fun finish() {
+        check(nativeHandle != 0L) { "TileBlender has been closed" }
+        check(nativeFinish(nativeHandle)) { "Finishing the blended image failed" }
+    }
+
+    override fun close() {
+        if (nativeHandle != 0L) {
+            nativeRelease(nativeHandle)
+            nativeHandle = 0L
+        }
+    }
+
+    private external fun nativeCreate(): Long
+    private external fun nativeBegin(
+        handle: Long,
+        dstAddr: Long,
+        patchSize: Int,
+        halo: Int,
+        scale: Double,
+        bias: Double,
+        clamp: Boolean,
+        swapRB: Boolean
+    ): Boolean
+
+    private external fun nativeAdd(
+        handle: Long,
+        buffer: FloatBuffer,
+        offset: Int,
+        channels: Int,
+        patchSize: Int,
+        x: Int,
+        y: Int
+    ): Boolean
+
+    private external fun nativeFinish(handle: Long): Boolean
+
+    private external fun nativeRelease(handle: Long)
+}
@@ -0,0 +1,133 @@
+package com.wangGang.eagleEye.processing.imagetools
+
+import ai.onnxruntime.OnnxTensor
+import ai.onnxruntime.OrtSession
+import ai.onnxruntime.TensorInfo
+import android.util.Log
+import java.nio.FloatBuffer
+import java.util.concurrent.ExecutionException
+import java.util.concurrent.Executors
+import java.util.concurrent.Future
+
+/**
+ * Runs a fully convolutional model over an image tile by tile, as a three stage pipeline: while batch k is in
+ * inference on the calling thread, batch k + 1 is packed on one worker thread and batch k - 1 written back on
+ * another, so ONNX Runtime's intra-op threads are not left idle while the tiles are prepared.
+ *
+ * Tiles go through the model requestedBatchSize at a time when its batch dimension is dynamic (a model with a
+ * fixed batch dimension uses that). Input and output tensors wrap direct buffers, allocated once per pipeline slot
+ * and reused for every batch; the last batch is padded with its last tile.
+ *
+ * pack fills one tile of the input (inputChannels planes of patchSize x patchSize floats) at the given offset,
+ * write consumes one tile of the output the same way. write calls are made one at a time, in tile order.
+ */
+class TiledInference(
+    private val session: OrtSession,
+    private val inputChannels: Int,
+    private val outputChannels: Int,
+    private val patchSize: Int,
+    requestedBatchSize: Int = 1
+) {
+    companion object {
+        private const val TAG = "TiledInference"
+
+        // One batch being packed, one in inference and one being written back.
+        private const val SLOTS = 3
+
+        private val packer = Executors.newSingleThreadExecutor { runnable -> Thread(runnable, "tile-pack") }
+        private val writer = Executors.newSingleThreadExecutor { runnable -> Thread(runnable, "tile-write") }
+    }
+
+    val batchSize: Int =
+        (session.inputInfo.values.first().info as TensorInfo).shape[0].toInt().takeIf { it > 0 }
+            ?: requestedBatchSize.coerceAtLeast(1)
+
+    private val inputTile = inputChannels * patchSize * patchSize
+    private val outputTile = outputChannels * patchSize * patchSize
+
+    private inner class Slot : AutoCloseable {
+        val input: FloatBuffer = TensorPack.allocate(batchSize * inputTile)
+        val output: FloatBuffer = TensorPack.allocate(batchSize * outputTile)
+        private val inputTensor = OnnxTensor.createTensor(OnnxSessions.environment, input, shape(inputChannels))
+        private val outputTensor = OnnxTensor.createTensor(OnnxSessions.environment, output, shape(outputChannels))
+        private val inputs = mapOf(session.inputNames.first() to inputTensor)
+        private val pinnedOutputs = mapOf(session.outputNames.first() to outputTensor)
+
+        fun run() {
+            session.run(inputs, pinnedOutputs).close()
+        }
+
+        override fun close() {
+            inputTensor.close()
+            outputTensor.close()
+        }
+    }
+
+    private fun shape(channels: Int): LongArray {
+        return longArrayOf(batchSize.toLong(), channels.toLong(), patchSize.toLong(), patchSize.toLong())
+    }
+
+    fun <T> run(
+        tiles: List<T>,
+        pack: (tile: T, buffer: FloatBuffer, offset: Int) -> Unit,
+        write: (tile: T, buffer: FloatBuffer, offset: Int) -> Unit
+    ) {
+        if (tiles.isEmpty()) {
+            return
+        }
+        val batches = tiles.chunked(batchSize)
+        val slots = List(minOf(SLOTS, batches.size)) { Slot() }
+        val packs = arrayOfNulls<Future<*>>(slots.size)
+        val writes = arrayOfNulls<Future<*>>(slots.size)
+
+        fun submitPack(index: Int) {
+            val slot = slots[index % slots.size]
+            val batch = batches[index]
+            packs[index % slots.size] = packer.submit {
+                for (k in 0 until batchSize) {
+                    pack(batch[minOf(k, batch.size - 1)], slot.input, k * inputTile)
+                }
+            }
+        }
+
+        val start = System.nanoTime()
+        try {
+            submitPack(0)
+            for (index in batches.indices) {
+                val slot = slots[index % slots.size]
+                await(packs[index % slots.size])
+
+                // The next slot was last used by batch index + 1 - SLOTS, whose write back has to be done first.
+                if (index + 1 < batches.size) {
+                    await(writes[(index + 1) % slots.size])
+                    submitPack(index + 1)
+                }
+
+                slot.run()
+
+                val batch = batches[index]
+                writes[index % slots.size] = writer.submit {
+                    batch.forEachIndexed { k, tile -> write(tile, slot.output, k * outputTile) }
+                }
+                if ((index + 1) % 5 == 0 || index + 1 == batches.size) {
+                    Log.d(TAG, "Ran batch ${index + 1} of ${batches.size} (batch size $batchSize)")
+                }
+            }
+            writes.forEach { await(it) }
+            Log.d(TAG, "${tiles.size} tiles in ${(System.nanoTime() - start) / 1_000_000} ms")
+        } finally {
+            // On failure the workers may still use the slots; they are closed once nothing is queued any more.
+            packs.forEach { it?.let { future -> runCatching { future.get() } } }
+            writes.forEach { it?.let { future -> runCatching { future.get() } } }
+            slots.forEach { it.close() }
+        }
+    }
+
+    private fun await(future: Future<*>?) {
+        try {
+            future?.get()
+        } catch (e: ExecutionException) {
+            throw e.cause ?: e
+        }
+    }
+}
@@ -22,7 +22,8 @@ class LRWarpingOperator(
     private val imagesToWarpList: Array<String>,
     private val resultNames: Array<String>,
     private val goodMatchList: Array<MatOfDMatch?>, // Nullable Array of MatOfDMatch
-    private val keyPointList: Array<MatOfKeyPoint?> // Nullable Array of MatOfKeyPoint
+    private val keyPointList: Array<MatOfKeyPoint?>, // Nullable Array of MatOfKeyPoint
+    private val homographyList: Array<Mat?>? = null // Precomputed by FeatureMatchingOperator, if available
 ) {
     private val warpedMatList: Array<Mat?> = arrayOfNulls(imagesToWarpList.size)
 
@@ -30,7 +31,12 @@ class LRWarpingOperator(
     fun perform() {
         for (i in imagesToWarpList.indices) {
             val candidateMat = FileImageReader.getInstance()!!.imReadFullPath(imagesToWarpList[i])
-            val warpedMat = warpImage(goodMatchList[i], keyPointList[i], candidateMat)
+            val homography = homographyList?.getOrNull(i)
+            val warpedMat = if (homography != null && homography.rows() == 3 && homography.cols() == 3) {
+                performPerspectiveWarping(candidateMat, homography)
+            } else {
+                warpImage(goodMatchList[i], keyPointList[i], candidateMat)
+            }
             FileImageWriter.getInstance()!!.saveMatrixToImage(
                 warpedMat,
                 resultNames[i],
@@ -50,6 +56,8 @@ class LRWarpingOperator(
 
         goodMatchList.fill(null)
         keyPointList.fill(null)
+        homographyList?.forEach { it?.release() }
+        homographyList?.fill(null)
     }
 
     fun getWarpedMatList(): Array<Mat?> = warpedMatList
@@ -27,6 +27,9 @@ class WarpResultEvaluator(
         arrayOfNulls(warpedMatNames.size) //output the chosen aligned names for mean fusion here
 
     fun perform() {
+        if (performNative()) {
+            return
+        }
         referenceMat.convertTo(
             this.referenceMat, CvType.CV_16UC(
                 referenceMat.channels()
@@ -52,6 +55,48 @@ class WarpResultEvaluator(
         )
     }
 
+    /*
+     * Scores all candidates concurrently in native code, on the pyramid level set by WARP_EVALUATION_LEVEL_KEY
+     * (0, full resolution, unless reduced-resolution scoring has been opted into).
+     * Returns false if the native evaluator failed, in which case nothing has been chosen yet.
+     */
+    private fun performNative(): Boolean {
+        val fileImageReader = FileImageReader.getInstance() ?: return false
+        val warpedPaths = Array(warpedMatNames.size) {
+            fileImageReader.getDecodedFilePath(warpedMatNames[it], ImageFileAttribute.FileType.JPEG)
+        }
+        val medianPaths = Array(medianAlignedNames.size) {
+            fileImageReader.getDecodedFilePath(medianAlignedNames[it], ImageFileAttribute.FileType.JPEG)
+        }
+        val pyramidLevel = ParameterConfig.getPrefsInt(ParameterConfig.WARP_EVALUATION_LEVEL_KEY, 0)
+        val warpedScores = IntArray(warpedMatNames.size)
+        val medianScores = IntArray(medianAlignedNames.size)
+        val choices = IntArray(warpedMatNames.size)
+        if (!evaluateNative(referenceMat.nativeObj, warpedPaths, medianPaths, pyramidLevel, warpedScores,
+                medianScores, choices)) {
+            Log.w(TAG, "Native warp evaluation failed, scoring the candidates one by one.")
+            return false
+        }
+
+        referenceMat.release()
+        for (i in chosenAlignedNames.indices) {
+            chosenAlignedNames[i] = if (choices[i] == 0) warpedMatNames[i] else medianAlignedNames[i]
+            Log.d(TAG, "Chosen image name: " + chosenAlignedNames[i] + " (warped " + warpedScores[i] +
+                    ", median " + medianScores[i] + ")")
+        }
+        return true
+    }
+
+    private external fun evaluateNative(
+        referenceMatAddr: Long,
+        warpedPaths: Array<String>,
+        medianPaths: Array<String>,
+        pyramidLevel: Int,
+        warpedScores: IntArray,
+        medianScores: IntArray,
+        choices: IntArray
+    ): Boolean
+
     private fun measureDifference(
         referenceMat: Mat,
         referenceSobelMeasure: Int,
@@ -125,6 +170,10 @@ class WarpResultEvaluator(
         private const val TAG = "WarpResultEvaluator"
         private const val MAX_THRESHOLD = 200000
 
+        init {
+            System.loadLibrary("eagleEye")
+        }
+
         private fun assessWarpedImages(
             referenceSobelMeasure: Int,
             warpedResults: IntArray,
@@ -1,4 +1,5 @@
 package com.wangGang.eagleEye.processing.multiple.enhancement
+import android.util.Log
 import com.wangGang.eagleEye.io.DirectoryStorage
 import com.wangGang.eagleEye.io.FileImageWriter
 import com.wangGang.eagleEye.io.ImageFileAttribute
@@ -8,26 +9,58 @@ import org.opencv.core.Mat
 import org.opencv.core.Size
 import org.opencv.imgproc.Imgproc
 
+/**
+ * Sharpens a frame with a 25x25 box-blur unsharp mask (2.25 * input - 1.25 * blur). 8-bit frames go through
+ * a native running-sum kernel that never stores the blurred image. The result stays in memory; saveToFile()
+ * writes it as sharpen_i for the stages that still work on files.
+ */
 class UnsharpMaskOperator(private val inputMat: Mat, private val index: Int)  {
-    private lateinit var outputMat: Mat
+    companion object {
+        private const val TAG = "UnsharpMaskOperator"
+
+        init {
+            System.loadLibrary("eagleEye")
+        }
+
+        /*
+         * Writes a sharpened frame as sharpen_index and returns its path.
+         */
+        fun saveToFile(mat: Mat, index: Int): String? {
+            return FileImageWriter.getInstance()?.debugSaveMatrixToImageReturnFilePath(mat,
+                DirectoryStorage.SR_ALBUM_NAME_PREFIX,
+                "sharpen_$index", ImageFileAttribute.FileType.JPEG)
+        }
+    }
+
+    private var outputMat: Mat = Mat()
     private var filePath: String? = null
 
     fun perform() {
-        val blurMat = Mat()
-        this.outputMat = Mat()
-        Imgproc.blur(this.inputMat, blurMat, Size(25.0, 25.0))
+        if (!unsharpMaskNative(this.inputMat.nativeObj, this.outputMat.nativeObj)) {
+            Log.w(TAG, "Native unsharp mask failed, using OpenCV.")
+            val blurMat = Mat()
+            Imgproc.blur(this.inputMat, blurMat, Size(25.0, 25.0))
+            Core.addWeighted(this.inputMat, 2.25, blurMat, -1.25, 0.0, this.outputMat, CvType.CV_8UC(this.inputMat.channels()))
+            blurMat.release()
+        }
+        this.inputMat.release()
+    }
 
-        Core.addWeighted(this.inputMat, 2.25, blurMat, -1.25, 0.0, this.outputMat, CvType.CV_8UC(this.inputMat.channels()))
-        filePath = FileImageWriter.getInstance()?.debugSaveMatrixToImageReturnFilePath(this.outputMat,
-            DirectoryStorage.SR_ALBUM_NAME_PREFIX,
-            "sharpen_$index", ImageFileAttribute.FileType.JPEG)
+    /*
+     * The sharpened frame. The caller owns it and has to release it.
+     */
+    fun getOutputMat(): Mat {
+        return this.outputMat
+    }
 
-        blurMat.release()
-        this.inputMat.release()
-        this.outputMat.release()
+    fun saveToFile(): String? {
+        filePath = saveToFile(this.outputMat, index)
+        return filePath
     }
 
     fun getFilePath(): String? {
         return this.filePath
     }
-}
\ No newline at end of file
+
+    private external fun unsharpMaskNative(srcMatAddr: Long, dstMatAddr: Long): Boolean
+}
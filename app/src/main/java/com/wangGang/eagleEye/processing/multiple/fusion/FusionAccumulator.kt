@@ -0,0 +1,60 @@
+package com.wangGang.eagleEye.processing.multiple.fusion
+
+import org.opencv.core.Mat
+
+/**
+ * Streaming masked mean fusion backed by a native 16-bit sum buffer and a per-pixel count buffer.
+ * Frames are folded in one at a time as soon as they are available, so no intermediate quadrant files are needed.
+ * Black pixels (holes left by warping) are excluded from the mean.
+ */
+class FusionAccumulator : AutoCloseable {
+
+    companion object {
+        init {
+            System.loadLibrary("eagleEye")
+        }
+    }
+
+    private var nativeHandle: Long = nativeCreate()
+
+    /*
+     * Starts a new fusion for frames of width x height. The fused output is scaled by the given factor.
+     */
+    fun begin(width: Int, height: Int, scale: Float, channels: Int = 3) {
+        check(nativeHandle != 0L) { "FusionAccumulator has been closed" }
+        check(nativeBegin(nativeHandle, width, height, scale, channels)) {
+            "Cannot allocate the accumulator for $width x $height x $channels"
+        }
+    }
+
+    /*
+     * Adds an 8-bit frame. Returns false if its size or channel count does not match begin().
+     */
+    fun add(frame: Mat): Boolean {
+        check(nativeHandle != 0L) { "FusionAccumulator has been closed" }
+        return nativeAdd(nativeHandle, frame.nativeObj)
+    }
+
+    /*
+     * Returns the fused 8-bit image and releases the native accumulation buffers.
+     */
+    fun finish(): Mat {
+        check(nativeHandle != 0L) { "FusionAccumulator has been closed" }
+        val fused = nativeFinish(nativeHandle)
+        check(!fused.empty()) { "Finishing the fused image failed" }
+        return fused
+    }
+
+    override fun close() {
+        if (nativeHandle != 0L) {
+            nativeRelease(nativeHandle)
+            nativeHandle = 0L
+        }
+    }
+
+    private external fun nativeCreate(): Long
+    private external fun nativeBegin(handle: Long, width: Int, height: Int, scale: Float, channels: Int): Boolean
+    private external fun nativeAdd(handle: Long, frameMatAddr: Long): Boolean
+    private external fun nativeFinish(handle: Long): Mat
+    private external fun nativeRelease(handle: Long)
+}
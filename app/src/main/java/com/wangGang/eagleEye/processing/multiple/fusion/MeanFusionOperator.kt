@@ -117,57 +117,37 @@ class MeanFusionOperator(
 ////        sumMat.release()
 //    }
 
+    /*
+     * Folds the initial mat and every aligned image into a native accumulator one frame at a time,
+     * so at most one frame plus the accumulator is held in memory and no quadrant files are written.
+     */
     private fun performAlternateFusion(): Bitmap {
-        outputMat = Mat()
-        initialMat.convertTo(initialMat, CvType.CV_16UC(initialMat.channels())) // Convert to CV_16UC
-        var quadrantWidth = initialMat.width() / 4
-        var quadrantHeight = initialMat.height() / 4
-        var fileList = mutableListOf<Array<String>>()
-        fileList.add(ImageOperator.performJNIInterpolation(initialMat, 1))
-        initialMat.release()
         outputMat?.release()
-
-        for (imagePath in imageMatPathList) {
-            // Load the next Mat
-            initialMat = FileImageReader.getInstance()?.imReadOpenCV(imagePath, ImageFileAttribute.FileType.JPEG)
-                ?: throw IllegalStateException("Failed to read image: $imagePath")
-            // Delete file as it is no longer needed
-            FileImageWriter.getInstance()?.deleteImage(imagePath, ImageFileAttribute.FileType.JPEG)
-            fileList.add(ImageOperator.performJNIInterpolation(initialMat,fileList.size +1))
+        return FusionAccumulator().use { accumulator ->
+            accumulator.begin(initialMat.cols(), initialMat.rows(), 1.0f, initialMat.channels())
+            accumulator.add(initialMat)
             initialMat.release()
-            MatMemory.cleanMemory()
-        }
-        val fileList2D: Array<Array<String>> = fileList.map{it}.toTypedArray()
-        val rowCount = fileList2D.size         // Number of rows in the original array
-        val colCount = fileList2D[0].size      // Number of columns in the original array
 
-        val fileList2dTransposed = Array(colCount) { Array(rowCount) { "" } }
-
-        for (i in 0 until rowCount) {
-            for (j in 0 until colCount) {
-                fileList2dTransposed[j][i] = fileList2D[i][j]
+            for (imagePath in imageMatPathList) {
+                // Load the next Mat
+                initialMat = FileImageReader.getInstance()?.imReadOpenCV(imagePath, ImageFileAttribute.FileType.JPEG)
+                    ?: throw IllegalStateException("Failed to read image: $imagePath")
+                // Delete file as it is no longer needed
+                FileImageWriter.getInstance()?.deleteImage(imagePath, ImageFileAttribute.FileType.JPEG)
+                if (!accumulator.add(initialMat)) {
+                    Log.e(TAG, "Skipping $imagePath. Size ${initialMat.size()} does not match the reference.")
+                }
+                initialMat.release()
             }
-        }
-        var divisionFactor  = 4;
-        // initialize filenames
-        val initQuadrantFilenames = Array(divisionFactor * divisionFactor) { index ->
-            "/quadrant${index + 1}"
-        }
-        val quadrantsNames = FileImageWriter.getInstance()?.getPath(initQuadrantFilenames, ImageFileAttribute.FileType.JPEG)!!
-        for (each in quadrantsNames){
-            Log.d(TAG, "Quadrant name: $each")
-        }
 
-        val newMat = meanFuse(fileList2dTransposed, quadrantsNames, divisionFactor, quadrantWidth, quadrantHeight)
-        Core.rotate(newMat, newMat, Core.ROTATE_90_COUNTERCLOCKWISE)
-        Imgproc.cvtColor(newMat, newMat, Imgproc.COLOR_BGR2RGB)
-        val bitmap = Bitmap.createBitmap(newMat.cols(), newMat.rows(), Bitmap.Config.ARGB_8888)
-        Utils.matToBitmap(newMat, bitmap)
-        return bitmap
-//        Core.divide(sumMat, Scalar.all(imageMatPathList.size + 1.0), sumMat)
-//        sumMat.convertTo(outputMat, CvType.CV_8UC(sumMat.channels()))
-//        sumMat.release()
+            val newMat = accumulator.finish()
+            Core.rotate(newMat, newMat, Core.ROTATE_90_COUNTERCLOCKWISE)
+            Imgproc.cvtColor(newMat, newMat, Imgproc.COLOR_BGR2RGB)
+            val bitmap = Bitmap.createBitmap(newMat.cols(), newMat.rows(), Bitmap.Config.ARGB_8888)
+            Utils.matToBitmap(newMat, bitmap)
+            newMat.release()
+            bitmap
+        }
     }
 
-
 }
@@ -0,0 +1,64 @@
+package com.wangGang.eagleEye.processing.multiple.fusion
+
+import android.graphics.Bitmap
+import com.wangGang.eagleEye.processing.imagetools.ImageOperator
+import org.opencv.core.Mat
+
+/**
+ * Multi-frame shift-and-add super-resolution in native code. The LR samples of every frame are placed on the HR
+ * grid at their sub-pixel position in the reference, given either by one homography per frame or by per-pixel
+ * displacement maps, and holes are filled by normalized convolution. The frames are in-memory Mats (the
+ * unsharp-masked burst, reference first); they are released once reconstructed.
+ */
+class ShiftAddOperator private constructor(
+    private val frames: Array<Mat>,
+    private val homographyList: Array<Mat?>?,
+    private val xDisplacements: Array<Mat>?,
+    private val yDisplacements: Array<Mat>?,
+    private val scale: Int
+) {
+    constructor(frames: Array<Mat>, homographyList: Array<Mat?>, scale: Int) :
+            this(frames, homographyList, null, null, scale)
+
+    constructor(frames: Array<Mat>, xDisplacements: Array<Mat>, yDisplacements: Array<Mat>, scale: Int) :
+            this(frames, null, xDisplacements, yDisplacements, scale)
+
+    companion object {
+        init {
+            System.loadLibrary("eagleEye")
+        }
+    }
+
+    fun perform(): Bitmap {
+        val frameAddrs = LongArray(frames.size) { frames[it].nativeObj }
+        val hrMat = if (homographyList != null) {
+            val homographies = Array(frames.size) { homographyList.getOrNull(it) ?: Mat() }
+            val result = shiftAddNative(frameAddrs, LongArray(frames.size) { homographies[it].nativeObj }, scale)
+            homographies.forEach { it.release() }
+            homographyList.fill(null)
+            result
+        } else {
+            shiftAddDisplacedNative(
+                frameAddrs,
+                LongArray(frames.size) { xDisplacements!![it].nativeObj },
+                LongArray(frames.size) { yDisplacements!![it].nativeObj },
+                scale
+            )
+        }
+        frames.forEach { it.release() }
+        check(!hrMat.empty()) { "Native shift-and-add reconstruction failed" }
+
+        val bitmap = ImageOperator.matToBitmap(hrMat)
+        hrMat.release()
+        return bitmap
+    }
+
+    private external fun shiftAddNative(frameAddrs: LongArray, homographyAddrs: LongArray, scale: Int): Mat
+
+    private external fun shiftAddDisplacedNative(
+        frameAddrs: LongArray,
+        xDisplacementAddrs: LongArray,
+        yDisplacementAddrs: LongArray,
+        scale: Int
+    ): Mat
+}
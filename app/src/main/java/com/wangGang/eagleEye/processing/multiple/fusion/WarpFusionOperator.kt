@@ -0,0 +1,45 @@
+package com.wangGang.eagleEye.processing.multiple.fusion
+
+import android.graphics.Bitmap
+import com.wangGang.eagleEye.processing.imagetools.ImageOperator
+import org.opencv.core.Mat
+
+/**
+ * Perspective warping and mean fusion in one native pass. Every candidate frame is warped onto the reference
+ * tile by tile with its homography and folded straight into the mean, so no warp_i images are written or
+ * read back. The frames are in-memory Mats (the unsharp-masked burst); they are released once fused.
+ */
+class WarpFusionOperator(
+    private val referenceMat: Mat,
+    private val frames: Array<Mat>,
+    private val homographyList: Array<Mat?>
+) {
+    companion object {
+        init {
+            System.loadLibrary("eagleEye")
+        }
+    }
+
+    fun perform(): Bitmap {
+        val homographies = Array(frames.size) { homographyList.getOrNull(it) ?: Mat() }
+        val fusedMat = warpFuseNative(
+            referenceMat.nativeObj,
+            LongArray(frames.size) { frames[it].nativeObj },
+            LongArray(frames.size) { homographies[it].nativeObj }
+        )
+        referenceMat.release()
+        frames.forEach { it.release() }
+        homographies.forEach { it.release() }
+        homographyList.fill(null)
+        check(!fusedMat.empty()) { "Native warp fusion failed" }
+        val bitmap = ImageOperator.matToBitmap(fusedMat)
+        fusedMat.release()
+        return bitmap
+    }
+
+    private external fun warpFuseNative(
+        referenceMatAddr: Long,
+        frameAddrs: LongArray,
+        homographyAddrs: LongArray
+    ): Mat
+}
@@ -2,6 +2,7 @@ package com.wangGang.eagleEye.ui.activities
 
 import android.animation.ObjectAnimator
 import android.animation.ValueAnimator
+import android.content.ComponentCallbacks2
 import android.content.Context
 import android.content.Intent
 import android.graphics.BitmapFactory
@@ -41,6 +42,8 @@ import com.wangGang.eagleEye.processing.commands.Dehaze
 import com.wangGang.eagleEye.processing.commands.Denoising
 import com.wangGang.eagleEye.processing.commands.ShadowRemoval
 import com.wangGang.eagleEye.processing.commands.SuperResolution
+import com.wangGang.eagleEye.processing.imagetools.MatPool
+import com.wangGang.eagleEye.processing.imagetools.OnnxSessions
 import com.wangGang.gallery.getLatestImageUri
 import android.view.ScaleGestureDetector
 import android.os.CountDownTimer
@@ -147,6 +150,7 @@ class CameraControllerActivity : AppCompatActivity(), OnImageSavedListener {
         updateFlashButtonIcon()
         updateTimerButtonIcon()
         updateGridButtonIcon()
+        warmUpModels()
 
         if (textureView.isAvailable) {
             CameraController.getInstance().setPreview(textureView)
@@ -175,6 +179,20 @@ class CameraControllerActivity : AppCompatActivity(), OnImageSavedListener {
         CameraController.getInstance().closeCamera()
     }
 
+    override fun onTrimMemory(level: Int) {
+        super.onTrimMemory(level)
+        // UI_HIDDEN (20) sorts above RUNNING_LOW (10) but only means the app left the screen, so it is skipped:
+        // evict while running low or critical, and once the process is in the background LRU list.
+        val underPressure = level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW ||
+                level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL ||
+                level >= ComponentCallbacks2.TRIM_MEMORY_BACKGROUND
+        if (underPressure) {
+            Log.d("CameraControllerActivity", "onTrimMemory($level): closing ONNX sessions, freeing pooled Mats")
+            OnnxSessions.evict()
+            MatPool.trim()
+        }
+    }
+
     override fun onDestroy() {
         super.onDestroy()
         Log.d("CameraControllerActivity", "onDestroy")
@@ -400,14 +418,25 @@ class CameraControllerActivity : AppCompatActivity(), OnImageSavedListener {
         btnTimer10s = findViewById(R.id.btn_timer_10s)
     }
 
-    private fun setBackground() {
-        val orderedNames = ParameterConfig.getProcessingOrder()
-
+    private fun enabledCommandNames(): Set<String> {
         val enabledSet = mutableSetOf<String>()
         if (ParameterConfig.isSuperResolutionEnabled()) enabledSet.add(SuperResolution.displayName)
         if (ParameterConfig.isDehazeEnabled()) enabledSet.add(Dehaze.displayName)
         if (ParameterConfig.isShadowRemovalEnabled()) enabledSet.add(ShadowRemoval.displayName)
         if (ParameterConfig.isDenoisingEnabled()) enabledSet.add(Denoising.displayName)
+        return enabledSet
+    }
+
+    // Loads the models of the enabled commands in the background, so the first capture does not wait for them.
+    private fun warmUpModels() {
+        val enabledSet = enabledCommandNames()
+        OnnxSessions.warmUp(this, ParameterConfig.getProcessingOrder().filter { it in enabledSet })
+    }
+
+    private fun setBackground() {
+        val orderedNames = ParameterConfig.getProcessingOrder()
+
+        val enabledSet = enabledCommandNames()
 
         val activeImageEnhancementTechniques = mutableListOf<ImageEnhancementType>()
 
@@ -40,6 +40,14 @@ class SettingsActivity : AppCompatActivity() {
         private lateinit var commandItems: ArrayList<Pair<Long, String>>
 
         private val SCALING_FACTORS = listOf(1, 2, 4, 8, 16)
+
+        // ParameterConfig.WARP_CHOICE_KEY values, in spinner order
+        private val WARP_CHOICES = listOf(
+            1 to "Best Alignment",
+            2 to "Median Alignment",
+            3 to "Perspective Warping",
+            4 to "Shift-and-Add Super-Resolution"
+        )
     }
 
     // Views
@@ -61,6 +69,7 @@ class SettingsActivity : AppCompatActivity() {
     private lateinit var whiteBalanceLabel: TextView
     private lateinit var exposureSeekBar: SeekBar
     private lateinit var exposureLabel: TextView
+    private lateinit var warpChoiceSpinner: Spinner
 
     /* === RecyclerViews === */
     private lateinit var commandListRecyclerView: RecyclerView
@@ -96,6 +105,7 @@ class SettingsActivity : AppCompatActivity() {
         setupTimerSeekBar()
         setupWhiteBalanceSpinner()
         setupExposureSeekBar()
+        setupWarpChoiceSpinner()
         setupCommandListRecyclerView()
         setupProcessingOrderListView()
 
@@ -118,6 +128,7 @@ class SettingsActivity : AppCompatActivity() {
         whiteBalanceLabel = binding.whiteBalanceLabel
         exposureSeekBar = binding.exposureSeekbar
         exposureLabel = binding.exposureLabel
+        warpChoiceSpinner = binding.warpChoiceSpinner
         commandListRecyclerView = binding.sourceListView
         processingOrderDragListView = binding.targetListView
     }
@@ -256,6 +267,27 @@ class SettingsActivity : AppCompatActivity() {
         }
     }
 
+    private fun setupWarpChoiceSpinner() {
+        val adapter = ArrayAdapter(this, android.R.layout.simple_spinner_item, WARP_CHOICES.map { it.second })
+        adapter.setDropDownViewResource(android.R.layout.simple_spinner_dropdown_item)
+        warpChoiceSpinner.adapter = adapter
+
+        val currentIndex = WARP_CHOICES.indexOfFirst { it.first == ParameterConfig.getWarpChoice() }
+        if (currentIndex != -1) {
+            warpChoiceSpinner.setSelection(currentIndex)
+        }
+
+        warpChoiceSpinner.onItemSelectedListener = object : AdapterView.OnItemSelectedListener {
+            override fun onItemSelected(parent: AdapterView<*>?, view: View?, position: Int, id: Long) {
+                ParameterConfig.setWarpChoice(WARP_CHOICES[position].first)
+            }
+
+            override fun onNothingSelected(parent: AdapterView<*>?) {
+                // Do nothing
+            }
+        }
+    }
+
     private fun setupExposureSeekBar() {
         val cameraController = CameraController.getInstance()
         val characteristics = cameraController.getCameraCharacteristics()
@@ -520,6 +552,7 @@ class SettingsActivity : AppCompatActivity() {
         setupTimerSeekBar()
         setupWhiteBalanceSpinner()
         setupExposureSeekBar()
+        setupWarpChoiceSpinner()
         setupProcessingOrderListView()
     }
 
@@ -6,6 +6,7 @@ import androidx.lifecycle.MutableLiveData
 import com.wangGang.eagleEye.constants.ParameterConfig
 import com.wangGang.eagleEye.processing.commands.ProcessingCommand
 import com.wangGang.eagleEye.ui.viewmodels.CameraViewModel
+import com.wangGang.eagleEye.utils.NativeTrace
 
 class ProgressManager private constructor(private val viewModel: CameraViewModel) {
     val TAG = "ProgressManager"
@@ -59,11 +60,13 @@ class ProgressManager private constructor(private val viewModel: CameraViewModel
         Log.d(TAG, "showFirstTask()")
         if (taskList.isNotEmpty()) {
             viewModel.updateLoadingText(taskList[0])
+            NativeTrace.beginTask(taskList[0])
         }
     }
 
     fun nextTask() {
         incrementProgress()
+        traceTask()
         debugPrint()
         showLoadingText()
         onAllTasksCompleted()
@@ -91,6 +94,15 @@ class ProgressManager private constructor(private val viewModel: CameraViewModel
         }
     }
 
+    // Task spans in the native trace follow the progress, see NativeTrace.
+    private fun traceTask() {
+        if (completedTasks in taskList.indices) {
+            NativeTrace.beginTask(taskList[completedTasks])
+        } else {
+            NativeTrace.endTask()
+        }
+    }
+
     private fun showLoadingText() {
         val ind = completedTasks
         if (ind in taskList.indices) {
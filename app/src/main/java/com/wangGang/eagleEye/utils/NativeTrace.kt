@@ -0,0 +1,45 @@
+package com.wangGang.eagleEye.utils
+
+import android.util.Log
+import com.wangGang.eagleEye.io.DirectoryStorage
+import java.io.File
+
+/**
+ * Per-capture trace of the native stages (scoped timers and I/O / allocation counters) plus the ProgressManager
+ * tasks as spans, written as Chrome trace-event JSON. Open the files in chrome://tracing or ui.perfetto.dev.
+ */
+object NativeTrace {
+    init {
+        System.loadLibrary("eagleEye")
+    }
+    private const val TAG = "NativeTrace"
+
+    external fun beginCapture()
+
+    /*
+     * Writes the capture to outputPath and stops recording. Returns false if there was no capture or the file
+     * could not be written.
+     */
+    external fun endCapture(outputPath: String): Boolean
+
+    /*
+     * Ends the current task span and starts a new one.
+     */
+    external fun beginTask(name: String)
+
+    external fun endTask()
+
+    /*
+     * Ends the capture and writes it to trace_<timestamp>.json in the Traces directory next to Results.
+     */
+    fun endCaptureToTraceDir() {
+        val directory = File(DirectoryStorage.getSharedInstance().getTraceFilePath())
+        directory.mkdirs()
+        val file = File(directory, "trace_${System.currentTimeMillis()}.json")
+        if (endCapture(file.absolutePath)) {
+            Log.i(TAG, "Trace written to ${file.absolutePath}")
+        } else {
+            Log.w(TAG, "Could not write trace to ${file.absolutePath}")
+        }
+    }
+}